@@ -263,14 +263,11 @@ struct elf_accessors *get_elf_accessors(unsigned long addr)
  * First looks at the ELF header magic field, the makes sure that it is
  * executable and makes sure that it is for a PowerPC.
  * ====================================================================== */
-int valid_elf_image (unsigned long addr)
+static int valid_elf_ehdr (Elf32_Ehdr *ehdr, unsigned long addr)
 {
-	Elf32_Ehdr *ehdr;	/* Elf header structure pointer */
 	struct elf_accessors *a;
 	/* -------------------------------------------------- */
 
-	ehdr = (Elf32_Ehdr *) cvmx_phys_to_ptr (addr);
-
 	if (!IS_ELF (*ehdr)) {
 		printf ("## No elf image at address 0x%08lx\n", addr);
 		return 0;
@@ -282,7 +279,7 @@ int valid_elf_image (unsigned long addr)
 		return 0;
 	}
 
-	a = get_elf_accessors(addr);
+	a = get_elf_accessors((unsigned long)ehdr);
 
 	if (a->w16(ehdr->e_type) != ET_EXEC) {
 		printf("## Not an EXEC elf image at address 0x%08lx\n", addr);
@@ -298,6 +295,11 @@ int valid_elf_image (unsigned long addr)
 	return 1;
 }
 
+int valid_elf_image (unsigned long addr)
+{
+	return valid_elf_ehdr ((Elf32_Ehdr *) cvmx_phys_to_ptr (addr), addr);
+}
+
 /* ======================================================================
  * A very simple elf loader, assumes the image is valid, returns the
  * entry point address.
@@ -507,6 +509,155 @@ u64 load_elf64_image (unsigned long addr, uint64_t load_override)
 	return ehdr->e_entry;
 }
 
+#if defined(CONFIG_GZIP) || defined(CONFIG_LZMA)
+/* ======================================================================
+ * Streaming ELF64 loader.  The decompressor hands the image over in
+ * windows through the sink callbacks below, and each window is copied
+ * straight into the PT_LOAD segments it overlaps, so the uncompressed
+ * image is never staged in memory as a whole.
+ *
+ * Loading takes two passes over the compressed image.  The first pass
+ * (elf64_stream_hdr_sink) only collects the ELF and program headers so
+ * the caller can validate them and allocate the segments; the second
+ * pass (elf64_stream_load_sink) places the data.  elf64_stream_finish()
+ * then clears the bss, byte-swaps little-endian images and flushes the
+ * caches, the same as load_elf64_image().
+ * ====================================================================== */
+int elf64_stream_hdr_sink (void *priv, const void *buf, unsigned long len)
+{
+	struct elf64_stream *es = priv;
+	unsigned long n = sizeof (es->hdr) - es->hdr_len;
+
+	if (n > len)
+		n = len;
+
+	memcpy (es->hdr + es->hdr_len, buf, n);
+	es->hdr_len += n;
+
+	/* Stop the decompressor once the header buffer is full */
+	return es->hdr_len == sizeof (es->hdr);
+}
+
+int elf64_stream_valid (struct elf64_stream *es, unsigned long addr)
+{
+	Elf64_Ehdr *ehdr = (Elf64_Ehdr *) es->hdr;
+	struct elf_accessors *a;
+
+	if (es->hdr_len < sizeof (Elf64_Ehdr) ||
+	    !valid_elf_ehdr ((Elf32_Ehdr *) es->hdr, addr))
+		return 0;
+
+	if (ehdr->e_ident[EI_CLASS] != ELFCLASS64) {
+		printf ("## Compressed 32-bit elf images are not supported\n");
+		return 0;
+	}
+
+	a = get_elf_accessors((unsigned long)es->hdr);
+	if (!a->w16(ehdr->e_phnum) ||
+	    a->w64(ehdr->e_phoff) + a->w16(ehdr->e_phnum) *
+	    a->w16(ehdr->e_phentsize) > es->hdr_len) {
+		printf ("## Program headers not within the first %d bytes "
+			"of the elf image\n", ELF64_STREAM_HDR_SIZE);
+		return 0;
+	}
+
+	return 1;
+}
+
+static Elf64_Phdr *elf64_stream_phdr (struct elf64_stream *es, int i)
+{
+	struct elf_accessors *a = get_elf_accessors((unsigned long)es->hdr);
+	Elf64_Ehdr *ehdr = (Elf64_Ehdr *) es->hdr;
+
+	return (Elf64_Phdr *) (es->hdr + a->w64(ehdr->e_phoff) +
+			       i * a->w16(ehdr->e_phentsize));
+}
+
+int elf64_stream_load_sink (void *priv, const void *buf, unsigned long len)
+{
+	struct elf64_stream *es = priv;
+	struct elf_accessors *a = get_elf_accessors((unsigned long)es->hdr);
+	Elf64_Ehdr *ehdr = (Elf64_Ehdr *) es->hdr;
+	uint64_t start = es->pos;
+	uint64_t end = es->pos + len;
+	int i;
+
+	for (i = 0; i < a->w16(ehdr->e_phnum); i++) {
+		Elf64_Phdr *phdr = elf64_stream_phdr (es, i);
+		uint64_t offset = a->w64(phdr->p_offset);
+		uint64_t filesz = a->w64(phdr->p_filesz);
+		uint64_t paddr = es->load_override ? es->load_override :
+						     a->w64(phdr->p_paddr);
+		uint64_t lo, hi;
+
+		if (a->w32(phdr->p_type) != PT_LOAD || !filesz)
+			continue;
+		lo = max (start, offset);
+		hi = min (end, offset + filesz);
+		if (lo >= hi)
+			continue;
+		memcpy64 (octeon_fixup_xkphys (paddr) + (lo - offset),
+			  (int32_t) ((const unsigned char *)buf + (lo - start)),
+			  hi - lo);
+	}
+	es->pos = end;
+
+	return 0;
+}
+
+u64 elf64_stream_finish (struct elf64_stream *es)
+{
+	struct elf_accessors *a = get_elf_accessors((unsigned long)es->hdr);
+	Elf64_Ehdr *ehdr = (Elf64_Ehdr *) es->hdr;
+	int i;
+
+	for (i = 0; i < a->w16(ehdr->e_phnum); i++) {
+		Elf64_Phdr *phdr = elf64_stream_phdr (es, i);
+		uint64_t offset = a->w64(phdr->p_offset);
+		uint64_t filesz = a->w64(phdr->p_filesz);
+		uint64_t memsz = a->w64(phdr->p_memsz);
+		uint64_t paddr = es->load_override ? es->load_override :
+						     a->w64(phdr->p_paddr);
+
+		if (a->w32(phdr->p_type) != PT_LOAD)
+			continue;
+		if (offset + filesz > es->pos) {
+			printf ("## Elf image truncated in segment %d\n", i);
+			return 0;
+		}
+		debug ("  Loaded 0x%llx bytes at %llx\n", filesz,
+		       octeon_fixup_xkphys (paddr));
+		if (memsz > filesz) {
+			debug ("  Clearing 0x%llx bytes at %llx\n",
+			       memsz - filesz,
+			       octeon_fixup_xkphys (paddr) + filesz);
+			memset64 (octeon_fixup_xkphys (paddr) + filesz, 0,
+				  memsz - filesz);
+		}
+		if (is_little_endian_elf((unsigned long)es->hdr)) {
+			/* swap the bytes */
+			uint64_t base = octeon_fixup_xkphys(paddr);
+			uint64_t pos = 0;
+			uint64_t ptr;
+			uint64_t v;
+
+			while (pos < memsz) {
+				ptr = base + pos;
+				asm volatile ("ld %0,0(%1)\n"
+					      "	dsbh %0,%0\n"
+					      "	dshd %0,%0\n"
+					      "	sd %0,0(%1)"
+					      : "=&r" (v) : "r" (ptr) : "memory");
+				pos += sizeof(uint64_t);
+			}
+		}
+		flush_cache (paddr, memsz);
+	}
+
+	return octeon_fixup_xkphys (a->w64(ehdr->e_entry));
+}
+#endif /* CONFIG_GZIP || CONFIG_LZMA */
+
 /* ====================================================================== */
 U_BOOT_CMD (bootelf, 2, 0, do_bootelf,
 	    "Boot from an ELF image in memory",
@@ -307,23 +307,19 @@ int do_bootloader_update_nor(uint32_t image_addr, int length,
 		printf("Flash unprotect failed\n");
 		return 1;
 	}
-	if (flash_sect_erase(burn_addr_remapped, normal_top_remapped - 1)) {
-		printf("Flash erase failed\n");
-		return 1;
-	}
 
 	int rc;
-	puts("Copy to Flash... ");
+	puts("Updating Flash...\n");
 	/* Note: Here we copy more than we should - whatever is after the image
-	 * in memory gets copied to flash.
+	 * in memory gets copied to flash.  Sectors that already hold the
+	 * right data are neither erased nor programmed.
 	 */
-	rc = flash_write((char *)image_addr, burn_addr_remapped,
-			 normal_top_remapped - burn_addr_remapped);
+	rc = flash_update((char *)image_addr, burn_addr_remapped,
+			  normal_top_remapped - burn_addr_remapped);
 	if (rc != 0) {
 		flash_perror(rc);
 		return 1;
 	}
-	puts("done\n");
 
 #ifndef CONFIG_ENV_IS_IN_NAND
 	/* Erase the environment so that older bootloader will use its default
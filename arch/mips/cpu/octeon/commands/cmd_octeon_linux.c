@@ -27,6 +27,15 @@
 #include <asm/arch/cvmx-bootmem.h>
 #include <asm/arch/cvmx-app-init.h>
 #include <asm/arch/lib_octeon_shared.h>
+#include <malloc.h>
+#include <part.h>
+#include <watchdog.h>
+#ifdef CONFIG_CMD_FAT
+#include <fat.h>
+#endif
+#if defined(CONFIG_LZMA)
+#include <lzma/LzmaTools.h>
+#endif
 #include "octeon_biendian.h"
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -46,6 +55,43 @@ void start_elf(void);
 static int alloc_elf32_image(unsigned long addr);
 static uint64_t alloc_elf64_linux_image(unsigned long addr, int64_t *,
                                         struct cvmx_bootmem_named_block_desc *);
+#if defined(CONFIG_GZIP) || defined(CONFIG_LZMA)
+/* Compressed images in memory carry no length, so let the decoder find the end */
+#define OCTEON_STREAM_MAX_LEN	0x7fffffff
+
+#ifndef CONFIG_OCTEON_STREAM_CHUNK
+# define CONFIG_OCTEON_STREAM_CHUNK	(256 << 10)
+#endif
+
+/*
+ * Where a kernel image is read from: memory, or CONFIG_OCTEON_STREAM_CHUNK
+ * bytes at a time from a FAT file or from raw blocks of a block device.
+ * The decompressor pulls the chunks as it needs them, so reading and
+ * decompressing alternate and the compressed image is never staged whole.
+ */
+struct octeon_stream_src {
+	unsigned long addr;	/* image in memory when dev is NULL */
+	block_dev_desc_t *dev;
+	char fname[256];	/* FAT file name, empty for raw blocks */
+	unsigned long start;	/* first block of a raw image */
+	unsigned long pos;	/* bytes read so far */
+	unsigned char *chunk;	/* read buffer */
+	unsigned char *buf;	/* last chunk handed out */
+	unsigned long len;
+	int replay;		/* hand out the last chunk again */
+	uint64_t dic_phys;	/* LZMA dictionary in bootmem */
+	unsigned char *dic;
+	unsigned long dic_size;
+};
+
+static int octeon_stream_open(struct octeon_stream_src *src, const char *spec);
+static void octeon_stream_close(struct octeon_stream_src *src);
+static int octeon_stream_type(struct octeon_stream_src *src);
+static int octeon_stream_copy(struct octeon_stream_src *src, unsigned long addr);
+static uint64_t octeon_stream_load_elf64(struct octeon_stream_src *src, int type,
+					 struct cvmx_bootmem_named_block_desc *,
+					 int *);
+#endif
 
 volatile int start_core0 = 0;
 extern uint32_t cur_exception_base;
@@ -117,6 +163,12 @@ int do_bootoctlinux(cmd_tbl_t * cmdtp, int flag, int argc, char *const argv[])
 	int num_cores = 0;
 	int skip_cores = 0;
 	struct cvmx_bootmem_named_block_desc *linux_named_block = NULL;
+#if defined(CONFIG_GZIP) || defined(CONFIG_LZMA)
+	struct octeon_stream_src *stream_src;
+	const char *stream_spec = NULL;
+	int stream_type;
+#endif
+	int stream_le = -1;	/* endianness of a compressed image */
 
 #if CONFIG_OCTEON_SIM_SW_DIFF
 	/* Default is to run on all cores on simulator */
@@ -153,7 +205,13 @@ int do_bootoctlinux(cmd_tbl_t * cmdtp, int flag, int argc, char *const argv[])
 				printf("Specified named block not found\n");
 				return 1;
 			}
-		} else if (!strncmp(argv[i], "endbootargs", 12)) {
+		}
+#if defined(CONFIG_GZIP) || defined(CONFIG_LZMA)
+		else if (!strncmp(argv[i], "fatfile=", 8) ||
+			 !strncmp(argv[i], "blocks=", 7))
+			stream_spec = argv[i];
+#endif
+		else if (!strncmp(argv[i], "endbootargs", 12)) {
 			argc -= i + 1;
 			argv = &argv[i + 1];
 			break;	/* stop processing argument */
@@ -179,6 +237,38 @@ int do_bootoctlinux(cmd_tbl_t * cmdtp, int flag, int argc, char *const argv[])
 		return 1;
 	}
 
+#if defined(CONFIG_GZIP) || defined(CONFIG_LZMA)
+	/*
+	 * Compressed kernels are decompressed straight into their segments,
+	 * read a chunk at a time when they come from a device.
+	 */
+	stream_src = calloc(1, sizeof(*stream_src));
+	if (!stream_src) {
+		puts("Error allocating memory for the image source\n");
+		return 1;
+	}
+	stream_src->addr = addr;
+	if (stream_spec && octeon_stream_open(stream_src, stream_spec)) {
+		octeon_stream_close(stream_src);
+		free(stream_src);
+		return 1;
+	}
+	stream_type = octeon_stream_type(stream_src);
+	if (stream_type == IH_COMP_GZIP || stream_type == IH_COMP_LZMA)
+		entry_addr = octeon_stream_load_elf64(stream_src, stream_type,
+						      linux_named_block,
+						      &stream_le);
+	else if (stream_type < 0 ||
+		 (stream_spec && octeon_stream_copy(stream_src, addr)))
+		stream_type = -1;
+	octeon_stream_close(stream_src);
+	free(stream_src);
+	if (stream_type < 0)
+		return 1;
+	if (stream_type != IH_COMP_NONE)
+		goto loaded;
+#endif
+
 	if (!valid_elf_image(addr))
 		return 1;
 
@@ -202,6 +292,9 @@ int do_bootoctlinux(cmd_tbl_t * cmdtp, int flag, int argc, char *const argv[])
 		if (entry_addr)
 			load_elf64_image(addr, override_loadaddr);
 	}
+#if defined(CONFIG_GZIP) || defined(CONFIG_LZMA)
+loaded:
+#endif
 	if (!entry_addr) {
 		printf("## ERROR loading File!\n");
 		return -1;
@@ -214,7 +307,7 @@ int do_bootoctlinux(cmd_tbl_t * cmdtp, int flag, int argc, char *const argv[])
 		return -1;
 	}
 	image_flags = OCTEON_BOOT_DESC_IMAGE_LINUX;
-	if (is_little_endian_elf(addr))
+	if (stream_le < 0 ? is_little_endian_elf(addr) : stream_le)
 		image_flags |= OCTEON_BOOT_DESC_LITTLE_ENDIAN;
 
 	printf("## Loading %s-endian Linux kernel with entry point: 0x%08llx ...\n",
@@ -861,12 +954,317 @@ static uint64_t alloc_elf64_linux_image(unsigned long addr, int64_t *alloc_addr_
 	return entry_addr;
 }
 
+#if defined(CONFIG_GZIP) || defined(CONFIG_LZMA)
+/**
+ * Sets up a device source from a "fatfile=<interface>,<dev[:part]>,<file>"
+ * or "blocks=<interface>,<dev>,<start block>" argument.
+ *
+ * @return 0 on success, -1 on error
+ */
+static int octeon_stream_open(struct octeon_stream_src *src, const char *spec)
+{
+	char ifname[16];
+	const char *p, *end;
+	char *ep;
+	int fat = !strncmp(spec, "fatfile=", 8);
+	int dev, part = 1;
+
+	p = strchr(spec, '=') + 1;
+	end = strchr(p, ',');
+	if (!end || end - p >= sizeof(ifname))
+		goto usage;
+	memcpy(ifname, p, end - p);
+	ifname[end - p] = '\0';
+
+	p = end + 1;
+	dev = simple_strtoul(p, &ep, 16);
+	if (fat && *ep == ':')
+		part = simple_strtoul(ep + 1, &ep, 16);
+	if (ep == p || *ep != ',' || !ep[1])
+		goto usage;
+	p = ep + 1;
+
+	src->dev = get_dev(ifname, dev);
+	if (!src->dev) {
+		puts("** Invalid boot device **\n");
+		return -1;
+	}
+	if (fat) {
+#ifdef CONFIG_CMD_FAT
+		if (fat_register_device(src->dev, part)) {
+			printf("** Unable to use %s %d:%d **\n", ifname, dev, part);
+			return -1;
+		}
+		strncpy(src->fname, p, sizeof(src->fname) - 1);
+#else
+		puts("** FAT support is not enabled **\n");
+		return -1;
+#endif
+	} else {
+		src->start = simple_strtoul(p, NULL, 16);
+	}
+
+	src->chunk = malloc(CONFIG_OCTEON_STREAM_CHUNK);
+	if (!src->chunk) {
+		puts("Error allocating memory for the read buffer\n");
+		return -1;
+	}
+	return 0;
+
+usage:
+	printf("Invalid %.*s argument\n", (int)(strchr(spec, '=') - spec), spec);
+	return -1;
+}
+
+static void octeon_stream_close(struct octeon_stream_src *src)
+{
+	if (src->dic)
+		__cvmx_bootmem_phy_free(src->dic_phys, src->dic_size, 0);
+	free(src->chunk);
+	src->dic = NULL;
+	src->chunk = NULL;
+}
+
+static void octeon_stream_rewind(struct octeon_stream_src *src)
+{
+	src->pos = 0;
+	src->replay = 0;
+}
+
+/* Fill function for gunzip_stream() and lzmaStreamDecompress() */
+static int octeon_stream_fill(void *priv, unsigned char **buf,
+			      unsigned long *len)
+{
+	struct octeon_stream_src *src = priv;
+	block_dev_desc_t *dev = src->dev;
+
+	if (src->replay) {
+		src->replay = 0;
+	} else if (!dev) {
+		src->buf = (unsigned char *)src->addr;
+		src->len = src->pos ? 0 : OCTEON_STREAM_MAX_LEN;
+	} else if (src->fname[0]) {
+#ifdef CONFIG_CMD_FAT
+		long n = do_fat_read_at(src->fname, src->pos, src->chunk,
+					CONFIG_OCTEON_STREAM_CHUNK, LS_NO);
+
+		if (n < 0) {
+			printf("** Unable to read \"%s\" **\n", src->fname);
+			return -1;
+		}
+		src->buf = src->chunk;
+		src->len = n;
+#endif
+	} else {
+		unsigned long blk = src->start + src->pos / dev->blksz;
+		unsigned long cnt = CONFIG_OCTEON_STREAM_CHUNK / dev->blksz;
+
+		if (blk >= dev->lba)
+			cnt = 0;
+		else if (cnt > dev->lba - blk)
+			cnt = dev->lba - blk;
+		if (cnt && dev->block_read(dev->dev, blk, cnt, src->chunk) != cnt) {
+			printf("** Read error at block 0x%lx **\n", blk);
+			return -1;
+		}
+		src->buf = src->chunk;
+		src->len = cnt * dev->blksz;
+	}
+	src->pos += src->len;
+	*buf = src->buf;
+	*len = src->len;
+
+	return 0;
+}
+
+/**
+ * Reads the first chunk of the image to find out how it is compressed.
+ * The chunk is handed out again by the next octeon_stream_fill().
+ *
+ * @return IH_COMP_GZIP, IH_COMP_LZMA or IH_COMP_NONE, -1 on a read error
+ */
+static int octeon_stream_type(struct octeon_stream_src *src)
+{
+	unsigned char *p;
+	unsigned long len;
+
+	octeon_stream_rewind(src);
+	if (octeon_stream_fill(src, &p, &len))
+		return -1;
+	src->replay = 1;
+
+#if defined(CONFIG_GZIP)
+	if (len >= 2 && p[0] == 0x1f && p[1] == 0x8b)
+		return IH_COMP_GZIP;
+#endif
+#if defined(CONFIG_LZMA)
+	/* lc=3 lp=0 pb=2 and a 64k-aligned dictionary, as lzma writes */
+	if (len >= 13 && p[0] == 0x5d && p[1] == 0 && p[2] == 0)
+		return IH_COMP_LZMA;
+#endif
+	return IH_COMP_NONE;
+}
+
+/**
+ * Reads an uncompressed image from a device source to addr in one go, as
+ * fatload would.
+ *
+ * @return 0 on success, -1 on error
+ */
+static int octeon_stream_copy(struct octeon_stream_src *src, unsigned long addr)
+{
+	unsigned char *p;
+	unsigned long len, total = 0;
+
+	if (!src->fname[0]) {
+		puts("Raw block images must be gzip or LZMA compressed\n");
+		return -1;
+	}
+	octeon_stream_rewind(src);
+	do {
+		if (octeon_stream_fill(src, &p, &len))
+			return -1;
+		memcpy((void *)(addr + total), p, len);
+		total += len;
+		WATCHDOG_RESET();
+	} while (len);
+
+	return 0;
+}
+
+#if defined(CONFIG_LZMA)
+/*
+ * The dictionary of an image made with the default "lzma" settings does
+ * not fit in the malloc area, so it goes to bootmem, taken from the top of
+ * the low memory to stay clear of the kernel.
+ */
+static int octeon_stream_dic_alloc(struct octeon_stream_src *src)
+{
+	unsigned char *p = src->buf;
+	int64_t phys;
+
+	src->dic_size = p[1] | (p[2] << 8) | (p[3] << 16) |
+			((unsigned long)p[4] << 24);
+	if (src->dic_size < 4096)
+		src->dic_size = 4096;
+	phys = cvmx_bootmem_phy_alloc(src->dic_size, 0, 0x7fffffff, 128,
+				      CVMX_BOOTMEM_FLAG_END_ALLOC);
+	if (phys < 0) {
+		printf("LZMA: cannot allocate a %lu KiB dictionary\n",
+		       src->dic_size >> 10);
+		return -1;
+	}
+	src->dic_phys = phys;
+	src->dic = cvmx_phys_to_ptr(phys);
+
+	return 0;
+}
+#endif
+
+/**
+ * Decompresses a gzip or LZMA image, handing the output to a sink as it
+ * is produced (see gunzip_stream()).
+ *
+ * @param src    where the compressed image is read from
+ * @param sink   consumer of the decompressed data
+ * @param priv   passed to sink
+ *
+ * @return 0 on success, -1 on error
+ */
+static int octeon_stream_image(struct octeon_stream_src *src,
+			       int (*sink)(void *, const void *, unsigned long),
+			       void *priv)
+{
+	int type = octeon_stream_type(src);
+
+#if defined(CONFIG_GZIP)
+	if (type == IH_COMP_GZIP) {
+		unsigned long len;
+
+		return gunzip_stream(octeon_stream_fill, src, sink, priv, &len);
+	}
+#endif
+#if defined(CONFIG_LZMA)
+	if (type == IH_COMP_LZMA) {
+		SizeT len;
+		int ret;
+
+		ret = lzmaStreamDecompress(octeon_stream_fill, src, sink, priv,
+					   &len, src->dic, src->dic_size);
+		if (ret != SZ_OK) {
+			printf("LZMA: decompression failed: %d\n", ret);
+			return -1;
+		}
+		return 0;
+	}
+#endif
+	return -1;
+}
+
+/**
+ * Loads a compressed 64 bit Linux ELF image without staging the
+ * uncompressed image.  The first pass decompresses only the headers so
+ * the segments can be allocated; the second decompresses the whole image
+ * straight into them.
+ *
+ * @param src    where the compressed image is read from
+ * @param type   IH_COMP_GZIP or IH_COMP_LZMA
+ * @param linux_named_block   as for alloc_elf64_linux_image()
+ * @param little_endian       set to 1 for a little-endian image, else 0
+ *
+ * @return 0 on failure
+ *         !0 on success (the entry address to use)
+ */
+static uint64_t octeon_stream_load_elf64(struct octeon_stream_src *src,
+					 int type,
+					 struct cvmx_bootmem_named_block_desc *linux_named_block,
+					 int *little_endian)
+{
+	struct elf64_stream *es;
+	uint64_t entry_addr = 0;
+	int64_t override_loadaddr = 0;
+
+#if defined(CONFIG_LZMA)
+	if (type == IH_COMP_LZMA && octeon_stream_dic_alloc(src))
+		return 0;
+#endif
+	es = calloc(1, sizeof(*es));
+	if (!es) {
+		puts("Error allocating memory for elf image header!\n");
+		return 0;
+	}
+
+	if (octeon_stream_image(src, elf64_stream_hdr_sink, es) ||
+	    !elf64_stream_valid(es, src->addr))
+		goto out;
+	*little_endian = is_little_endian_elf((unsigned long)es->hdr);
+
+	cvmx_bootmem_phy_named_block_free(OCTEON_LINUX_RESERVED_MEM_NAME, 0);
+
+	entry_addr = alloc_elf64_linux_image((unsigned long)es->hdr,
+					     &override_loadaddr,
+					     linux_named_block);
+	if (!entry_addr)
+		goto out;
+
+	es->load_override = override_loadaddr;
+	if (octeon_stream_image(src, elf64_stream_load_sink, es) ||
+	    !elf64_stream_finish(es))
+		entry_addr = 0;
+out:
+	free(es);
+	return entry_addr;
+}
+#endif /* CONFIG_GZIP || CONFIG_LZMA */
+
 U_BOOT_CMD(bootoctlinux, 32, 0, do_bootoctlinux,
 	   "Boot from a linux ELF image in memory",
 	   "elf_address [coremask=mask_to_run | numcores=core_cnt_to_run] "
-	   "[forceboot] [skipcores=core_cnt_to_skip] [namedblock=name] [endbootargs] [app_args ...]\n"
+	   "[forceboot] [skipcores=core_cnt_to_skip] [namedblock=name] "
+	   "[fatfile=interface,dev[:part],file | blocks=interface,dev,start] "
+	   "[endbootargs] [app_args ...]\n"
 	   "elf_address - address of ELF image to load. If 0, default load address\n"
-	   "              is  used.\n"
+	   "              is  used.  The image may be gzip or LZMA compressed.\n"
 	   "coremask    - mask of cores to run on.  Anded with coremask_override\n"
 	   "              environment variable to ensure only working cores are used\n"
 	   "numcores    - number of cores to run on.  Runs on specified number of cores,\n"
@@ -877,6 +1275,11 @@ U_BOOT_CMD(bootoctlinux, 32, 0, do_bootoctlinux,
 	   "              and load the application starting at the next available core.\n"
 	   "forceboot   - if set, boots application even if core 0 is not in mask\n"
 	   "namedblock	- specifies a named block to load the kernel\n"
+	   "fatfile     - read the image from a FAT file while it is decompressed\n"
+	   "              instead of from memory.  An uncompressed image is\n"
+	   "              loaded to elf_address first.\n"
+	   "blocks      - read a compressed image from the raw blocks of a device,\n"
+	   "              starting at block start (hex), while it is decompressed\n"
 	   "endbootargs - if set, bootloader does not process any further arguments and\n"
 	   "              only passes the arguments that follow to the kernel.\n"
 	   "              If not set, the kernel gets the entire commnad line as\n"
@@ -0,0 +1,220 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Bulk data transfer from a PCI/PCIe host.
+ *
+ * The channel is a PCI console (same descriptor and ring layout as the
+ * "__pci_console" block) in the named block "__pci_bulk", with one
+ * console whose rings are pci_bulk_size bytes.  The host looks the block
+ * up through the bootmem descriptor, writes an octeon_pci_bulk_hdr_t and
+ * then the payload into the input ring as fast as it is drained, see
+ * tools/octeon_pci_bulk.c.
+ */
+
+#include <config.h>
+#include <command.h>
+#include <common.h>
+#include <watchdog.h>
+#include <asm/arch/octeon_boot.h>
+#include <asm/arch/cvmx-bootmem.h>
+#include <asm/arch/octeon-pci-console.h>
+
+#define PCI_BULK_DEFAULT_SIZE	(1024 * 1024)
+#define PCI_BULK_MIN_SIZE	(64 * 1024)
+
+static uint64_t pci_bulk_desc_addr;
+
+static int pci_bulk_start(void)
+{
+	int size = PCI_BULK_DEFAULT_SIZE;
+	char *ep;
+
+	if (pci_bulk_desc_addr)
+		return 0;
+
+	ep = getenv("pci_bulk_size");
+	if (ep)
+		size = simple_strtoul(ep, NULL, 0);
+	if (size < PCI_BULK_MIN_SIZE)
+		size = PCI_BULK_MIN_SIZE;
+
+	pci_bulk_desc_addr =
+		octeon_pci_console_init_named(OCTEON_PCI_BULK_BLOCK_NAME, 1,
+					      size);
+	if (!pci_bulk_desc_addr) {
+		printf("Could not allocate %d byte PCI bulk channel\n", size);
+		return -1;
+	}
+	debug("PCI bulk channel at 0x%llx, %d byte ring\n",
+	      pci_bulk_desc_addr, size);
+	return 0;
+}
+
+/* Throw away whatever is left in the ring after a failed transfer */
+static void pci_bulk_drain(void)
+{
+	char buf[256];
+
+	while (octeon_pci_console_read(pci_bulk_desc_addr, 0, buf, sizeof(buf),
+				       OCT_PCI_CON_FLAG_NONBLOCK) > 0)
+		;
+}
+
+/**
+ * Read exactly len bytes from the bulk channel.
+ *
+ * @param buf		destination
+ * @param len		number of bytes to read
+ * @param timeout	milliseconds to wait for data to start arriving,
+ *			0 to wait forever
+ *
+ * @return 0 on success, -1 on error, timeout or Ctrl-C
+ */
+static int pci_bulk_read(void *buf, uint64_t len, ulong timeout)
+{
+	ulong start = get_timer(0);
+	int n, chunk;
+
+	while (len > 0) {
+		chunk = len > 0x40000000 ? 0x40000000 : len;
+		n = octeon_pci_console_read(pci_bulk_desc_addr, 0, buf, chunk,
+					    OCT_PCI_CON_FLAG_NONBLOCK);
+		if (n < 0)
+			return -1;
+		if (n > 0) {
+			buf += n;
+			len -= n;
+			start = get_timer(0);
+			continue;
+		}
+		WATCHDOG_RESET();
+		if (ctrlc()) {
+			puts("\nAborted\n");
+			return -1;
+		}
+		if (timeout && get_timer(start) > timeout) {
+			puts("\nTimeout waiting for host\n");
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int do_pci_bulk_recv(char *name, ulong timeout)
+{
+	const cvmx_bootmem_named_block_desc_t *block;
+	octeon_pci_bulk_hdr_t hdr;
+	int64_t addr;
+	uint64_t size;
+	uint32_t crc;
+	ulong start, ms;
+	void *dst;
+	char buf[20];
+
+	if (pci_bulk_start())
+		return 1;
+
+	printf("Waiting for host to send %s...\n", name);
+	if (pci_bulk_read(&hdr, sizeof(hdr), timeout))
+		return 1;
+	if (hdr.magic != OCTEON_PCI_BULK_MAGIC ||
+	    hdr.version != OCTEON_PCI_BULK_VERSION || !hdr.size) {
+		printf("Invalid bulk transfer header (magic 0x%x, version %u)\n",
+		       hdr.magic, hdr.version);
+		pci_bulk_drain();
+		return 1;
+	}
+	size = hdr.size;
+
+	/* Reuse the named block if it is big enough, replace it otherwise */
+	block = cvmx_bootmem_find_named_block(name);
+	if (block && block->size >= size) {
+		addr = block->base_addr;
+	} else {
+		if (block)
+			cvmx_bootmem_phy_named_block_free(name, 0);
+		addr = cvmx_bootmem_phy_named_block_alloc(size, 0, 0x7fffffff,
+							  128, name, 0);
+	}
+	if (addr < 0) {
+		printf("Could not allocate 0x%llx bytes for %s\n", size, name);
+		pci_bulk_drain();
+		return 1;
+	}
+	dst = cvmx_phys_to_ptr(addr);
+
+	start = get_timer(0);
+	if (pci_bulk_read(dst, size, timeout ? timeout : 10000)) {
+		pci_bulk_drain();
+		return 1;
+	}
+	ms = get_timer(start);
+
+	crc = crc32_wd(0, dst, size, CHUNKSZ_CRC32);
+	if (crc != hdr.crc32) {
+		printf("CRC mismatch: got 0x%08x, expected 0x%08x\n",
+		       crc, hdr.crc32);
+		return 1;
+	}
+
+	printf("Received %llu bytes at 0x%llx in %lu ms", size, addr, ms);
+	if (ms)
+		printf(" (%llu KiB/s)", (size * 1000 / ms) >> 10);
+	putc('\n');
+
+	sprintf(buf, "0x%llx", addr);
+	setenv("named_block_addr", buf);
+	sprintf(buf, "0x%llx", size);
+	setenv("named_block_size", buf);
+	sprintf(buf, "%lx", (ulong)dst);
+	setenv("fileaddr", buf);
+	sprintf(buf, "%llx", size);
+	setenv("filesize", buf);
+	return 0;
+}
+
+int do_pci_bulk(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	ulong timeout = 0;
+
+	if (argc < 2)
+		return cmd_usage(cmdtp);
+
+	if (!strcmp(argv[1], "init")) {
+		return pci_bulk_start() ? 1 : 0;
+	} else if (!strcmp(argv[1], "recv") && argc >= 3) {
+		if (argc > 3)
+			timeout = simple_strtoul(argv[3], NULL, 10) * 1000;
+		return do_pci_bulk_recv(argv[2], timeout);
+	}
+	return cmd_usage(cmdtp);
+}
+
+U_BOOT_CMD(pcibulk, 4, 0, do_pci_bulk,
+	   "Receive data from the PCI host at PCIe speed",
+	   "init\n"
+	   "    - Allocate the bulk channel so the host can find it\n"
+	   "pcibulk recv name [timeout]\n"
+	   "    - Receive data pushed by the host (octeon_pci_bulk) into the\n"
+	   "      named bootmem block 'name', waiting at most 'timeout' seconds\n"
+	   "      for the host.  Sets named_block_addr, named_block_size,\n"
+	   "      fileaddr and filesize.  The ring size is taken from the\n"
+	   "      pci_bulk_size environment variable (default 1MiB).\n");
@@ -0,0 +1,487 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Run a command with the core and L2 cache performance counters enabled
+ * and print what they counted.
+ *
+ * Core events use the CP0 performance counters of the core running U-Boot
+ * (two on Octeon and Octeon Plus, four on Octeon II), L2 events use the
+ * four L2C counters (summed over all TADs on Octeon II) and the "dram"
+ * event uses the LMC0 data bus utilization counter.  Cycles are always
+ * taken from CvmCount.  Whatever configuration the counters had before is
+ * restored afterwards.
+ */
+
+#include <config.h>
+#include <command.h>
+#include <common.h>
+#include <asm/mipsregs.h>
+#include <asm/arch/cvmx.h>
+#include <asm/arch/cvmx-core.h>
+#include <asm/arch/cvmx-l2c.h>
+#include <asm/arch/cvmx-l2c-defs.h>
+#include <asm/arch/cvmx-lmcx-defs.h>
+#include <asm/arch/cvmx-clock.h>
+#include <asm/arch/octeon_boot.h>
+
+#define PERF_MAX_CORE		4
+#define PERF_MAX_EVENTS		(1 + PERF_MAX_CORE + CVMX_L2C_MAX_PCNT + 1)
+#define PERF_DEFAULT_EVENTS	"insns,dmiss,l2hit,l2miss,fills,dram"
+
+enum perf_unit {
+	PERF_UNIT_CYCLES,
+	PERF_UNIT_CORE,
+	PERF_UNIT_L2C,
+	PERF_UNIT_LMC,
+};
+
+struct perf_event {
+	const char	*name;
+	enum perf_unit	unit;
+	int		event;		/* core event, or L2C event on Octeon 1 */
+	int		tad_event;	/* L2C TAD event on Octeon II, NONE if
+					   the TADs cannot count it */
+	const char	*help;
+};
+
+static const struct perf_event perf_events[] = {
+	{ "cycles",   PERF_UNIT_CYCLES, 0, 0, "core clock cycles (always counted)" },
+	{ "insns",    PERF_UNIT_CORE, CVMX_CORE_PERF_RET, 0, "instructions retired" },
+	{ "issued",   PERF_UNIT_CORE, CVMX_CORE_PERF_ISSUE, 0, "instructions issued" },
+	{ "noissue",  PERF_UNIT_CORE, CVMX_CORE_PERF_NISSUE, 0, "cycles with no issue" },
+	{ "imiss",    PERF_UNIT_CORE, CVMX_CORE_PERF_CIMISS, 0, "cycles idle on icache misses" },
+	{ "dmiss",    PERF_UNIT_CORE, CVMX_CORE_PERF_DMLDS, 0, "loads that missed the dcache" },
+	{ "loads",    PERF_UNIT_CORE, CVMX_CORE_PERF_LDS, 0, "loads issued" },
+	{ "stores",   PERF_UNIT_CORE, CVMX_CORE_PERF_STS, 0, "stores issued" },
+	{ "brmiss",   PERF_UNIT_CORE, CVMX_CORE_PERF_BRMIS, 0, "branch mispredicts" },
+	{ "csr",      PERF_UNIT_CORE, CVMX_CORE_PERF_CSRC, 0, "cycles issuing CSR accesses" },
+	{ "ioloads",  PERF_UNIT_CORE, CVMX_CORE_PERF_IOLDS, 0, "I/O loads (CSR reads)" },
+	{ "iostores", PERF_UNIT_CORE, CVMX_CORE_PERF_IOSTS, 0, "I/O stores (CSR writes)" },
+	{ "sync",     PERF_UNIT_CORE, CVMX_CORE_PERF_SYNC, 0, "SYNC stall cycles" },
+	{ "wbfull",   PERF_UNIT_CORE, CVMX_CORE_PERF_WBUFFL, 0, "cycles with the write buffer full" },
+	{ "tlb",      PERF_UNIT_CORE, CVMX_CORE_PERF_DTLB, 0, "dstream TLB exceptions" },
+	{ "l2hit",    PERF_UNIT_L2C, CVMX_L2C_EVENT_HIT, CVMX_L2C_TAD_EVENT_TAG_HIT, "L2 hits" },
+	{ "l2miss",   PERF_UNIT_L2C, CVMX_L2C_EVENT_MISS, CVMX_L2C_TAD_EVENT_TAG_MISS, "L2 misses" },
+	{ "l2victim", PERF_UNIT_L2C, CVMX_L2C_EVENT_TAG_DIRTY, CVMX_L2C_TAD_EVENT_TAG_VICTIM, "L2 victims written back" },
+	{ "fills",    PERF_UNIT_L2C, CVMX_L2C_EVENT_FILL_DATA_VALID, CVMX_L2C_TAD_EVENT_NONE, "L2 fills from DRAM" },
+	{ "dram",     PERF_UNIT_LMC, 0, 0, "LMC0 data bus busy cycles" },
+};
+
+struct perf_counter {
+	const struct perf_event	*ev;
+	int			index;	/* counter number within its unit */
+	uint64_t		start;
+	uint64_t		count;
+};
+
+static struct perf_counter counters[PERF_MAX_EVENTS];
+static int num_counters;
+
+/* Command being measured, for octeon_perf_boot() */
+static int perf_running;
+static int perf_argc;
+static char * const *perf_argv;
+static int perf_machine;
+
+/* Saved counter configuration */
+static uint32_t saved_core_ctl[PERF_MAX_CORE];
+static uint64_t saved_l2c_ctl;
+
+/**
+ * Returns the number of CP0 performance counters.  Each control register
+ * has its M bit set if another counter follows it.
+ */
+static int perf_num_core_counters(void)
+{
+	if (!(read_c0_perfctrl1() & 0x80000000))
+		return 2;
+	return 4;
+}
+
+static uint32_t perf_core_read_ctl(int index)
+{
+	switch (index) {
+	case 0:
+		return read_c0_perfctrl0();
+	case 1:
+		return read_c0_perfctrl1();
+	case 2:
+		return read_c0_perfctrl2();
+	default:
+		return read_c0_perfctrl3();
+	}
+}
+
+static void perf_core_write_ctl(int index, uint32_t ctl)
+{
+	switch (index) {
+	case 0:
+		write_c0_perfctrl0(ctl);
+		break;
+	case 1:
+		write_c0_perfctrl1(ctl);
+		break;
+	case 2:
+		write_c0_perfctrl2(ctl);
+		break;
+	default:
+		write_c0_perfctrl3(ctl);
+		break;
+	}
+}
+
+static uint64_t perf_core_read(int index)
+{
+	switch (index) {
+	case 0:
+		return read_64bit_c0_perfcntr0();
+	case 1:
+		return read_64bit_c0_perfcntr1();
+	case 2:
+		return read_64bit_c0_perfcntr2();
+	default:
+		return read_64bit_c0_perfcntr3();
+	}
+}
+
+static void perf_core_start(int index, int event)
+{
+	cvmx_core_perf_control_t control;
+
+	control.u32 = 0;
+	control.s.event = event;
+	control.s.u = 1;
+	control.s.s = 1;
+	control.s.k = 1;
+	control.s.ex = 1;
+	perf_core_write_ctl(index, control.u32);
+}
+
+static void perf_l2c_save(void)
+{
+	if (OCTEON_IS_OCTEON1PLUS())
+		saved_l2c_ctl = cvmx_read_csr(CVMX_L2C_PFCTL);
+	else
+		saved_l2c_ctl = cvmx_read_csr(CVMX_L2C_TADX_PRF(0));
+}
+
+static void perf_l2c_restore(void)
+{
+	int tad;
+
+	if (OCTEON_IS_OCTEON1PLUS()) {
+		cvmx_write_csr(CVMX_L2C_PFCTL, saved_l2c_ctl);
+		return;
+	}
+	for (tad = 0; tad < CVMX_L2C_TADS; tad++)
+		cvmx_write_csr(CVMX_L2C_TADX_PRF(tad), saved_l2c_ctl);
+}
+
+/**
+ * Selects the L2C events.  On Octeon II cvmx_l2c_config_perf() warns on
+ * every call, so the TAD registers are programmed here directly.
+ */
+static void perf_l2c_start(void)
+{
+	union cvmx_l2c_tadx_prf prf;
+	int i, tad;
+
+	if (OCTEON_IS_OCTEON1PLUS()) {
+		for (i = 0; i < num_counters; i++)
+			if (counters[i].ev->unit == PERF_UNIT_L2C)
+				cvmx_l2c_config_perf(counters[i].index,
+						     counters[i].ev->event, 0);
+		return;
+	}
+
+	prf.u64 = saved_l2c_ctl;
+	for (i = 0; i < num_counters; i++) {
+		if (counters[i].ev->unit != PERF_UNIT_L2C)
+			continue;
+		switch (counters[i].index) {
+		case 0:
+			prf.s.cnt0sel = counters[i].ev->tad_event;
+			break;
+		case 1:
+			prf.s.cnt1sel = counters[i].ev->tad_event;
+			break;
+		case 2:
+			prf.s.cnt2sel = counters[i].ev->tad_event;
+			break;
+		default:
+			prf.s.cnt3sel = counters[i].ev->tad_event;
+			break;
+		}
+	}
+	for (tad = 0; tad < CVMX_L2C_TADS; tad++)
+		cvmx_write_csr(CVMX_L2C_TADX_PRF(tad), prf.u64);
+}
+
+static uint64_t perf_lmc_read(void)
+{
+	if (OCTEON_IS_OCTEON2())
+		return cvmx_read_csr(CVMX_LMCX_OPS_CNT(0));
+	return (cvmx_read_csr(CVMX_LMCX_OPS_CNT_HI(0)) << 32) |
+		(cvmx_read_csr(CVMX_LMCX_OPS_CNT_LO(0)) & 0xffffffffull);
+}
+
+static uint64_t perf_read(const struct perf_counter *c)
+{
+	switch (c->ev->unit) {
+	case PERF_UNIT_CYCLES:
+		return cvmx_get_cycle();
+	case PERF_UNIT_CORE:
+		return perf_core_read(c->index);
+	case PERF_UNIT_L2C:
+		return cvmx_l2c_read_perf(c->index);
+	default:
+		return perf_lmc_read();
+	}
+}
+
+static const struct perf_event *perf_find_event(const char *name, int len)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(perf_events); i++)
+		if (strlen(perf_events[i].name) == len &&
+		    !strncmp(perf_events[i].name, name, len))
+			return &perf_events[i];
+	return NULL;
+}
+
+/* Octeon II has no TAD event for fills from DRAM */
+static int perf_event_supported(const struct perf_event *ev)
+{
+	return ev->unit != PERF_UNIT_L2C || OCTEON_IS_OCTEON1PLUS() ||
+	       ev->tad_event != CVMX_L2C_TAD_EVENT_NONE;
+}
+
+/**
+ * Assigns a counter to every event in a comma separated list.  Cycles are
+ * always counted and come first.
+ *
+ * @param list		events to count
+ * @param defaults	list is the default list, silently skip the events
+ *			this chip cannot count
+ *
+ * @return 0 for success, -1 on error
+ */
+static int perf_parse_events(const char *list, int defaults)
+{
+	const struct perf_event *ev;
+	int max_core = perf_num_core_counters();
+	int num_core = 0, num_l2c = 0;
+	const char *end;
+	int i, len;
+
+	num_counters = 0;
+	counters[num_counters++].ev = &perf_events[0];
+
+	while (*list) {
+		end = strchr(list, ',');
+		len = end ? end - list : strlen(list);
+		ev = perf_find_event(list, len);
+		if (!ev) {
+			printf("Unknown event \"%.*s\", see \"perf list\"\n",
+			       len, list);
+			return -1;
+		}
+		list += len + (end ? 1 : 0);
+
+		if (!perf_event_supported(ev)) {
+			if (defaults)
+				continue;
+			printf("Event \"%s\" is not supported on this chip\n",
+			       ev->name);
+			return -1;
+		}
+
+		for (i = 0; i < num_counters; i++)
+			if (counters[i].ev == ev)
+				break;
+		if (i < num_counters)
+			continue;
+
+		if (ev->unit == PERF_UNIT_CORE) {
+			if (num_core == max_core) {
+				printf("Only %d core events can be counted at once\n",
+				       max_core);
+				return -1;
+			}
+			counters[num_counters].index = num_core++;
+		} else if (ev->unit == PERF_UNIT_L2C) {
+			if (num_l2c == CVMX_L2C_MAX_PCNT) {
+				printf("Only %d L2 events can be counted at once\n",
+				       CVMX_L2C_MAX_PCNT);
+				return -1;
+			}
+			counters[num_counters].index = num_l2c++;
+		}
+		counters[num_counters++].ev = ev;
+	}
+	return 0;
+}
+
+static void perf_start(void)
+{
+	int i;
+
+	for (i = 0; i < PERF_MAX_CORE; i++)
+		saved_core_ctl[i] = i < perf_num_core_counters() ?
+					perf_core_read_ctl(i) : 0;
+	perf_l2c_save();
+
+	for (i = 0; i < num_counters; i++)
+		if (counters[i].ev->unit == PERF_UNIT_CORE)
+			perf_core_start(counters[i].index,
+					counters[i].ev->event);
+	perf_l2c_start();
+
+	/* Take the cycle count last so the setup is not included */
+	for (i = num_counters - 1; i >= 0; i--)
+		counters[i].start = perf_read(&counters[i]);
+}
+
+static void perf_stop(void)
+{
+	int i;
+
+	for (i = 0; i < num_counters; i++)
+		counters[i].count = perf_read(&counters[i]) - counters[i].start;
+
+	for (i = 0; i < perf_num_core_counters(); i++)
+		perf_core_write_ctl(i, saved_core_ctl[i]);
+	perf_l2c_restore();
+}
+
+static void perf_report(int argc, char * const argv[], int rc, int machine)
+{
+	uint64_t cycles = counters[0].count;
+	uint64_t usec = cycles / (cvmx_clock_get_rate(CVMX_CLOCK_CORE) / 1000000);
+	int i;
+
+	if (machine) {
+		printf("perf:rc=%d,usec=%llu", rc, usec);
+		for (i = 0; i < num_counters; i++)
+			printf(",%s=%llu", counters[i].ev->name,
+			       counters[i].count);
+		putc('\n');
+		return;
+	}
+
+	printf("\nPerformance counters for '");
+	for (i = 0; i < argc; i++)
+		printf(i ? " %s" : "%s", argv[i]);
+	printf("' (returned %d):\n\n", rc);
+	for (i = 0; i < num_counters; i++) {
+		printf("%20llu  %-10s %s", counters[i].count,
+		       counters[i].ev->name, counters[i].ev->help);
+		if (counters[i].ev->event == CVMX_CORE_PERF_RET &&
+		    counters[i].ev->unit == PERF_UNIT_CORE && cycles)
+			printf(" (%llu.%02llu per cycle)",
+			       counters[i].count / cycles,
+			       (counters[i].count * 100 / cycles) % 100);
+		putc('\n');
+	}
+	printf("\n%20llu.%06llu seconds elapsed\n", usec / 1000000,
+	       usec % 1000000);
+}
+
+/**
+ * Called by start_cores() right before jumping to an application, which
+ * never returns to do_perf(), so that "perf -- bootoctlinux" still reports
+ * the time spent up to the handoff.
+ */
+void octeon_perf_boot(void)
+{
+	if (!perf_running)
+		return;
+	perf_running = 0;
+	perf_stop();
+	perf_report(perf_argc, perf_argv, 0, perf_machine);
+}
+
+static int do_perf(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	static const char default_events[] = PERF_DEFAULT_EVENTS;
+	const char *events = default_events;
+	int machine = 0;
+	int repeatable;
+	int i, rc;
+
+	if (argc >= 2 && !strcmp(argv[1], "list")) {
+		printf("Core counters: %d, L2 counters: %d\n",
+		       perf_num_core_counters(), CVMX_L2C_MAX_PCNT);
+		for (i = 0; i < ARRAY_SIZE(perf_events); i++)
+			printf("  %-10s %s%s\n", perf_events[i].name,
+			       perf_events[i].help,
+			       perf_event_supported(&perf_events[i]) ?
+					"" : " (not supported)");
+		return CMD_RET_SUCCESS;
+	}
+
+	argc--;
+	argv++;
+	if (argc && !strcmp(argv[0], "-m")) {
+		machine = 1;
+		argc--;
+		argv++;
+	}
+	/* An event list must be followed by "--" */
+	for (i = 0; i < argc; i++)
+		if (!strcmp(argv[i], "--"))
+			break;
+	if (i < argc) {
+		if (i > 1)
+			return CMD_RET_USAGE;
+		if (i == 1)
+			events = argv[0];
+		argc -= i + 1;
+		argv += i + 1;
+	}
+	if (!argc)
+		return CMD_RET_USAGE;
+
+	if (perf_parse_events(events, events == default_events))
+		return CMD_RET_FAILURE;
+
+	perf_argc = argc;
+	perf_argv = argv;
+	perf_machine = machine;
+	perf_running = 1;
+	perf_start();
+	rc = cmd_process(flag, argc, argv, &repeatable);
+	perf_stop();
+	perf_running = 0;
+
+	perf_report(argc, argv, rc, machine);
+	return rc;
+}
+
+U_BOOT_CMD(perf, CONFIG_SYS_MAXARGS, 0, do_perf,
+	   "count hardware events while running a command",
+	   "[-m] [event[,event...] --] command [args...]\n"
+	   "    - run command and print the cycles and events it took\n"
+	   "      -m: print one comma separated name=value line\n"
+	   "      default events: " PERF_DEFAULT_EVENTS "\n"
+	   "perf list\n"
+	   "    - list the events that can be counted");
@@ -0,0 +1,280 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Sampling profiler, see asm/arch/octeon_prof.h.
+ *
+ * The samples go to the same named blocks oct-remote-profile reads
+ * ("event_config_block" and "event_block"), so a host attached over PCI
+ * can collect them as well.  "prof" prints them as a histogram of
+ * functions, using the symbol table linked in with CONFIG_KALLSYMS.
+ */
+
+#include <config.h>
+#include <command.h>
+#include <common.h>
+#include <malloc.h>
+#include <asm/mipsregs.h>
+#include <asm/arch/cvmx.h>
+#include <asm/arch/cvmx-core.h>
+#include <asm/arch/cvmx-bootmem.h>
+#include <asm/arch/cvmx-clock.h>
+#include <asm/arch/cvmx-profiler.h>
+#include <asm/arch/octeon_prof.h>
+
+/* Default sampling period, in microseconds */
+#define PROF_DEFAULT_PERIOD_US	1000
+#define PROF_DEFAULT_TOP	20
+
+int octeon_prof_active;
+void *octeon_prof_udelay_pc;
+static uint64_t prof_period;
+static uint32_t prof_saved_ctl;
+
+void __octeon_prof_sample(unsigned long pc)
+{
+	uint64_t count = read_64bit_c0_perfcntr0();
+	uint64_t n;
+
+	if (!(count >> 63))
+		return;
+
+	/*
+	 * The counter keeps running after it overflows, charge every
+	 * period that has passed since then to this caller.
+	 */
+	n = (count & ~(1ull << 63)) / prof_period + 1;
+	if (n > EVENT_PERCPU_BUFFER_SIZE / sizeof(cvmx_sample_entry_t))
+		n = EVENT_PERCPU_BUFFER_SIZE / sizeof(cvmx_sample_entry_t);
+
+	/* cvmx_collect_sample() takes the PC from EPC */
+	write_c0_epc(pc);
+	while (n--)
+		cvmx_collect_sample();
+}
+
+/**
+ * Returns the sample ring of this core, or NULL if there is none
+ */
+static cvmx_ringbuf_t *prof_ring(void)
+{
+	const cvmx_bootmem_named_block_desc_t *blk;
+
+	blk = cvmx_bootmem_find_named_block(EVENT_BUFFER_BLOCK);
+	if (!blk)
+		return NULL;
+	return cvmx_phys_to_ptr(blk->base_addr +
+				EVENT_PERCPU_BUFFER_SIZE * cvmx_get_core_num());
+}
+
+/**
+ * Looks up or allocates a named block and clears it
+ */
+static void *prof_block(const char *name, uint64_t size)
+{
+	const cvmx_bootmem_named_block_desc_t *blk;
+	void *ptr;
+
+	blk = cvmx_bootmem_find_named_block(name);
+	if (blk && blk->size < size) {
+		printf("Named block %s is too small\n", name);
+		return NULL;
+	}
+	if (blk)
+		ptr = cvmx_phys_to_ptr(blk->base_addr);
+	else
+		ptr = cvmx_bootmem_alloc_named_range(size, 0, 0x7fffffff, 128,
+						     name);
+	if (!ptr) {
+		printf("Could not allocate named block %s\n", name);
+		return NULL;
+	}
+	memset(ptr, 0, size);
+	return ptr;
+}
+
+static int prof_start(uint64_t period)
+{
+	cvmx_config_block_t *cfg;
+	cvmx_core_perf_control_t control;
+
+	cfg = prof_block(EVENT_BUFFER_CONFIG_BLOCK, EBC_BLOCK_SIZE);
+	if (!cfg || !prof_block(EVENT_BUFFER_BLOCK, EVENT_BUFFER_SIZE))
+		return -1;
+
+	/*
+	 * With the ring headers zeroed the next sample re-reads the config
+	 * block and sets the ring up again.
+	 */
+	cfg->events = period;
+	prof_period = period;
+
+	prof_saved_ctl = read_c0_perfctrl0();
+	control.u32 = 0;
+	control.s.event = CVMX_CORE_PERF_CLK;
+	control.s.k = 1;
+	control.s.ex = 1;
+	write_64bit_c0_perfcntr0((1ull << 63) - period);
+	write_c0_perfctrl0(control.u32);
+
+	octeon_prof_active = 1;
+	return 0;
+}
+
+static void prof_stop(void)
+{
+	octeon_prof_active = 0;
+	write_c0_perfctrl0(prof_saved_ctl);
+}
+
+struct prof_bucket {
+	unsigned long	addr;
+	const char	*name;
+	int		count;
+};
+
+static void prof_show(int top)
+{
+	cvmx_ringbuf_t *ring = prof_ring();
+	cvmx_sample_entry_t *samples;
+	struct prof_bucket *buckets;
+	struct prof_bucket tmp;
+	int num_samples, num_buckets = 0;
+	unsigned long addr;
+	const char *name;
+	int i, j;
+
+	if (!ring || !ring->pcpu_blk_info.end) {
+		puts("No samples\n");
+		return;
+	}
+
+	samples = (cvmx_sample_entry_t *)ring->pcpu_data;
+	num_samples = (ring->pcpu_blk_info.end - ring->pcpu_data) /
+			sizeof(*samples);
+	if (ring->pcpu_blk_info.sample_count < num_samples)
+		num_samples = ring->pcpu_blk_info.sample_count;
+	if (!num_samples) {
+		puts("No samples\n");
+		return;
+	}
+
+	buckets = malloc(num_samples * sizeof(*buckets));
+	if (!buckets) {
+		puts("Out of memory\n");
+		return;
+	}
+
+	for (i = 0; i < num_samples; i++) {
+		addr = samples[i].pc;
+		name = NULL;
+#ifdef CONFIG_KALLSYMS
+		name = symbol_lookup(samples[i].pc, &addr);
+		if (!name)
+			addr = samples[i].pc;
+#endif
+		for (j = 0; j < num_buckets; j++)
+			if (buckets[j].addr == addr)
+				break;
+		if (j == num_buckets) {
+			buckets[j].addr = addr;
+			buckets[j].name = name;
+			buckets[j].count = 0;
+			num_buckets++;
+		}
+		buckets[j].count++;
+	}
+
+	/* Sort by count, there are at most a few hundred buckets */
+	for (i = 1; i < num_buckets; i++) {
+		tmp = buckets[i];
+		for (j = i; j > 0 && buckets[j - 1].count < tmp.count; j--)
+			buckets[j] = buckets[j - 1];
+		buckets[j] = tmp;
+	}
+
+	printf("%lld samples, one every %llu cycles",
+	       ring->pcpu_blk_info.sample_count, prof_period);
+	if (ring->pcpu_blk_info.sample_count > num_samples)
+		printf(", the last %d kept", num_samples);
+	puts("\n\n  samples      %  function\n");
+	for (i = 0; i < num_buckets && i < top; i++) {
+		printf("%9d %5d.%d  ", buckets[i].count,
+		       buckets[i].count * 100 / num_samples,
+		       buckets[i].count * 1000 / num_samples % 10);
+		if (buckets[i].name)
+			printf("%s\n", buckets[i].name);
+		else
+			printf("0x%08lx\n", buckets[i].addr);
+	}
+	free(buckets);
+}
+
+static int do_prof(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	uint64_t period = PROF_DEFAULT_PERIOD_US *
+			  (cvmx_clock_get_rate(CVMX_CLOCK_CORE) / 1000000);
+	int top = PROF_DEFAULT_TOP;
+	int repeatable;
+	int rc;
+
+	if (argc >= 2 && !strcmp(argv[1], "show")) {
+		if (argc >= 3)
+			top = simple_strtoul(argv[2], NULL, 0);
+		prof_show(top);
+		return CMD_RET_SUCCESS;
+	}
+
+	argc--;
+	argv++;
+	while (argc >= 2 && argv[0][0] == '-') {
+		if (!strcmp(argv[0], "-p"))
+			period = simple_strtoull(argv[1], NULL, 0) *
+				 (cvmx_clock_get_rate(CVMX_CLOCK_CORE) / 1000000);
+		else if (!strcmp(argv[0], "-n"))
+			top = simple_strtoul(argv[1], NULL, 0);
+		else
+			return CMD_RET_USAGE;
+		argc -= 2;
+		argv += 2;
+	}
+	if (!argc || !period)
+		return CMD_RET_USAGE;
+
+	if (prof_start(period))
+		return CMD_RET_FAILURE;
+	rc = cmd_process(flag, argc, argv, &repeatable);
+	prof_stop();
+
+	prof_show(top);
+	return rc;
+}
+
+U_BOOT_CMD(prof, CONFIG_SYS_MAXARGS, 0, do_prof,
+	   "sample the program counter while running a command",
+	   "[-p usec] [-n entries] command [args...]\n"
+	   "    - run command, sampling every usec microseconds (default "
+	   "1000),\n"
+	   "      and print the functions with the most samples\n"
+	   "prof show [entries]\n"
+	   "    - print the histogram of the last run again\n\n"
+	   "Samples are only taken when the command waits with udelay() or\n"
+	   "get_timer(); time spent elsewhere is charged to the next caller\n"
+	   "of one of these.");
@@ -16,4 +16,20 @@ static inline int is_little_endian_elf(unsigned long addr)
 	return ((Elf32_Ehdr *)addr)->e_ident[EI_DATA] == ELFDATA2LSB;
 }
 
+/** Size of the header window kept by the streaming ELF loader */
+#define ELF64_STREAM_HDR_SIZE	4096
+
+/** State of the streaming ELF64 loader used for compressed images */
+struct elf64_stream {
+	unsigned char hdr[ELF64_STREAM_HDR_SIZE]; /** ELF and program headers */
+	unsigned long hdr_len;		/** bytes valid in hdr */
+	uint64_t pos;			/** image offset of the next byte */
+	uint64_t load_override;		/** as for load_elf64_image() */
+};
+
+int elf64_stream_hdr_sink(void *priv, const void *buf, unsigned long len);
+int elf64_stream_load_sink(void *priv, const void *buf, unsigned long len);
+int elf64_stream_valid(struct elf64_stream *es, unsigned long addr);
+u64 elf64_stream_finish(struct elf64_stream *es);
+
 #endif
@@ -72,6 +72,7 @@ int do_reset (cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 	extern void hw_watchdog_disable(void);
 	hw_watchdog_disable();
 #endif
+	octeon_serial_flush();
 	cvmx_write_csr (CVMX_CIU_SOFT_RST, 1ull);
 
 	fprintf (stderr, "*** reset failed ***\n");
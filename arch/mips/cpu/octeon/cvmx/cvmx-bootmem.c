@@ -145,6 +145,30 @@ static CVMX_SHARED uint64_t cvmx_bootmem_desc_addr = 0;
 		offsetof(cvmx_bootmem_named_block_desc_t, field),	\
 		SIZEOF_FIELD(cvmx_bootmem_named_block_desc_t, field), value)
 
+/**
+ * These macros read and write members of the
+ * cvmx_bootmem_named_index_t structure at physical address "addr",
+ * the same way as the named block macros above.
+ */
+#define CVMX_BOOTMEM_INDEX_GET_FIELD(addr, field)			\
+	__cvmx_bootmem_desc_get(addr,					\
+		offsetof(cvmx_bootmem_named_index_t, field),		\
+		SIZEOF_FIELD(cvmx_bootmem_named_index_t, field))
+
+#define CVMX_BOOTMEM_INDEX_SET_FIELD(addr, field, value)		\
+	__cvmx_bootmem_desc_set(addr,					\
+		offsetof(cvmx_bootmem_named_index_t, field),		\
+		SIZEOF_FIELD(cvmx_bootmem_named_index_t, field), value)
+
+#define CVMX_BOOTMEM_INDEX_GET_BUCKET(addr, b)				\
+	__cvmx_bootmem_desc_get(addr,					\
+		offsetof(cvmx_bootmem_named_index_t, bucket) + 4 * (b), 4)
+
+#define CVMX_BOOTMEM_INDEX_SET_BUCKET(addr, b, value)			\
+	__cvmx_bootmem_desc_set(addr,					\
+		offsetof(cvmx_bootmem_named_index_t, bucket) + 4 * (b), 4, \
+		value)
+
 /**
  * This function is the implementation of the get macros defined
  * for individual structure members. The argument are generated
@@ -295,6 +319,224 @@ void CVMX_BOOTMEM_NAMED_SET_NAME(uint64_t addr, const char *str, int len)
 #endif
 }
 
+/**
+ * Hash a named block name.  At most len characters are used, which
+ * for names being stored must be the name length less one so the hash
+ * matches the truncated name CVMX_BOOTMEM_NAMED_SET_NAME() writes.
+ */
+static uint32_t __cvmx_bootmem_name_hash(const char *name, int len)
+{
+	uint32_t hash = 2166136261u;
+
+	while (len-- && *name) {
+		hash ^= (uint8_t)*name++;
+		hash *= 16777619;
+	}
+	return hash;
+}
+
+/**
+ * Returns the physical address of named block descriptor "slot"
+ */
+static inline uint64_t __cvmx_bootmem_named_slot_addr(int slot)
+{
+	return CVMX_BOOTMEM_DESC_GET_FIELD(named_block_array_addr) +
+	       slot * sizeof(cvmx_bootmem_named_block_desc_t);
+}
+
+static void __cvmx_bootmem_index_insert(uint64_t index, int slot,
+					const char *name, int name_length)
+{
+	uint32_t mask = CVMX_BOOTMEM_INDEX_GET_FIELD(index, num_buckets) - 1;
+	uint32_t hash = __cvmx_bootmem_name_hash(name, name_length - 1);
+	uint32_t b, n, v;
+
+	for (n = 0, b = hash & mask; n <= mask; n++, b = (b + 1) & mask) {
+		v = CVMX_BOOTMEM_INDEX_GET_BUCKET(index, b);
+		if (v == CVMX_BOOTMEM_INDEX_DELETED)
+			CVMX_BOOTMEM_INDEX_SET_FIELD(index, num_deleted,
+				CVMX_BOOTMEM_INDEX_GET_FIELD(index,
+							     num_deleted) - 1);
+		else if (v)
+			continue;
+		CVMX_BOOTMEM_INDEX_SET_BUCKET(index, b,
+					      (hash & 0xffff0000) | (slot + 1));
+		return;
+	}
+}
+
+/**
+ * Recreate the index from the named block array.  Used when the index
+ * is found to be out of date or has collected too many deleted entries.
+ */
+static void __cvmx_bootmem_index_rebuild(uint64_t index)
+{
+	int num_blocks = CVMX_BOOTMEM_DESC_GET_FIELD(named_block_num_blocks);
+	int name_length = CVMX_BOOTMEM_DESC_GET_FIELD(named_block_name_len);
+	uint32_t num_buckets = CVMX_BOOTMEM_INDEX_GET_FIELD(index, num_buckets);
+	uint64_t named_addr = __cvmx_bootmem_named_slot_addr(0);
+	int first_free = num_blocks;
+	char name_tmp[name_length + 1];
+	uint32_t b;
+	int i;
+
+#ifdef DEBUG
+	cvmx_dprintf("Rebuilding bootmem named block index at 0x%llx\n",
+		     (ULL) index);
+#endif
+	for (b = 0; b < num_buckets; b++)
+		CVMX_BOOTMEM_INDEX_SET_BUCKET(index, b, 0);
+	CVMX_BOOTMEM_INDEX_SET_FIELD(index, num_deleted, 0);
+
+	for (i = 0; i < num_blocks; i++) {
+		if (CVMX_BOOTMEM_NAMED_GET_FIELD(named_addr, size)) {
+			CVMX_BOOTMEM_NAMED_GET_NAME(named_addr, name_tmp,
+						    name_length);
+			__cvmx_bootmem_index_insert(index, i, name_tmp,
+						    name_length);
+		} else if (first_free == num_blocks) {
+			first_free = i;
+		}
+		named_addr += sizeof(cvmx_bootmem_named_block_desc_t);
+	}
+	CVMX_BOOTMEM_INDEX_SET_FIELD(index, first_free, first_free);
+}
+
+/**
+ * Returns the address of the named block index, or zero if the
+ * descriptor doesn't have one and the array must be searched.
+ *
+ * Code built before the index existed still allocates the lowest free
+ * array entry but doesn't update the index.  If that entry is in use,
+ * the index is stale and is rebuilt here.
+ */
+static uint64_t __cvmx_bootmem_named_index_get(void)
+{
+	uint64_t index;
+	int first_free;
+
+	if (CVMX_BOOTMEM_DESC_GET_FIELD(minor_version) <
+	    CVMX_BOOTMEM_DESC_MIN_VER_INDEX)
+		return 0;
+	index = CVMX_BOOTMEM_DESC_GET_FIELD(named_block_index_addr);
+	if (!index ||
+	    CVMX_BOOTMEM_INDEX_GET_FIELD(index, magic) !=
+	    CVMX_BOOTMEM_INDEX_MAGIC)
+		return 0;
+
+	first_free = CVMX_BOOTMEM_INDEX_GET_FIELD(index, first_free);
+	if (first_free < CVMX_BOOTMEM_DESC_GET_FIELD(named_block_num_blocks) &&
+	    CVMX_BOOTMEM_NAMED_GET_FIELD(__cvmx_bootmem_named_slot_addr(first_free),
+					 size))
+		__cvmx_bootmem_index_rebuild(index);
+	return index;
+}
+
+/**
+ * Look up a name in the index.
+ *
+ * @param index  Index address from __cvmx_bootmem_named_index_get()
+ * @param name   Name to find
+ * @param stale  Set to 1 if an entry for a freed block was seen
+ *
+ * @return Physical address of the named block descriptor, zero if not found
+ */
+static uint64_t __cvmx_bootmem_index_lookup(uint64_t index, const char *name,
+					    int *stale)
+{
+	int num_blocks = CVMX_BOOTMEM_DESC_GET_FIELD(named_block_num_blocks);
+	int name_length = CVMX_BOOTMEM_DESC_GET_FIELD(named_block_name_len);
+	uint32_t mask = CVMX_BOOTMEM_INDEX_GET_FIELD(index, num_buckets) - 1;
+	uint32_t hash = __cvmx_bootmem_name_hash(name, name_length);
+	char name_tmp[name_length + 1];
+	uint64_t named_addr;
+	uint32_t b, n, v;
+	int slot;
+
+	for (n = 0, b = hash & mask; n <= mask; n++, b = (b + 1) & mask) {
+		v = CVMX_BOOTMEM_INDEX_GET_BUCKET(index, b);
+		if (!v)
+			break;
+		if (v == CVMX_BOOTMEM_INDEX_DELETED ||
+		    (v & 0xffff0000) != (hash & 0xffff0000))
+			continue;
+		slot = (v & 0xffff) - 1;
+		if (slot >= num_blocks) {
+			*stale = 1;
+			break;
+		}
+		named_addr = __cvmx_bootmem_named_slot_addr(slot);
+		if (!CVMX_BOOTMEM_NAMED_GET_FIELD(named_addr, size)) {
+			*stale = 1;
+			continue;
+		}
+		CVMX_BOOTMEM_NAMED_GET_NAME(named_addr, name_tmp, name_length);
+		if (!strncmp(name, name_tmp, name_length))
+			return named_addr;
+	}
+	return 0;
+}
+
+/**
+ * Update the index after named block "slot" has been allocated
+ */
+static void __cvmx_bootmem_index_add(uint64_t index, int slot,
+				     const char *name)
+{
+	int num_blocks = CVMX_BOOTMEM_DESC_GET_FIELD(named_block_num_blocks);
+	uint64_t named_addr;
+	int first_free;
+
+	__cvmx_bootmem_index_insert(index, slot, name,
+			CVMX_BOOTMEM_DESC_GET_FIELD(named_block_name_len));
+
+	first_free = CVMX_BOOTMEM_INDEX_GET_FIELD(index, first_free);
+	if (slot != first_free)
+		return;
+	named_addr = __cvmx_bootmem_named_slot_addr(++first_free);
+	while (first_free < num_blocks &&
+	       CVMX_BOOTMEM_NAMED_GET_FIELD(named_addr, size)) {
+		first_free++;
+		named_addr += sizeof(cvmx_bootmem_named_block_desc_t);
+	}
+	CVMX_BOOTMEM_INDEX_SET_FIELD(index, first_free, first_free);
+}
+
+/**
+ * Update the index after named block "slot" has been freed
+ */
+static void __cvmx_bootmem_index_del(uint64_t index, int slot,
+				     const char *name)
+{
+	uint32_t num_buckets = CVMX_BOOTMEM_INDEX_GET_FIELD(index, num_buckets);
+	uint32_t mask = num_buckets - 1;
+	uint32_t hash = __cvmx_bootmem_name_hash(name,
+		CVMX_BOOTMEM_DESC_GET_FIELD(named_block_name_len) - 1);
+	uint32_t num_deleted;
+	uint32_t b, n, v;
+
+	for (n = 0, b = hash & mask; n <= mask; n++, b = (b + 1) & mask) {
+		v = CVMX_BOOTMEM_INDEX_GET_BUCKET(index, b);
+		if (!v)
+			break;
+		if (v == (hash & 0xffff0000) + slot + 1) {
+			CVMX_BOOTMEM_INDEX_SET_BUCKET(index, b,
+						CVMX_BOOTMEM_INDEX_DELETED);
+			num_deleted = CVMX_BOOTMEM_INDEX_GET_FIELD(index,
+							num_deleted) + 1;
+			CVMX_BOOTMEM_INDEX_SET_FIELD(index, num_deleted,
+						     num_deleted);
+			if (num_deleted > num_buckets / 4) {
+				__cvmx_bootmem_index_rebuild(index);
+				return;
+			}
+			break;
+		}
+	}
+	if (slot < (int)CVMX_BOOTMEM_INDEX_GET_FIELD(index, first_free))
+		CVMX_BOOTMEM_INDEX_SET_FIELD(index, first_free, slot);
+}
+
 /* See header file for descriptions of functions */
 
 /*
@@ -743,15 +985,21 @@ int64_t cvmx_bootmem_phy_alloc(uint64_t req_size, uint64_t address_min,
 	while (ent_addr) {
 		uint64_t usable_base, usable_max;
 		uint64_t ent_size = cvmx_bootmem_phy_get_size(ent_addr);
+		uint64_t ent_next = cvmx_bootmem_phy_get_next(ent_addr);
 
-		if (cvmx_bootmem_phy_get_next(ent_addr)
-		    && ent_addr > cvmx_bootmem_phy_get_next(ent_addr)) {
+		if (ent_next && ent_addr > ent_next) {
 			cvmx_dprintf("Internal bootmem_alloc() error: ent: 0x%llx, next: 0x%llx\n",
-				     (ULL)ent_addr,
-				     (ULL)cvmx_bootmem_phy_get_next(ent_addr));
+				     (ULL)ent_addr, (ULL)ent_next);
 			goto error_out;
 		}
 
+		/*
+		 * The list is sorted by address, so nothing from here on
+		 * can be below address_max.
+		 */
+		if (ent_addr >= address_max)
+			break;
+
 		/*
 		 * Determine if this is an entry that can satisify the
 		 * request Check to make sure entry is large enough to
@@ -1009,11 +1257,39 @@ uint64_t cvmx_bootmem_phy_available_mem(uint64_t min_block_size)
 uint64_t cvmx_bootmem_phy_named_block_find(const char *name, uint32_t flags)
 {
 	uint64_t result = 0;
+	uint64_t index = 0;
+	int stale = 0;
 
 #ifdef DEBUG
 	cvmx_dprintf("cvmx_bootmem_phy_named_block_find: %s\n", name);
 #endif
 	__cvmx_bootmem_lock(flags);
+	if (!__cvmx_bootmem_check_version(3) &&
+	    (index = __cvmx_bootmem_named_index_get())) {
+		int num_blocks =
+			CVMX_BOOTMEM_DESC_GET_FIELD(named_block_num_blocks);
+		int first_free = CVMX_BOOTMEM_INDEX_GET_FIELD(index,
+							      first_free);
+
+		if (name) {
+			result = __cvmx_bootmem_index_lookup(index, name,
+							     &stale);
+			if (result) {
+				__cvmx_bootmem_unlock(flags);
+				return result;
+			}
+			/*
+			 * A miss is only a hint: old code may have freed a
+			 * block and reused its slot under another name
+			 * without updating the index, so confirm it with
+			 * the linear scan below.
+			 */
+		} else if (first_free < num_blocks) {
+			__cvmx_bootmem_unlock(flags);
+			return __cvmx_bootmem_named_slot_addr(first_free);
+		}
+		/* Table looks full, check in case old code freed a block */
+	}
 	if (!__cvmx_bootmem_check_version(3)) {
 		int i;
 		uint64_t named_block_array_addr =
@@ -1042,6 +1318,9 @@ uint64_t cvmx_bootmem_phy_named_block_find(const char *name, uint32_t flags)
 			}
 			named_addr += sizeof(cvmx_bootmem_named_block_desc_t);
 		}
+		/* The scan found a block the index missed */
+		if (index && name && (result || stale))
+			__cvmx_bootmem_index_rebuild(index);
 	}
 	__cvmx_bootmem_unlock(flags);
 	return result;
@@ -1050,6 +1329,7 @@ uint64_t cvmx_bootmem_phy_named_block_find(const char *name, uint32_t flags)
 int cvmx_bootmem_phy_named_block_free(const char *name, uint32_t flags)
 {
 	uint64_t named_block_addr;
+	uint64_t index;
 
 	if (__cvmx_bootmem_check_version(3))
 		return 0;
@@ -1079,6 +1359,12 @@ int cvmx_bootmem_phy_named_block_free(const char *name, uint32_t flags)
 					CVMX_BOOTMEM_FLAG_NO_LOCKING);
 		/* Set size to zero to indicate block not used. */
 		CVMX_BOOTMEM_NAMED_SET_FIELD(named_block_addr, size, 0);
+		index = __cvmx_bootmem_named_index_get();
+		if (index)
+			__cvmx_bootmem_index_del(index,
+				(named_block_addr -
+				 __cvmx_bootmem_named_slot_addr(0)) /
+				sizeof(cvmx_bootmem_named_block_desc_t), name);
 	}
 	__cvmx_bootmem_unlock(flags);
 	return !!named_block_addr;	/* 0 on failure, 1 on success */
@@ -1091,6 +1377,7 @@ int64_t cvmx_bootmem_phy_named_block_alloc(uint64_t size, uint64_t min_addr,
 {
 	int64_t addr_allocated;
 	uint64_t named_block_desc_addr;
+	uint64_t index;
 
 #ifdef DEBUG
 	cvmx_dprintf("cvmx_bootmem_phy_named_block_alloc: size: 0x%llx, min: 0x%llx, max: 0x%llx, align: 0x%llx, name: %s\n",
@@ -1134,11 +1421,18 @@ int64_t cvmx_bootmem_phy_named_block_alloc(uint64_t size, uint64_t min_addr,
 					alignment,
 					flags | CVMX_BOOTMEM_FLAG_NO_LOCKING);
 	if (addr_allocated >= 0) {
+		/* Before the new entry makes the index look stale */
+		index = __cvmx_bootmem_named_index_get();
 		CVMX_BOOTMEM_NAMED_SET_FIELD(named_block_desc_addr, base_addr,
 					     addr_allocated);
 		CVMX_BOOTMEM_NAMED_SET_FIELD(named_block_desc_addr, size, size);
 		CVMX_BOOTMEM_NAMED_SET_NAME(named_block_desc_addr, name,
 			CVMX_BOOTMEM_DESC_GET_FIELD(named_block_name_len));
+		if (index)
+			__cvmx_bootmem_index_add(index,
+				(named_block_desc_addr -
+				 __cvmx_bootmem_named_slot_addr(0)) /
+				sizeof(cvmx_bootmem_named_block_desc_t), name);
 	}
 
 	__cvmx_bootmem_unlock(flags);
@@ -1189,6 +1483,7 @@ int64_t cvmx_bootmem_phy_mem_list_init(uint64_t mem_size,
 {
 	uint64_t cur_block_addr;
 	int64_t addr;
+	int num_buckets;
 	int i;
 
 #ifdef DEBUG
@@ -1262,6 +1557,7 @@ frees_done:
 	CVMX_BOOTMEM_DESC_SET_FIELD(named_block_num_blocks,
 				    CVMX_BOOTMEM_NUM_NAMED_BLOCKS);
 	CVMX_BOOTMEM_DESC_SET_FIELD(named_block_array_addr, 0);
+	CVMX_BOOTMEM_DESC_SET_FIELD(named_block_index_addr, 0);
 
 	/* Allocate this near the top of the low 256 MBytes of memory */
 	addr = cvmx_bootmem_phy_alloc(CVMX_BOOTMEM_NUM_NAMED_BLOCKS *
@@ -1285,6 +1581,29 @@ frees_done:
 		addr += sizeof(cvmx_bootmem_named_block_desc_t);
 	}
 
+	/*
+	 * Hash index for the named blocks, with at least twice as many
+	 * buckets as blocks.  Lookups fall back to searching the array if
+	 * this can't be allocated.
+	 */
+	num_buckets = 1;
+	while (num_buckets < 2 * CVMX_BOOTMEM_NUM_NAMED_BLOCKS)
+		num_buckets <<= 1;
+	addr = cvmx_bootmem_phy_alloc(sizeof(cvmx_bootmem_named_index_t) +
+				      num_buckets * sizeof(uint32_t),
+				      0, 0x10000000, 0,
+				      CVMX_BOOTMEM_FLAG_END_ALLOC);
+	if (addr > 0 && CVMX_BOOTMEM_NUM_NAMED_BLOCKS < 0xffff) {
+		CVMX_BOOTMEM_INDEX_SET_FIELD(addr, magic,
+					     CVMX_BOOTMEM_INDEX_MAGIC);
+		CVMX_BOOTMEM_INDEX_SET_FIELD(addr, num_buckets, num_buckets);
+		CVMX_BOOTMEM_INDEX_SET_FIELD(addr, first_free, 0);
+		CVMX_BOOTMEM_INDEX_SET_FIELD(addr, num_deleted, 0);
+		for (i = 0; i < num_buckets; i++)
+			CVMX_BOOTMEM_INDEX_SET_BUCKET(addr, i, 0);
+		CVMX_BOOTMEM_DESC_SET_FIELD(named_block_index_addr, addr);
+	}
+
 	return 1;
 }
 
@@ -81,6 +81,10 @@
 #define NAND_COMMAND_STATUS             0x70
 #define NAND_COMMAND_READ               0x00
 #define NAND_COMMAND_READ_FIN           0x30
+#define NAND_COMMAND_READ_CACHE_SEQ     0x31
+#define NAND_COMMAND_READ_CACHE_END     0x3f
+#define NAND_COMMAND_CHANGE_READ_COL    0x05
+#define NAND_COMMAND_CHANGE_READ_COL_FIN 0xe0
 #define NAND_COMMAND_ERASE              0x60
 #define NAND_COMMAND_ERASE_FIN          0xd0
 #define NAND_COMMAND_PROGRAM            0x80
@@ -128,6 +132,7 @@ static const onfi_speed_mode_desc_t onfi_speed_modes[] = {
 
 typedef enum {
 	CVMX_NAND_STATE_16BIT = 1 << 0,
+	CVMX_NAND_STATE_READ_CACHE = 1 << 1,	/* Supports READ CACHE SEQUENTIAL/END */
 } cvmx_nand_state_flags_t;
 
 /**
@@ -636,6 +641,8 @@ cvmx_nand_status_t cvmx_nand_initialize(cvmx_nand_initialize_flags_t flags, int
 				cvmx_nand_state[chip].oob_size = cvmx_le16_to_cpu(onfi_param_page->page_spare_bytes);
 				cvmx_nand_state[chip].pages_per_block = cvmx_le32_to_cpu(onfi_param_page->pages_per_block);
 				cvmx_nand_state[chip].blocks = cvmx_le32_to_cpu(onfi_param_page->blocks_per_lun) * onfi_param_page->number_lun;
+				if (cvmx_le16_to_cpu(onfi_param_page->optional_commands) & 0x2)
+					cvmx_nand_state[chip].flags |= CVMX_NAND_STATE_READ_CACHE;
 
 				if (cvmx_le16_to_cpu(onfi_param_page->timing_mode) <= 0x3f) {
 					int mode_mask = cvmx_le16_to_cpu(onfi_param_page->timing_mode);
@@ -1276,6 +1283,150 @@ int cvmx_nand_page_read(int chip, uint64_t nand_address, uint64_t buffer_address
 
 EXPORT_SYMBOL(cvmx_nand_page_read);
 
+/**
+ * Read from another column of the page most recently loaded by
+ * cvmx_nand_page_read(), using the ONFI CHANGE READ COLUMN command.  This
+ * does not reload the page from the array, so it is much cheaper than a
+ * second cvmx_nand_page_read() of the same page.
+ *
+ * @param chip   Chip select for NAND flash
+ * @param column Byte offset within the page to start reading from
+ * @param buffer_address
+ *               Physical address to store the result at
+ * @param buffer_length
+ *               Number of bytes to read
+ *
+ * @return Bytes read on success, a negative cvmx_nand_status_t error code on failure
+ */
+int cvmx_nand_page_read_column(int chip, int column, uint64_t buffer_address, int buffer_length)
+{
+	int bytes;
+
+	CVMX_NAND_LOG_CALLED();
+	CVMX_NAND_LOG_PARAM("%d", chip);
+	CVMX_NAND_LOG_PARAM("%d", column);
+	CVMX_NAND_LOG_PARAM("0x%llx", (ULL) buffer_address);
+	CVMX_NAND_LOG_PARAM("%d", buffer_length);
+
+	if ((chip < 0) || (chip > 7))
+		CVMX_NAND_RETURN(CVMX_NAND_INVALID_PARAM);
+	if (!cvmx_nand_state[chip].page_size)
+		CVMX_NAND_RETURN(CVMX_NAND_INVALID_PARAM);
+	if ((column < 0) || (column >= cvmx_nand_state[chip].page_size + cvmx_nand_state[chip].oob_size))
+		CVMX_NAND_RETURN(CVMX_NAND_INVALID_PARAM);
+
+	/* For 16 bit mode, addresses within a page are word address, rather than byte addresses */
+	if (cvmx_nand_state[chip].flags & CVMX_NAND_STATE_16BIT)
+		column >>= 1;
+
+	bytes = __cvmx_nand_low_level_read(chip, NAND_COMMAND_CHANGE_READ_COL, (__cvmx_nand_get_column_bits(chip) + 7) >> 3, column, NAND_COMMAND_CHANGE_READ_COL_FIN, buffer_address, buffer_length);
+	CVMX_NAND_RETURN(bytes);
+}
+
+EXPORT_SYMBOL(cvmx_nand_page_read_column);
+
+/**
+ * Read a number of consecutive pages from NAND.  Each page is read from
+ * column zero and stored buffer_length bytes after the previous one, so
+ * the out of band data is included if buffer_length allows it.
+ *
+ * If the chip supports the ONFI read cache commands, READ CACHE SEQUENTIAL
+ * is used so the array read of each page overlaps with the transfer of
+ * the previous one.  Cache reads never cross a block boundary.  Chips
+ * without cache read support fall back to one cvmx_nand_page_read() per
+ * page.
+ *
+ * @param chip   Chip select for NAND flash
+ * @param nand_address
+ *               Page aligned location in NAND to start reading from
+ * @param buffer_address
+ *               Physical address to store the first page at
+ * @param buffer_length
+ *               Number of bytes to read from each page
+ * @param pages  Number of pages to read
+ *
+ * @return Total bytes read on success, a negative cvmx_nand_status_t error code on failure
+ */
+int cvmx_nand_page_read_multi(int chip, uint64_t nand_address, uint64_t buffer_address, int buffer_length, int pages)
+{
+	int page_size;
+	int pages_per_block;
+	int total = 0;
+
+	CVMX_NAND_LOG_CALLED();
+	CVMX_NAND_LOG_PARAM("%d", chip);
+	CVMX_NAND_LOG_PARAM("0x%llx", (ULL) nand_address);
+	CVMX_NAND_LOG_PARAM("0x%llx", (ULL) buffer_address);
+	CVMX_NAND_LOG_PARAM("%d", buffer_length);
+	CVMX_NAND_LOG_PARAM("%d", pages);
+
+	if ((chip < 0) || (chip > 7))
+		CVMX_NAND_RETURN(CVMX_NAND_INVALID_PARAM);
+	page_size = cvmx_nand_state[chip].page_size;
+	pages_per_block = cvmx_nand_state[chip].pages_per_block;
+	if (!page_size || !pages_per_block)
+		CVMX_NAND_RETURN(CVMX_NAND_INVALID_PARAM);
+	if (nand_address & (page_size - 1))
+		CVMX_NAND_RETURN(CVMX_NAND_INVALID_PARAM);
+	if (!buffer_address || (buffer_address & 7))
+		CVMX_NAND_RETURN(CVMX_NAND_INVALID_PARAM);
+	if (!buffer_length || (buffer_length & 7))
+		CVMX_NAND_RETURN(CVMX_NAND_INVALID_PARAM);
+	if (pages < 1)
+		CVMX_NAND_RETURN(CVMX_NAND_INVALID_PARAM);
+
+	while (pages) {
+		/* Number of pages left in this block */
+		int run = pages_per_block - (int)((nand_address / page_size) % pages_per_block);
+		int i;
+
+		if (run > pages)
+			run = pages;
+
+		if ((run == 1) || !(cvmx_nand_state[chip].flags & CVMX_NAND_STATE_READ_CACHE)) {
+			for (i = 0; i < run; i++) {
+				int bytes = cvmx_nand_page_read(chip, nand_address, buffer_address, buffer_length);
+				if (bytes != buffer_length)
+					CVMX_NAND_RETURN((bytes < 0) ? bytes : CVMX_NAND_ERROR);
+				nand_address += page_size;
+				buffer_address += buffer_length;
+				total += bytes;
+			}
+			pages -= run;
+			continue;
+		}
+
+		/* Load the first page into the data register */
+		if (__cvmx_nand_build_pre_cmd(chip, NAND_COMMAND_READ, __cvmx_nand_get_address_cycles(chip), nand_address, NAND_COMMAND_READ_FIN))
+			CVMX_NAND_RETURN(CVMX_NAND_NO_MEMORY);
+		if (__wait_for_busy_done(chip))
+			CVMX_NAND_RETURN(CVMX_NAND_NO_MEMORY);
+		if (__cvmx_nand_build_post_cmd())
+			CVMX_NAND_RETURN(CVMX_NAND_NO_MEMORY);
+
+		/* Each READ CACHE moves the loaded page to the cache register
+		 ** for output and starts loading the next one, except for the
+		 ** last which only moves the final page. */
+		for (i = 0; i < run; i++) {
+			int command = (i == run - 1) ? NAND_COMMAND_READ_CACHE_END : NAND_COMMAND_READ_CACHE_SEQ;
+			int bytes = __cvmx_nand_low_level_read(chip, command, 0, 0, 0, buffer_address, buffer_length);
+			if (bytes != buffer_length) {
+				/* Leave the chip in a known state */
+				cvmx_nand_reset(chip);
+				CVMX_NAND_RETURN((bytes < 0) ? bytes : CVMX_NAND_ERROR);
+			}
+			nand_address += page_size;
+			buffer_address += buffer_length;
+			total += bytes;
+		}
+		pages -= run;
+	}
+
+	CVMX_NAND_RETURN(total);
+}
+
+EXPORT_SYMBOL(cvmx_nand_page_read_multi);
+
 /**
  * Write a page to NAND. The buffer must contain the entire page
  * including the out of band data.
@@ -1579,6 +1730,26 @@ int cvmx_nand_get_pages_per_block(int chip)
 	CVMX_NAND_RETURN(cvmx_nand_state[chip].pages_per_block);
 }
 
+/**
+ * Check if a NAND chip supports the ONFI read cache commands used by
+ * cvmx_nand_page_read_multi()
+ *
+ * @param chip   Chip select for NAND flash
+ *
+ * @return One if supported, zero if not, or a negative cvmx_nand_status_t
+ *         error code on failure
+ */
+int cvmx_nand_has_read_cache(int chip)
+{
+	CVMX_NAND_LOG_CALLED();
+	CVMX_NAND_LOG_PARAM("%d", chip);
+
+	if ((chip < 0) || (chip > 7))
+		CVMX_NAND_RETURN(CVMX_NAND_INVALID_PARAM);
+
+	CVMX_NAND_RETURN(!!(cvmx_nand_state[chip].flags & CVMX_NAND_STATE_READ_CACHE));
+}
+
 /**
  * Get the number of blocks in the NAND flash
  *
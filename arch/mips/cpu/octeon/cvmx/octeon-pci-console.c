@@ -529,6 +529,20 @@ int octeon_pci_console_read_avail(uint64_t console_desc_addr,
 /* This code can only be used in the bootloader */
 #if defined(__U_BOOT__) && (defined(CFG_PCI_CONSOLE) || defined(CONFIG_SYS_PCI_CONSOLE))
 uint64_t octeon_pci_console_init(int num_consoles, int buffer_size)
+{
+	return octeon_pci_console_init_named(OCTEON_PCI_CONSOLE_BLOCK_NAME,
+					     num_consoles, buffer_size);
+}
+
+/**
+ * Allocate and initialize a set of consoles in the named block 'name'.
+ * Besides the regular PCI console this is used for the bulk data channel,
+ * which uses the same ring layout with much larger buffers.
+ *
+ * @return physical address of the console descriptor, 0 on failure
+ */
+uint64_t octeon_pci_console_init_named(const char *name, int num_consoles,
+				       int buffer_size)
 {
 	octeon_pci_console_desc_t *cons_desc_ptr;
 	octeon_pci_console_t *cons_ptr;
@@ -548,20 +562,20 @@ uint64_t octeon_pci_console_init(int num_consoles, int buffer_size)
 		cvmx_bootmem_phy_named_block_alloc(alloc_size,
 					OCTEON_DDR0_SIZE - alloc_size - 128,
       					OCTEON_DDR0_SIZE, 128,
-	    				OCTEON_PCI_CONSOLE_BLOCK_NAME,
+	    				name,
 	  				CVMX_BOOTMEM_FLAG_END_ALLOC);
 	if (console_block_addr < 0)
 		console_block_addr =
 		    cvmx_bootmem_phy_named_block_alloc(alloc_size,
 					OCTEON_DDR2_BASE + 1,
      					OCTEON_DDR2_BASE + alloc_size + 128,
-	   				128, OCTEON_PCI_CONSOLE_BLOCK_NAME,
+	   				128, name,
 					CVMX_BOOTMEM_FLAG_END_ALLOC);
 	if (console_block_addr < 0)
 		console_block_addr =
 			cvmx_bootmem_phy_named_block_alloc(alloc_size, 0,
 						0x7fffffff, 128,
-	   					OCTEON_PCI_CONSOLE_BLOCK_NAME,
+	   					name,
 	  					CVMX_BOOTMEM_FLAG_END_ALLOC);
 	if (console_block_addr < 0)
 		return 0;
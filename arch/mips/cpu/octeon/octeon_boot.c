@@ -52,6 +52,7 @@
 # include <asm/arch/cvmx-bootmem.h>
 # include <asm/arch/cvmx-sysinfo.h>
 # include <asm/arch/octeon_boot.h>
+# include <asm/arch/octeon_l2_lock.h>
 # include <asm/arch/cvmx-coremask.h>
 
 /************************************************************************/
@@ -1666,6 +1667,12 @@ void start_cores(uint32_t coremask_to_start)
 	dprintf("Bootloader: Starting app at cycle: %d\n",
 		(uint32_t) boot_cycle_adjustment);
 
+#ifdef CONFIG_CMD_OCTEON_PERF
+	octeon_perf_boot();
+#endif
+	/* Nothing may be left in the console queue once the app runs */
+	octeon_serial_flush();
+
 	boot_cycle_adjustment = octeon_get_cycles();
 	OCTEON_SYNC;
 
@@ -1690,6 +1697,72 @@ void start_cores(uint32_t coremask_to_start)
 	 (((boot_init_vector_t *) (BOOT_VECTOR_BASE))[0].app_start_func_addr)) ();
 }
 
+/*
+ * Running bootloader functions on idle cores.
+ *
+ * An idle core is started the same way as for an application: its boot
+ * vector is pointed at octeon_core_work_entry() and it is sent an NMI.
+ * The core sets up the bootloader TLB mapping in InitTLBStart, runs the
+ * function on its scratch (CVMSEG) stack and then waits, so a later
+ * start_cores() can still NMI it into an application.
+ *
+ * The function must not call malloc(), printf() or anything else that
+ * touches shared bootloader state; all memory it needs has to be handed
+ * to it by core 0.
+ */
+static struct {
+	void (*func)(void *arg);
+	void *arg;
+	volatile int done;
+} core_work[CVMX_MAX_CORES];
+
+static void octeon_core_work_entry(void)
+{
+	int core = get_core_num();
+
+	core_work[core].func(core_work[core].arg);
+	OCTEON_SYNCW;
+	core_work[core].done = 1;
+	OCTEON_SYNCW;
+
+	for (;;)
+		asm volatile ("wait");
+}
+
+/**
+ * Returns the mask of cores that can be given work: cores that are
+ * available, not this one and not already running an application.
+ */
+uint32_t octeon_core_work_mask(void)
+{
+	return octeon_get_available_coremask() & ~coremask_to_run &
+	       ~(1 << get_core_num());
+}
+
+/**
+ * Starts func(arg) on an idle core.  Poll octeon_core_work_done() to find
+ * out when it has returned.
+ */
+int octeon_core_work_start(int core, void (*func)(void *arg), void *arg)
+{
+	if (!(octeon_core_work_mask() & (1 << core)))
+		return -1;
+
+	core_work[core].func = func;
+	core_work[core].arg = arg;
+	core_work[core].done = 0;
+	octeon_setup_boot_vector((uint32_t)octeon_core_work_entry, 1 << core);
+	OCTEON_SYNCW;
+	cvmx_write_csr(CVMX_CIU_NMI, 1ull << core);
+
+	return 0;
+}
+
+int octeon_core_work_done(int core)
+{
+	return core_work[core].done;
+}
+
 void octeon_sync_cores(void)
 {
 	static uint32_t core_one = 0;
@@ -1798,11 +1871,15 @@ void octeon_restore_std_mips_config(void)
 	int usb_stop(void);
 	usb_stop();
 #endif
+	octeon_l2_unlock(OCTEON_L2_LOCK_ALL);
+
 	/* Disable CVMSEG */
 	/* Should entire register be set to default ? */
 	val = get_cop0_cvmmemctl_reg();
 	val &= ~0x1ffull;
 	set_cop0_cvmmemctl_reg(val);
+
+	octeon_serial_flush();
 }
 
 int octeon_bootloader_shutdown(void)
@@ -1821,11 +1898,13 @@ int octeon_bootloader_shutdown(void)
 	int usb_stop(void);
 	usb_stop();
 #endif
+	octeon_l2_unlock(OCTEON_L2_LOCK_ALL);
 
 	/* Free temp blocks last, as previous systems being shut down
 	 * may still rely on them
 	 */
 	octeon_free_tmp_named_blocks();
+	octeon_serial_flush();
 	return 0;
 }
 
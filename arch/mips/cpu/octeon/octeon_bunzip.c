@@ -0,0 +1,284 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Parallel bzip2 decompression.
+ *
+ * A bzip2 file made by pbzip2 (or by concatenating bzip2 files) is a
+ * series of independent byte-aligned streams.  Each stream is handed to
+ * an idle core, which decompresses it into its own bounce buffer; core 0
+ * copies the bounce buffers to the destination in stream order and sends
+ * a core back for more when its buffer filled before the stream ended.
+ *
+ * Stream starts are found by searching for the stream header followed by
+ * the first block magic.  A false match inside compressed data makes the
+ * stream before it fail its CRC or end early, in which case we return 1
+ * and the caller decompresses the streams one after the other on core 0.
+ */
+
+#include <common.h>
+#include <watchdog.h>
+#include <bzlib.h>
+#include <asm/arch/octeon_boot.h>
+#include <asm/arch/cvmx-bootmem.h>
+
+/* Per-core memory: bzip2 state for 900k blocks plus the bounce buffer */
+#define BUNZIP_ARENA_SIZE	(4 << 20)
+#define BUNZIP_BOUNCE_SIZE	(1 << 20)
+#define BUNZIP_MAX_STREAMS	1024
+/* A core gets at most one bounce buffer of output per run */
+#define BUNZIP_TIMEOUT_MS	10000
+
+struct bunzip_worker {
+	int core;
+	int stream;		/* stream being decompressed, -1 if idle */
+	int ret;		/* BZ2_bzDecompress() return value */
+	bz_stream strm;
+	uint64_t mem_phys;
+	char *arena;
+	unsigned int arena_used;
+	char *bounce;
+	unsigned int out_len;	/* bytes in bounce */
+};
+
+static unsigned int stream_start[BUNZIP_MAX_STREAMS];
+/* bz_internal_error() code of each worker core, reported by core 0 */
+static volatile int bunzip_error[CVMX_MAX_CORES];
+
+/*
+ * bzlib reports internal errors through here.  Worker cores must not
+ * touch the console, so they only record the error for core 0.
+ */
+void bz_internal_error(int errcode)
+{
+	int core = get_core_num();
+
+	if (core) {
+		bunzip_error[core] = errcode;
+		return;
+	}
+	printf("BZIP2 internal error %d\n", errcode);
+}
+
+/* Runs on core 0 and on the worker cores, but never on both at once */
+static void *bunzip_alloc(void *opaque, int items, int size)
+{
+	struct bunzip_worker *w = opaque;
+	unsigned int len = (items * size + 15) & ~15;
+	void *p;
+
+	if (w->arena_used + len > BUNZIP_ARENA_SIZE)
+		return NULL;
+	p = w->arena + w->arena_used;
+	w->arena_used += len;
+
+	return p;
+}
+
+static void bunzip_free(void *opaque, void *addr)
+{
+}
+
+/* Worker core: decompress until the bounce buffer is full or the stream ends */
+static void bunzip_worker_run(void *arg)
+{
+	struct bunzip_worker *w = arg;
+
+	bunzip_error[w->core] = 0;
+	w->strm.next_out = w->bounce;
+	w->strm.avail_out = BUNZIP_BOUNCE_SIZE;
+	w->ret = BZ2_bzDecompress(&w->strm);
+	w->out_len = BUNZIP_BOUNCE_SIZE - w->strm.avail_out;
+}
+
+/* Wait for a worker core, returns -1 if it does not finish in time */
+static int bunzip_wait(struct bunzip_worker *w)
+{
+	ulong start = get_timer(0);
+
+	while (!octeon_core_work_done(w->core)) {
+		WATCHDOG_RESET();
+		if (get_timer(start) > BUNZIP_TIMEOUT_MS) {
+			printf("bunzip: core %d timed out\n", w->core);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int bunzip_is_stream_start(const unsigned char *p)
+{
+	return p[0] == 'B' && p[1] == 'Z' && p[2] == 'h' &&
+	       p[3] >= '1' && p[3] <= '9' &&
+	       p[4] == 0x31 && p[5] == 0x41 && p[6] == 0x59 &&
+	       p[7] == 0x26 && p[8] == 0x53 && p[9] == 0x59;
+}
+
+static int bunzip_find_streams(const unsigned char *src, unsigned int src_len)
+{
+	unsigned int i;
+	int n = 0;
+
+	for (i = 0; i + 10 <= src_len; i++) {
+		if (bunzip_is_stream_start(src + i)) {
+			if (n == BUNZIP_MAX_STREAMS)
+				return 0;
+			stream_start[n++] = i;
+			/* the shortest stream is well over 10 bytes */
+			i += 9;
+		}
+	}
+	return (n && stream_start[0] == 0) ? n : 0;
+}
+
+static int bunzip_start_stream(struct bunzip_worker *w, char *src,
+			       unsigned int src_len, int stream, int nstreams)
+{
+	unsigned int end = (stream + 1 < nstreams) ?
+			   stream_start[stream + 1] : src_len;
+
+	memset(&w->strm, 0, sizeof(w->strm));
+	w->strm.bzalloc = bunzip_alloc;
+	w->strm.bzfree = bunzip_free;
+	w->strm.opaque = w;
+	w->arena_used = 0;
+	if (BZ2_bzDecompressInit(&w->strm, 0, 0) != BZ_OK)
+		return -1;
+
+	w->strm.next_in = src + stream_start[stream];
+	w->strm.avail_in = end - stream_start[stream];
+	if (octeon_core_work_start(w->core, bunzip_worker_run, w))
+		return -1;
+	w->stream = stream;
+
+	return 0;
+}
+
+/**
+ * Decompresses a multi-stream bzip2 image using all idle cores.
+ *
+ * @param dst      destination buffer
+ * @param dst_len  size of dst, set to the uncompressed size on success
+ * @param src      compressed image
+ * @param src_len  size of the compressed image
+ *
+ * @return 0 on success, 1 if the image has to be decompressed serially
+ */
+int octeon_bunzip(char *dst, unsigned int *dst_len, char *src,
+		  unsigned int src_len)
+{
+	struct bunzip_worker workers[CVMX_MAX_CORES];
+	uint32_t mask = octeon_core_work_mask();
+	int nstreams, nworkers = 0;
+	int next = 0, head = 0;
+	unsigned int out = 0;
+	int core, i, ret = 1;
+
+	nstreams = bunzip_find_streams((unsigned char *)src, src_len);
+	if (nstreams < 2 || !mask)
+		return 1;
+
+	/* The work mask, like coremask_to_run, only covers cores 0-31 */
+	for (core = 0; core < 32 && core < CVMX_MAX_CORES && nworkers < nstreams;
+	     core++) {
+		struct bunzip_worker *w = &workers[nworkers];
+		int64_t phys;
+
+		if (!(mask & (1 << core)))
+			continue;
+		phys = cvmx_bootmem_phy_alloc(BUNZIP_ARENA_SIZE +
+					      BUNZIP_BOUNCE_SIZE, 0,
+					      0x7fffffff, 128, 0);
+		if (phys < 0)
+			break;
+		w->core = core;
+		w->stream = -1;
+		w->mem_phys = phys;
+		w->arena = cvmx_phys_to_ptr(phys);
+		w->bounce = w->arena + BUNZIP_ARENA_SIZE;
+		nworkers++;
+	}
+	if (nworkers == 0)
+		return 1;
+
+	debug("bunzip: %d streams on %d cores\n", nstreams, nworkers);
+
+	while (head < nstreams) {
+		struct bunzip_worker *w = NULL;
+
+		/* Give idle cores the next streams */
+		for (i = 0; i < nworkers && next < nstreams; i++) {
+			if (workers[i].stream >= 0)
+				continue;
+			if (bunzip_start_stream(&workers[i], src, src_len,
+						next, nstreams))
+				goto out;
+			next++;
+		}
+
+		/* Drain the core holding the oldest unfinished stream */
+		for (i = 0; i < nworkers; i++)
+			if (workers[i].stream == head)
+				w = &workers[i];
+		if (bunzip_wait(w))
+			goto out;
+
+		if (bunzip_error[w->core]) {
+			printf("bunzip: core %d: BZIP2 internal error %d\n",
+			       w->core, bunzip_error[w->core]);
+			goto out;
+		}
+		if (w->ret != BZ_OK && w->ret != BZ_STREAM_END)
+			goto out;
+		if (w->out_len > *dst_len - out)
+			goto out;
+		memcpy(dst + out, w->bounce, w->out_len);
+		out += w->out_len;
+
+		if (w->ret == BZ_STREAM_END) {
+			/* A stream must end exactly where the next begins */
+			if (head + 1 < nstreams && w->strm.avail_in)
+				goto out;
+			w->stream = -1;
+			head++;
+		} else if (!w->strm.avail_in) {
+			/* Truncated stream */
+			goto out;
+		} else {
+			octeon_core_work_start(w->core, bunzip_worker_run, w);
+		}
+	}
+	*dst_len = out;
+	ret = 0;
+
+out:
+	/*
+	 * Let every core finish before its memory is given back.  A core
+	 * that hangs keeps its memory, it may still write to it.
+	 */
+	for (i = 0; i < nworkers; i++) {
+		if (workers[i].stream >= 0 && bunzip_wait(&workers[i]))
+			continue;
+		__cvmx_bootmem_phy_free(workers[i].mem_phys,
+					BUNZIP_ARENA_SIZE + BUNZIP_BOUNCE_SIZE,
+					0);
+	}
+	return ret;
+}
@@ -52,9 +52,122 @@
 #include <asm/arch/octeon-model.h>
 #include <cvmx-wqe.h>
 #include <asm/arch/octeon_eth.h>
+#include <asm/arch/octeon_fdt.h>
+#include <asm/arch/octeon_fdt_index.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* Index built by tools/mkfdtidx, absent on boards that don't link one */
+extern char __dtb_index_begin __attribute__((weak));
+extern char __dtb_index_end __attribute__((weak));
+
+/* Set once a node has been renamed, after which index misses mean nothing */
+static int fdt_index_renamed;
+
+/**
+ * Returns the index for fdt, or NULL if there is none or if the structure
+ * block has changed size since it was built (nodes or properties added or
+ * grown), which moves node offsets.  Deleting nodes with fdt_nop_node()
+ * and in-place property updates leave it usable.
+ */
+static const struct octeon_fdt_index_hdr *octeon_fdt_index(const void *fdt)
+{
+	const struct octeon_fdt_index_hdr *idx =
+		(const struct octeon_fdt_index_hdr *)&__dtb_index_begin;
+
+	if (!idx || &__dtb_index_end - &__dtb_index_begin < sizeof(*idx))
+		return NULL;
+	if (fdt32_to_cpu(idx->magic) != OCTEON_FDT_INDEX_MAGIC ||
+	    fdt32_to_cpu(idx->version) != OCTEON_FDT_INDEX_VERSION ||
+	    fdt32_to_cpu(idx->size_dt_struct) != fdt_size_dt_struct(fdt))
+		return NULL;
+	return idx;
+}
+
+/**
+ * Looks up a key in the index.
+ *
+ * @param fdt	device tree
+ * @param key	path, alias relative path or "&<phandle>"
+ * @param node	set to the node offset, or -FDT_ERR_NOTFOUND
+ *
+ * @return 1 if the index answered, 0 if the caller must search the tree
+ */
+static int octeon_fdt_index_lookup(const void *fdt, const char *key,
+				   int *node)
+{
+	const struct octeon_fdt_index_hdr *idx = octeon_fdt_index(fdt);
+	const struct octeon_fdt_index_entry *table;
+	const char *strings, *name;
+	uint32_t hash, mask, b, n;
+	int offset;
+
+	if (!idx)
+		return 0;
+
+	table = (const struct octeon_fdt_index_entry *)(idx + 1);
+	strings = (const char *)idx + fdt32_to_cpu(idx->strings_off);
+	mask = fdt32_to_cpu(idx->num_buckets) - 1;
+	hash = octeon_fdt_index_hash(key);
+
+	for (n = 0, b = hash & mask; n <= mask; n++, b = (b + 1) & mask) {
+		offset = (int32_t)fdt32_to_cpu(table[b].node);
+		if (offset < 0)
+			break;
+		if (fdt32_to_cpu(table[b].hash) != hash ||
+		    strcmp(strings + fdt32_to_cpu(table[b].key), key))
+			continue;
+		/* The node may have been deleted or renamed */
+		name = fdt_get_name(fdt, offset, NULL);
+		if (!name || strcmp(name, strings + fdt32_to_cpu(table[b].name)))
+			return 0;
+		*node = offset;
+		return 1;
+	}
+	if (fdt_index_renamed)
+		return 0;
+	*node = -FDT_ERR_NOTFOUND;
+	return 1;
+}
+
+int octeon_fdt_path_offset(const void *fdt, const char *path)
+{
+	const char *alias, *rest;
+	char buf[256];
+	int node;
+
+	if (octeon_fdt_index_lookup(fdt, path, &node))
+		return node;
+
+	if (*path == '/')
+		return fdt_path_offset(fdt, path);
+
+	/* Expand the alias */
+	rest = strchr(path, '/');
+	if (!rest)
+		rest = path + strlen(path);
+	alias = fdt_get_alias_namelen(fdt, path, rest - path);
+	if (!alias)
+		return -FDT_ERR_NOTFOUND;
+	if (!*rest)
+		return fdt_path_offset(fdt, alias);
+	if (snprintf(buf, sizeof(buf), "%s%s", alias, rest) >= sizeof(buf))
+		return -FDT_ERR_NOSPACE;
+	return fdt_path_offset(fdt, buf);
+}
+
+int octeon_fdt_node_offset_by_phandle(const void *fdt, uint32_t phandle)
+{
+	char key[12];
+	int node;
+
+	sprintf(key, "&%x", phandle);
+	if (octeon_fdt_index_lookup(fdt, key, &node) &&
+	    (node < 0 || fdt_get_phandle(fdt, node) == phandle))
+		return node;
+	return fdt_node_offset_by_phandle(fdt, phandle);
+}
+
 /**
  * Trims nodes from the flat device tree.
  *
@@ -173,7 +286,10 @@ int __octeon_fdt_patch(void *fdt, const char *fdt_key, const char *trim_name)
 				memcpy(new_name, name, len);
 				sprintf(new_name + len, "%x",
 					fdt32_to_cpu(*reg));
-				fdt_set_name(fdt, offset, new_name);
+				if (strcmp(name, new_name)) {
+					fdt_index_renamed = 1;
+					fdt_set_name(fdt, offset, new_name);
+				}
 			}
 			/* Structure may have changed, start at the beginning. */
 			next_offset = 0;
@@ -206,11 +322,10 @@ void octeon_fixup_fdt(void)
 
 void __octeon_fixup_fdt(void)
 {
-	const char *p;
 	int node, pip, interface, ethernet;
 	int i, e;
 	uint64_t mac;
-	char name[20];
+	char name[32];
 	uint32_t clk;
 	u64 sizes[3], addresses[3];
 	u64 size_left = gd->ram_size;
@@ -229,32 +344,24 @@ void __octeon_fixup_fdt(void)
 
 	for (i = 0; i < 2; i++) {
 		sprintf(name, "mix%x", i);
-		p = fdt_get_alias(working_fdt, name);
-		if (p) {
-			node = fdt_path_offset(working_fdt, p);
-			if (node <= 0)
-				continue;
-			octeon_set_one_fdt_mac(node, &mac);
-		}
+		node = octeon_fdt_path_offset(working_fdt, name);
+		if (node <= 0)
+			continue;
+		octeon_set_one_fdt_mac(node, &mac);
 	}
 
-	p = fdt_get_alias(working_fdt, "pip");
-	if (!p)
-		return;
-
-	pip = fdt_path_offset(working_fdt, p);
+	pip = octeon_fdt_path_offset(working_fdt, "pip");
 	if (pip <= 0)
 		return;
 
 	for (i = 0; i < 8; i++) {
-		sprintf(name, "interface@%d", i);
-		interface = fdt_subnode_offset(working_fdt, pip, name);
+		sprintf(name, "pip/interface@%d", i);
+		interface = octeon_fdt_path_offset(working_fdt, name);
 		if (interface <= 0)
 			continue;
 		for (e = 0; e < 16; e++) {
-			sprintf(name, "ethernet@%d", e);
-			ethernet = fdt_subnode_offset(working_fdt, interface,
-						      name);
+			sprintf(name, "pip/interface@%d/ethernet@%d", i, e);
+			ethernet = octeon_fdt_path_offset(working_fdt, name);
 			if (ethernet <= 0)
 				break;
 			octeon_set_one_fdt_mac(ethernet, &mac);
@@ -265,14 +372,11 @@ void __octeon_fixup_fdt(void)
 
 	for (i = 0; i < 2; i++) {
 		sprintf(name, "uart%x", i);
-		p = fdt_get_alias(working_fdt, name);
-		if (p) {
-			node = fdt_path_offset(working_fdt, p);
-			if (node <= 0)
-				continue;
-			fdt_setprop_inplace_cell(working_fdt, node,
-						 "clock-frequency", clk);
-		}
+		node = octeon_fdt_path_offset(working_fdt, name);
+		if (node <= 0)
+			continue;
+		fdt_setprop_inplace_cell(working_fdt, node,
+					 "clock-frequency", clk);
 	}
 	size_left = gd->ram_size;
 	sizes[num_addresses] = min(size_left, 256 * 1024 * 1024);
@@ -302,7 +406,7 @@ void __octeon_fixup_fdt(void)
 		}
 	}
 
-	node = fdt_path_offset(working_fdt, "/memory");
+	node = octeon_fdt_path_offset(working_fdt, "/memory");
 	if (node < 0)
 		node = fdt_add_subnode(working_fdt, 0, "memory");
 	if (node < 0) {
@@ -338,9 +442,7 @@ int board_fixup_fdt(void)
  */
 int octeon_fdt_find_phy(const struct eth_device *eth)
 {
-	int aliases;
 	void *fdt = gd->fdt_blob;
-	const char *pip_path;
 	int pip;
 	char buffer[64];
 	struct octeon_eth_info *oct_eth_info =
@@ -350,31 +452,22 @@ int octeon_fdt_find_phy(const struct eth_device *eth)
 	int phy;
 	uint32_t *phy_handle;
 
-	aliases = fdt_path_offset(fdt, "/aliases");
-	if (aliases < 0) {
-		puts("/aliases not found in device tree!\n");
-		return -1;
-	}
-	pip_path = fdt_getprop(fdt, aliases, "pip", NULL);
-	if (!pip_path) {
-		puts("pip not found in aliases in device tree\n");
-		return -1;
-	}
-	pip = fdt_path_offset(fdt, pip_path);
+	pip = octeon_fdt_path_offset(fdt, "pip");
 	if (pip < 0) {
 		puts("pip not found in device tree\n");
 		return -1;
 	}
-	snprintf(buffer, sizeof(buffer), "interface@%d"
-	, oct_eth_info->interface);
-	interface = fdt_subnode_offset(fdt, pip, buffer);
+	snprintf(buffer, sizeof(buffer), "pip/interface@%d",
+		 oct_eth_info->interface);
+	interface = octeon_fdt_path_offset(fdt, buffer);
 	if (interface < 0) {
 		printf("%s: interface@%d not found in device tree for %s\n",
 		       __func__, oct_eth_info->interface, eth->name);
 		return -1;
 	}
-	snprintf(buffer, sizeof(buffer), "ethernet@%x", oct_eth_info->index);
-	index = fdt_subnode_offset(fdt, interface, buffer);
+	snprintf(buffer, sizeof(buffer), "pip/interface@%d/ethernet@%x",
+		 oct_eth_info->interface, oct_eth_info->index);
+	index = octeon_fdt_path_offset(fdt, buffer);
 	if (index < 0) {
 		printf("%s: ethernet@%x not found in device tree for %s\n",
 		       __func__, oct_eth_info->index, eth->name);
@@ -387,7 +480,7 @@ int octeon_fdt_find_phy(const struct eth_device *eth)
 		return -1;
 	}
 	phandle = fdt32_to_cpu(*phy_handle);
-	phy = fdt_node_offset_by_phandle(fdt, phandle);
+	phy = octeon_fdt_node_offset_by_phandle(fdt, phandle);
 	if (phy < 0) {
 		printf("%s: phy not found for %s\n", __func__, eth->name);
 		return -1;
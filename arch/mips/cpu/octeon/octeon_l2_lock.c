@@ -0,0 +1,108 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * L2 locked regions for hot DMA buffers, see asm/arch/octeon_l2_lock.h
+ */
+
+#include <common.h>
+#include <asm/arch/cvmx.h>
+#include <asm/arch/cvmx-l2c.h>
+#include <asm/arch/octeon_l2_lock.h>
+
+#define OCTEON_L2_LOCK_MAX_REGIONS	8
+
+struct octeon_l2_region {
+	uint64_t	phys;
+	uint64_t	len;		/* 0 if the slot is free */
+	int		group;
+};
+
+static struct octeon_l2_region l2_regions[OCTEON_L2_LOCK_MAX_REGIONS];
+static uint64_t l2_locked_bytes;
+
+static uint64_t octeon_l2_lock_budget(void)
+{
+#ifdef CONFIG_OCTEON_L2_LOCK_SIZE
+	return CONFIG_OCTEON_L2_LOCK_SIZE;
+#else
+	return cvmx_l2c_get_cache_size_bytes() / 4;
+#endif
+}
+
+uint64_t octeon_l2_lock(uint64_t phys, uint64_t len, int group)
+{
+	struct octeon_l2_region *free_slot = NULL;
+	uint64_t budget = octeon_l2_lock_budget();
+	int i;
+
+	/* Only whole lines can be locked */
+	len = (len + (phys & CVMX_CACHE_LINE_MASK) + CVMX_CACHE_LINE_MASK) &
+		~CVMX_CACHE_LINE_MASK;
+	phys &= ~CVMX_CACHE_LINE_MASK;
+
+	for (i = 0; i < OCTEON_L2_LOCK_MAX_REGIONS; i++) {
+		if (l2_regions[i].len && l2_regions[i].phys == phys)
+			return l2_regions[i].len;
+		if (!l2_regions[i].len && !free_slot)
+			free_slot = &l2_regions[i];
+	}
+	if (!free_slot || l2_locked_bytes >= budget)
+		return 0;
+
+	if (len > budget - l2_locked_bytes)
+		len = budget - l2_locked_bytes;
+	if (!len)
+		return 0;
+
+	if (cvmx_l2c_lock_mem_region(phys, len)) {
+		/*
+		 * All the ways this core may lock are used up, leave the
+		 * region in DRAM rather than starve normal caching.
+		 */
+		debug("%s: could not lock 0x%llx bytes at 0x%llx\n",
+		      __func__, len, phys);
+		cvmx_l2c_unlock_mem_region(phys, len);
+		return 0;
+	}
+
+	debug("%s: locked 0x%llx bytes at 0x%llx\n", __func__, len, phys);
+	free_slot->phys = phys;
+	free_slot->len = len;
+	free_slot->group = group;
+	l2_locked_bytes += len;
+	return len;
+}
+
+void octeon_l2_unlock(int group)
+{
+	int i;
+
+	for (i = 0; i < OCTEON_L2_LOCK_MAX_REGIONS; i++) {
+		if (!l2_regions[i].len)
+			continue;
+		if (group != OCTEON_L2_LOCK_ALL && l2_regions[i].group != group)
+			continue;
+		cvmx_l2c_unlock_mem_region(l2_regions[i].phys,
+					   l2_regions[i].len);
+		l2_locked_bytes -= l2_regions[i].len;
+		l2_regions[i].len = 0;
+	}
+}
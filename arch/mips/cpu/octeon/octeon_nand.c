@@ -45,26 +45,230 @@
 #include <asm/arch/cvmx-nand.h>
 #include <asm/arch/octeon_nand.h>
 #include <fdt.h>
+#include <linux/mtd/nand_bch.h>
+#include <asm/errno.h>
+#include <malloc.h>
+#include <asm/arch/cvmx-bootmem.h>
+#include <asm/arch/octeon_l2_lock.h>
 
 #if defined(CONFIG_CMD_OCTEON_NAND) || defined(CONFIG_CMD_NAND)
 
 DECLARE_GLOBAL_DATA_PTR;
 
+#ifndef cmdprint
+# ifdef DEBUG
+#  define cmdprint printf
+# else
+#  define cmdprint(...)
+# endif
+#endif
+
 struct octeon_nand_priv {
 	int selected_chip;
 	int selected_page;
 	int data_len;
 	int data_index;
+	int data_start;		/* First valid index of rdata */
+	uint8_t *rdata;		/* Data returned by read_byte/read_buf */
+	int read_pending;	/* READ0 issued but page not transferred yet */
+	int read_page;
+	int read_column;
+	int last_page;		/* Last page transferred */
+#ifdef CONFIG_OCTEON_NAND_READAHEAD_PAGES
+	int seq_count;		/* Number of sequential page reads in a row */
+	int ra_first;		/* First page held in ra_buf */
+	int ra_count;		/* Number of pages held in ra_buf */
+	uint8_t *ra_buf;
+#endif
+#ifdef CONFIG_OCTEON_NAND_DMA_BCH
+	struct nand_ecclayout ecclayout;
+#endif
 	__attribute__ ((aligned(8))) uint8_t data[5000];
 };
 
+#ifdef CONFIG_OCTEON_NAND_READAHEAD_PAGES
+/**
+ * Decides whether a page read should go through the read-ahead buffer.
+ * This is the case when the page is already buffered, or when the chip
+ * supports cache reads and we have seen a run of sequential page reads.
+ * Pairs of reads such as the UBI EC and VID header reads of each
+ * eraseblock do not trigger read-ahead.
+ */
+static int octeon_nand_use_readahead(struct octeon_nand_priv *priv, int page)
+{
+	if (priv->ra_count && page >= priv->ra_first &&
+	    page < priv->ra_first + priv->ra_count)
+		return 1;
+
+	return page == priv->last_page + 1 && priv->seq_count >= 2 &&
+	       cvmx_nand_has_read_cache(priv->selected_chip) > 0;
+}
+
+/**
+ * Serves the pending page from the read-ahead buffer, refilling it with a
+ * multi-page cache read first if needed.
+ *
+ * @return 1 if rdata now points at the page, 0 if not possible
+ */
+static int octeon_nand_readahead(struct mtd_info *mtd)
+{
+	struct nand_chip *nand = mtd->priv;
+	struct octeon_nand_priv *priv = nand->priv;
+	int page = priv->read_page;
+	int stride = (mtd->writesize + mtd->oobsize + 7) & ~7;
+	int ppb = 1 << (nand->phys_erase_shift - nand->page_shift);
+	int count;
+
+	if (!octeon_nand_use_readahead(priv, page))
+		return 0;
+
+	if (!priv->ra_count || page < priv->ra_first ||
+	    page >= priv->ra_first + priv->ra_count) {
+		if (!priv->ra_buf) {
+			priv->ra_buf = memalign(8, CONFIG_OCTEON_NAND_READAHEAD_PAGES *
+						   stride);
+			if (!priv->ra_buf)
+				return 0;
+		}
+		/* Stay within the eraseblock */
+		count = ppb - (page & (ppb - 1));
+		if (count > CONFIG_OCTEON_NAND_READAHEAD_PAGES)
+			count = CONFIG_OCTEON_NAND_READAHEAD_PAGES;
+
+		priv->ra_count = 0;
+		if (cvmx_nand_page_read_multi(priv->selected_chip,
+					      (uint64_t)page << nand->page_shift,
+					      cvmx_ptr_to_phys(priv->ra_buf),
+					      stride, count) != count * stride) {
+			cmdprint("Read-ahead of %d pages at 0x%x failed\n",
+				 count, page);
+			return 0;
+		}
+		priv->ra_first = page;
+		priv->ra_count = count;
+	}
+
+	priv->rdata = priv->ra_buf + (page - priv->ra_first) * stride +
+		      priv->read_column;
+	priv->data_len = mtd->writesize + mtd->oobsize - priv->read_column;
+	return 1;
+}
+#endif
+
+/**
+ * Records that a page has been transferred, for sequential read detection
+ */
+static void octeon_nand_page_done(struct octeon_nand_priv *priv, int page)
+{
+#ifdef CONFIG_OCTEON_NAND_READAHEAD_PAGES
+	if (page == priv->last_page + 1)
+		priv->seq_count++;
+	else
+		priv->seq_count = 0;
+#endif
+	priv->last_page = page;
+}
+
+/**
+ * Transfers the page selected by the last NAND_CMD_READ0 into the driver
+ * buffer.  READ0 only records the page so that octeon_read_buf() can DMA
+ * it straight into the caller's buffer instead.
+ */
+static void octeon_nand_fill(struct mtd_info *mtd)
+{
+	struct nand_chip *nand = mtd->priv;
+	struct octeon_nand_priv *priv = nand->priv;
+	int buffer_length;
+
+	if (priv->data_index < priv->data_start)
+		priv->read_pending = 1;
+	if (!priv->read_pending)
+		return;
+
+	priv->read_pending = 0;
+	priv->data_start = 0;
+#ifdef CONFIG_OCTEON_NAND_READAHEAD_PAGES
+	if (octeon_nand_readahead(mtd)) {
+		octeon_nand_page_done(priv, priv->read_page);
+		return;
+	}
+#endif
+	priv->rdata = priv->data;
+	/* Make sure buffer length is rounded up to multiple of 8 */
+	buffer_length = (1 << nand->page_shift) + mtd->oobsize;
+	buffer_length = (buffer_length + 7) & ~7;
+	/* Here mtd->oobsize _must_ already be a multiple of 8 */
+	priv->data_len = cvmx_nand_page_read(priv->selected_chip,
+					     priv->read_column +
+					     ((uint64_t)priv->read_page <<
+					      nand->page_shift),
+					     cvmx_ptr_to_phys(priv->data),
+					     buffer_length);
+	if (priv->data_len < (1 << nand->page_shift) + mtd->oobsize) {
+		cmdprint("READ0 failed with %d\n", priv->data_len);
+		priv->data_len = 0;
+	}
+	cmdprint("READ0 length %d\n", priv->data_len);
+	octeon_nand_page_done(priv, priv->read_page);
+}
+
+/**
+ * Reads the main area of the pending page straight into the caller's
+ * buffer, avoiding the copy through the driver buffer.  The OOB area is
+ * then fetched into the driver buffer with a column change, which does not
+ * reload the page from the array.
+ *
+ * @param mtd	MTD device
+ * @param buf	destination, must be 8 byte aligned
+ * @param len	number of bytes, must be the page size
+ *
+ * @return 1 if the page data was transferred to buf, 0 if the normal
+ *	   buffered path must be used
+ */
+static int octeon_nand_read_direct(struct mtd_info *mtd, uint8_t *buf, int len)
+{
+	struct nand_chip *nand = mtd->priv;
+	struct octeon_nand_priv *priv = nand->priv;
+	uint64_t phys;
+	int oob_len = (mtd->oobsize + 7) & ~7;
+
+	if (!priv->read_pending || priv->read_column || priv->data_index ||
+	    len != mtd->writesize || (len & 7) || ((unsigned long)buf & 7))
+		return 0;
+#ifdef CONFIG_OCTEON_NAND_READAHEAD_PAGES
+	if (octeon_nand_use_readahead(priv, priv->read_page))
+		return 0;
+#endif
+	phys = cvmx_ptr_to_phys(buf);
+	if (cvmx_ptr_to_phys(buf + len - 1) != phys + len - 1)
+		return 0;
+
+	if (cvmx_nand_page_read(priv->selected_chip,
+				(uint64_t)priv->read_page << nand->page_shift,
+				phys, len) != len)
+		return 0;
+	if (cvmx_nand_page_read_column(priv->selected_chip, len,
+				       cvmx_ptr_to_phys(priv->data + len),
+				       oob_len) < mtd->oobsize)
+		return 0;
+
+	priv->read_pending = 0;
+	priv->rdata = priv->data;
+	priv->data_start = len;
+	priv->data_index = len;
+	priv->data_len = len + mtd->oobsize;
+	octeon_nand_page_done(priv, priv->read_page);
+	return 1;
+}
+
 uint8_t octeon_read_byte(struct mtd_info *mtd)
 {
 	struct nand_chip *nand = mtd->priv;
 	struct octeon_nand_priv *priv = nand->priv;
 
+	octeon_nand_fill(mtd);
 	if (priv->data_index < priv->data_len) {
-		return priv->data[priv->data_index++];
+		return priv->rdata[priv->data_index++];
 	} else {
 		printf("error: No data to read\n");
 		return 0xff;
@@ -77,8 +281,9 @@ uint16_t octeon_read_word(struct mtd_info * mtd)
 	struct nand_chip *nand = mtd->priv;
 	struct octeon_nand_priv *priv = nand->priv;
 
+	octeon_nand_fill(mtd);
 	if (priv->data_index + 1 < priv->data_len) {
-		uint16_t result = le16_to_cpup((uint16_t *) (priv->data +
+		uint16_t result = le16_to_cpup((uint16_t *) (priv->rdata +
 							     priv->data_index));
 		priv->data_index += 2;
 		return result;
@@ -116,8 +321,13 @@ void octeon_read_buf(struct mtd_info *mtd, uint8_t * buf, int len)
 	 *        priv->data_index);
 	 */
 	WATCHDOG_RESET();
+	if (octeon_nand_read_direct(mtd, buf, len)) {
+		WATCHDOG_RESET();
+		return;
+	}
+	octeon_nand_fill(mtd);
 	if (len <= priv->data_len - priv->data_index) {
-		memcpy(buf, priv->data + priv->data_index, len);
+		memcpy(buf, priv->rdata + priv->data_index, len);
 		priv->data_index += len;
 	} else {
 		printf("octeon_read_buf: Not enough data for read of %d bytes.\n"
@@ -148,13 +358,6 @@ int octeon_block_bad(struct mtd_info *mtd, loff_t ofs, int getchip)
 }
 
 
-#ifndef cmdprint
-# ifdef DEBUG
-#  define cmdprint printf
-# else
-#  define cmdprint(...)
-# endif
-#endif
 void octeon_cmdfunc(struct mtd_info *mtd, unsigned command, int column,
 		    int page_addr)
 {
@@ -164,9 +367,14 @@ void octeon_cmdfunc(struct mtd_info *mtd, unsigned command, int column,
 	int status;
 	struct nand_chip *nand = mtd->priv;
 	struct octeon_nand_priv *priv = nand->priv;
-	int buffer_length;
 
 	WATCHDOG_RESET();
+	if (command != NAND_CMD_RNDOUT) {
+		/* Any other command ends the pending read */
+		priv->read_pending = 0;
+		priv->data_start = 0;
+		priv->rdata = priv->data;
+	}
 	switch (command) {
 	case NAND_CMD_PAGEPROG:
 		cmdprint("cmdfunc: PAGEPROG\n");
@@ -176,6 +384,9 @@ void octeon_cmdfunc(struct mtd_info *mtd, unsigned command, int column,
 					      cvmx_ptr_to_phys(priv->data));
 		if (status)
 			cmdprint("PAGEPROG failed with %d\n", status);
+#ifdef CONFIG_OCTEON_NAND_READAHEAD_PAGES
+		priv->ra_count = 0;
+#endif
 		break;
 
 	case NAND_CMD_SEQIN:
@@ -243,21 +454,14 @@ void octeon_cmdfunc(struct mtd_info *mtd, unsigned command, int column,
 		break;
 	case NAND_CMD_READ0:
 		cmdprint("READ0 page_addr=0x%x\n", page_addr);
+		/* The transfer is done by octeon_nand_fill() or
+		 * octeon_nand_read_direct() once we know where the data goes.
+		 */
 		priv->data_index = 0;
-		/* Make sure buffer length is rounded up to multiple of 8 */
-		buffer_length = (1 << nand->page_shift) + mtd->oobsize;
-		buffer_length = (buffer_length + 7) & ~7;
-		/* Here mtd->oobsize _must_ already be a multiple of 8 */
-		priv->data_len = cvmx_nand_page_read(priv->selected_chip,
-						     column +
-						     (page_addr << nand->page_shift),
-						     cvmx_ptr_to_phys(priv->data),
-						     buffer_length);
-		if (priv->data_len < (1 << nand->page_shift) + mtd->oobsize) {
-			cmdprint("READ0 failed with %d\n", priv->data_len);
-			priv->data_len = 0;
-		}
-		cmdprint("READ0 length %d\n", priv->data_len);
+		priv->data_len = 0;
+		priv->read_page = page_addr;
+		priv->read_column = column;
+		priv->read_pending = 1;
 		break;
 
 	case NAND_CMD_ERASE1:
@@ -266,6 +470,9 @@ void octeon_cmdfunc(struct mtd_info *mtd, unsigned command, int column,
 					  page_addr << nand->page_shift)) {
 			cmdprint("ERASE1 failed\n");
 		}
+#ifdef CONFIG_OCTEON_NAND_READAHEAD_PAGES
+		priv->ra_count = 0;
+#endif
 		break;
 	case NAND_CMD_ERASE2:
 		/* We do all erase processing in the first command, so ignore
@@ -277,6 +484,9 @@ void octeon_cmdfunc(struct mtd_info *mtd, unsigned command, int column,
 		priv->data_index = 0;
 		priv->data_len = 0;
 		memset(priv->data, 0xff, sizeof(priv->data));
+#ifdef CONFIG_OCTEON_NAND_READAHEAD_PAGES
+		priv->ra_count = 0;
+#endif
 		status = cvmx_nand_reset(priv->selected_chip);
 		if (status)
 			cmdprint("RESET failed with %d\n", status);
@@ -314,6 +524,209 @@ int octeon_scan_bbt(struct mtd_info *mtd)
 	return 0;
 }
 
+#if defined(CONFIG_NAND_ECC_BCH) && defined(CONFIG_OCTEON_NAND_DMA_BCH)
+/**
+ * The BCH control structure can only be set up once the MTD layer has
+ * filled in the page size, so this is done on first use.
+ *
+ * @param mtd	MTD device
+ *
+ * @return 0 on success, -1 if BCH could not be initialized
+ */
+static int octeon_nand_bch_setup(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd->priv;
+
+	if (chip->ecc.priv)
+		return 0;
+
+	chip->ecc.priv = nand_bch_init(mtd, chip->ecc.size, chip->ecc.bytes,
+				       &chip->ecc.layout);
+	if (!chip->ecc.priv) {
+		printf("ERROR: BCH ECC initialization failed!\n");
+		return -1;
+	}
+	return 0;
+}
+
+static void octeon_nand_bch_hwctl(struct mtd_info *mtd, int mode)
+{
+	/* ECC is computed from the DMA buffer, nothing to enable here */
+}
+
+static int octeon_nand_bch_calculate(struct mtd_info *mtd, const uint8_t *dat,
+				     uint8_t *ecc_code)
+{
+	if (octeon_nand_bch_setup(mtd))
+		return -1;
+	return nand_bch_calculate_ecc(mtd, dat, ecc_code);
+}
+
+/**
+ * Checks if an ECC step and its ECC bytes are still erased.  Erased steps
+ * are valid BCH codewords (see nand_bch_init()) so there is no need to run
+ * the encoder over them.
+ *
+ * @param data		ECC step data
+ * @param len		length of the data, multiple of 8 bytes
+ * @param ecc		ECC bytes read from the OOB area
+ * @param ecc_len	number of ECC bytes
+ *
+ * @return 1 if erased, 0 otherwise
+ */
+static int octeon_nand_bch_erased(const uint8_t *data, int len,
+				  const uint8_t *ecc, int ecc_len)
+{
+	const uint64_t *p = (const uint64_t *)data;
+	int i;
+
+	for (i = 0; i < ecc_len; i++)
+		if (ecc[i] != 0xff)
+			return 0;
+
+	if ((unsigned long)data & 7) {
+		for (i = 0; i < len; i++)
+			if (data[i] != 0xff)
+				return 0;
+		return 1;
+	}
+
+	for (i = 0; i < len / 8; i++)
+		if (p[i] != ~0ull)
+			return 0;
+
+	return 1;
+}
+
+/**
+ * Reads a page with BCH correction.  NAND_CMD_READ0 only left the read
+ * pending: the main area is DMA'd straight into buf and the OOB into the
+ * driver buffer by octeon_nand_read_direct(), and the syndrome is checked
+ * and corrected in place in buf.  When buf cannot take the DMA, or the page
+ * comes from read-ahead, the page is in the driver buffer and copied out
+ * once before correction.
+ */
+static int octeon_nand_bch_read_page(struct mtd_info *mtd,
+				     struct nand_chip *chip,
+				     uint8_t *buf, int page)
+{
+	struct octeon_nand_priv *priv = chip->priv;
+	int i, stat;
+	int eccsize = chip->ecc.size;
+	int eccbytes = chip->ecc.bytes;
+	int eccsteps = chip->ecc.steps;
+	uint8_t *p = buf;
+	uint8_t *oob;
+	uint8_t *ecc_calc = chip->buffers->ecccalc;
+	uint8_t *ecc_code = chip->buffers->ecccode;
+	uint32_t *eccpos = chip->ecc.layout->eccpos;
+
+	if (octeon_nand_bch_setup(mtd))
+		return -EIO;
+
+	if (!octeon_nand_read_direct(mtd, buf, mtd->writesize)) {
+		octeon_nand_fill(mtd);
+		if (priv->data_len < mtd->writesize + mtd->oobsize) {
+			printf("%s: page 0x%x was not read\n", __func__, page);
+			return -EIO;
+		}
+		memcpy(buf, priv->rdata, mtd->writesize);
+	}
+	oob = priv->rdata + mtd->writesize;
+
+	for (i = 0; i < chip->ecc.total; i++)
+		ecc_code[i] = oob[eccpos[i]];
+
+	for (i = 0; eccsteps; eccsteps--, i += eccbytes, p += eccsize) {
+		if (octeon_nand_bch_erased(p, eccsize, &ecc_code[i], eccbytes))
+			continue;
+
+		nand_bch_calculate_ecc(mtd, p, &ecc_calc[i]);
+		stat = nand_bch_correct_data(mtd, p, &ecc_code[i],
+					     &ecc_calc[i]);
+		if (stat < 0)
+			mtd->ecc_stats.failed++;
+		else
+			mtd->ecc_stats.corrected += stat;
+	}
+
+	memcpy(chip->oob_poi, oob, mtd->oobsize);
+	priv->data_index = mtd->writesize + mtd->oobsize;
+	return 0;
+}
+
+static void octeon_nand_bch_write_page(struct mtd_info *mtd,
+				       struct nand_chip *chip,
+				       const uint8_t *buf)
+{
+	int i;
+	int eccsize = chip->ecc.size;
+	int eccbytes = chip->ecc.bytes;
+	int eccsteps = chip->ecc.steps;
+	uint8_t *ecc_calc = chip->buffers->ecccalc;
+	const uint8_t *p = buf;
+	uint32_t *eccpos = chip->ecc.layout->eccpos;
+
+	for (i = 0; eccsteps; eccsteps--, i += eccbytes, p += eccsize)
+		octeon_nand_bch_calculate(mtd, p, &ecc_calc[i]);
+
+	for (i = 0; i < chip->ecc.total; i++)
+		chip->oob_poi[eccpos[i]] = ecc_calc[i];
+
+	chip->write_buf(mtd, buf, mtd->writesize);
+	chip->write_buf(mtd, chip->oob_poi, mtd->oobsize);
+}
+
+/**
+ * Switches a chip configured for software BCH over to the driver managed
+ * BCH path.  The MTD layer only knows about the page geometry after
+ * board_nand_init() returns, so the ECC layout is built here from the
+ * geometry cvmx-nand already probed, using the same placement as
+ * nand_bch_init().  If that is not possible the chip stays on the generic
+ * software BCH path.
+ *
+ * @param chip		NAND chip to set up
+ * @param chip_select	chip select of the NAND chip
+ */
+static void octeon_nand_bch_init(struct nand_chip *chip, int chip_select)
+{
+	struct octeon_nand_priv *priv = chip->priv;
+	struct nand_ecclayout *layout = &priv->ecclayout;
+	int page_size = cvmx_nand_get_page_size(chip_select);
+	int oob_size = cvmx_nand_get_oob_size(chip_select);
+	int i;
+
+	if (!chip->ecc.size && oob_size >= 64) {
+		chip->ecc.size = 512;
+		chip->ecc.bytes = 7;
+	}
+	if (!chip->ecc.size || !chip->ecc.bytes || page_size <= 0 ||
+	    oob_size < 64 || (page_size % chip->ecc.size) ||
+	    (chip->ecc.size & 7))
+		return;
+
+	layout->eccbytes = (page_size / chip->ecc.size) * chip->ecc.bytes;
+	if (layout->eccbytes + 2 > oob_size ||
+	    layout->eccbytes > ARRAY_SIZE(layout->eccpos))
+		return;
+
+	for (i = 0; i < layout->eccbytes; i++)
+		layout->eccpos[i] = oob_size - layout->eccbytes + i;
+	layout->oobfree[0].offset = 2;
+	layout->oobfree[0].length = oob_size - 2 - layout->eccbytes;
+
+	chip->ecc.layout = layout;
+	chip->ecc.mode = NAND_ECC_HW;
+	chip->ecc.hwctl = octeon_nand_bch_hwctl;
+	chip->ecc.calculate = octeon_nand_bch_calculate;
+	chip->ecc.correct = nand_bch_correct_data;
+	chip->ecc.read_page = octeon_nand_bch_read_page;
+	chip->ecc.write_page = octeon_nand_bch_write_page;
+	debug("NAND cs %d: driver managed BCH, ecc size: %d, ecc bytes: %d\n",
+	      chip_select, chip->ecc.size, chip->ecc.bytes);
+}
+#endif
+
 int board_nand_init(struct nand_chip *chip)
 {
 	struct octeon_nand_priv *nand_priv;
@@ -367,6 +780,8 @@ int board_nand_init(struct nand_chip *chip)
 	}
 	memset(nand_priv, 0, sizeof(struct octeon_nand_priv));
 	nand_priv->selected_chip = cur_chip_select;
+	nand_priv->rdata = nand_priv->data;
+	nand_priv->last_page = -2;
 	chip->numchips = 1;
 #ifdef CONFIG_NAND_ECC_BCH
 	chip->ecc.mode = NAND_ECC_SOFT_BCH;
@@ -422,6 +837,11 @@ int board_nand_init(struct nand_chip *chip)
 		}
 	}
 #endif
+#if defined(CONFIG_NAND_ECC_BCH) && defined(CONFIG_OCTEON_NAND_DMA_BCH)
+	if (chip->ecc.mode == NAND_ECC_SOFT_BCH)
+		octeon_nand_bch_init(chip, cur_chip_select);
+#endif
+
 	/* Functions that we define with something useful */
 	chip->read_byte = octeon_read_byte;
 	chip->read_word = octeon_read_word;
@@ -483,6 +903,17 @@ int oct_nand_probe(void)
 		debug("%s: Could not initialize NAND\n", __func__);
 		return OCT_NAND_ERROR;
 	}
+#ifdef CONFIG_OCTEON_L2_LOCK
+	{
+		/* Every page goes through the cvmx-nand DMA buffer */
+		const cvmx_bootmem_named_block_desc_t *desc;
+
+		desc = cvmx_bootmem_find_named_block("__nand_buffer");
+		if (desc)
+			octeon_l2_lock(desc->base_addr, desc->size,
+				       OCTEON_L2_LOCK_STORAGE);
+	}
+#endif
 	WATCHDOG_RESET();
 	/* Find the first nand chip and use it */
 	debug("%s: Calling cvmx_nand_get_active_chips()\n", __func__);
@@ -25,6 +25,8 @@
 #include <asm/mipsregs.h>
 #ifdef CONFIG_OCTEON
 #include <asm/arch/cvmx.h>
+#include <asm/arch/octeon_boot.h>
+#include <asm/arch/octeon_prof.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 #endif
@@ -70,6 +72,8 @@ ulong get_timer(ulong base)
 	unsigned int count;
 	unsigned int expirelo = read_c0_compare();
 
+	octeon_prof_poll(__builtin_return_address(0));
+
 	/* Check to see if we have missed any timestamps. */
 	count = read_c0_count();
 	while ((count - expirelo) < 0x7fffffff) {
@@ -92,8 +96,10 @@ void __udelay(unsigned long usec)
 	unsigned int tmo;
 
 	tmo = read_c0_count() + (usec * (CONFIG_SYS_MIPS_TIMER_FREQ / 1000000));
-	while ((tmo - read_c0_count()) < 0x7fffffff)
-		/*NOP*/;
+	while ((tmo - read_c0_count()) < 0x7fffffff) {
+		octeon_serial_poll();	/* keep the console draining */
+		octeon_prof_poll(octeon_prof_udelay_caller());
+	}
 }
 
 /*
@@ -108,7 +108,31 @@ typedef struct cvmx_bootmem_named_block_desc cvmx_bootmem_named_block_desc_t;
 
 /* Current descriptor versions */
 #define CVMX_BOOTMEM_DESC_MAJ_VER   3	/* CVMX bootmem descriptor major version */
-#define CVMX_BOOTMEM_DESC_MIN_VER   0	/* CVMX bootmem descriptor minor version */
+#define CVMX_BOOTMEM_DESC_MIN_VER   1	/* CVMX bootmem descriptor minor version */
+
+/* Minor version that added named_block_index_addr */
+#define CVMX_BOOTMEM_DESC_MIN_VER_INDEX	1
+
+/*
+ * Hash index over the named block array, pointed to by
+ * named_block_index_addr.  Each bucket holds the upper 16 bits of the
+ * name hash and the array index + 1 of the block in the low 16 bits.  A
+ * zero bucket ends a probe sequence, CVMX_BOOTMEM_INDEX_DELETED is a
+ * freed entry.  first_free is the lowest unused array index, which is
+ * the one any version of this code will hand out next.  That lets us
+ * notice allocations made by code that predates the index and rebuild it,
+ * as well as lookups that land on a block such code has freed.
+ */
+#define CVMX_BOOTMEM_INDEX_MAGIC	0x424d4958	/* "BMIX" */
+#define CVMX_BOOTMEM_INDEX_DELETED	0xffffffff
+
+typedef struct {
+	uint32_t magic;
+	uint32_t num_buckets;	/* power of 2 */
+	uint32_t first_free;	/* lowest free named block index */
+	uint32_t num_deleted;	/* deleted buckets, rebuilt when too many */
+	uint32_t bucket[0];
+} cvmx_bootmem_named_index_t;
 
 /* First three members of cvmx_bootmem_desc_t are left in original
 ** positions for backwards compatibility.
@@ -135,6 +159,8 @@ typedef struct {
 					 /**< length of name array in bootmem blocks */
 	uint64_t named_block_array_addr;
 					 /**< address of named memory block descriptors */
+	uint64_t named_block_index_addr;
+					 /**< address of cvmx_bootmem_named_index_t, minor version 1+ */
 #else				/* __LITTLE_ENDIAN */
 	uint32_t flags;
 	uint32_t lock;
@@ -148,6 +174,7 @@ typedef struct {
 	uint32_t named_block_name_len;
 	uint32_t named_block_num_blocks;
 	uint64_t named_block_array_addr;
+	uint64_t named_block_index_addr;
 #endif
 } cvmx_bootmem_desc_t;
 
@@ -585,6 +585,39 @@ extern cvmx_nand_status_t cvmx_nand_submit(cvmx_nand_cmd_t cmd);
  */
 extern int cvmx_nand_page_read(int chip, uint64_t nand_address, uint64_t buffer_address, int buffer_length);
 
+/**
+ * Read from another column of the page most recently loaded by
+ * cvmx_nand_page_read(), without reloading the page from the array.
+ *
+ * @param chip   Chip select for NAND flash
+ * @param column Byte offset within the page to start reading from
+ * @param buffer_address
+ *               Physical address to store the result at
+ * @param buffer_length
+ *               Number of bytes to read
+ *
+ * @return Bytes read on success, a negative cvmx_nand_status_t error code on failure
+ */
+extern int cvmx_nand_page_read_column(int chip, int column, uint64_t buffer_address, int buffer_length);
+
+/**
+ * Read a number of consecutive pages from NAND, using the ONFI read cache
+ * commands when the chip supports them.  Page N is stored at
+ * buffer_address + N * buffer_length.
+ *
+ * @param chip   Chip select for NAND flash
+ * @param nand_address
+ *               Page aligned location in NAND to start reading from
+ * @param buffer_address
+ *               Physical address to store the first page at
+ * @param buffer_length
+ *               Number of bytes to read from each page
+ * @param pages  Number of pages to read
+ *
+ * @return Total bytes read on success, a negative cvmx_nand_status_t error code on failure
+ */
+extern int cvmx_nand_page_read_multi(int chip, uint64_t nand_address, uint64_t buffer_address, int buffer_length, int pages);
+
 /**
  * Write a page to NAND. The buffer must contain the entire page
  * including the out of band data.
@@ -684,6 +717,15 @@ extern int cvmx_nand_get_pages_per_block(int chip);
  */
 extern int cvmx_nand_get_blocks(int chip);
 
+/**
+ * Check if a NAND chip supports the ONFI read cache commands
+ *
+ * @param chip   Chip select for NAND flash
+ *
+ * @return One if supported, zero if not, or a negative cvmx_nand_status_t error code on failure
+ */
+extern int cvmx_nand_has_read_cache(int chip);
+
 /**
  * Reset the NAND flash
  *
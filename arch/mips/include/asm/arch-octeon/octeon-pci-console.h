@@ -49,6 +49,7 @@
 #define OCTEON_PCI_CONSOLE_MINOR_VERSION    0
 
 #define OCTEON_PCI_CONSOLE_BLOCK_NAME   "__pci_console"
+#define OCTEON_PCI_BULK_BLOCK_NAME      "__pci_bulk"
 
 /* Structure that defines a single console.
 
@@ -101,8 +102,25 @@ enum {
 int __cvmx_pci_console_write(int fd, char *buf, int nbytes);
 #endif
 
+/* The bulk data channel is a single console in its own named block.  The
+host writes an octeon_pci_bulk_hdr_t followed by the payload into the input
+ring.  All header fields are big-endian.
+*/
+#define OCTEON_PCI_BULK_MAGIC		0x4f42554c	/* "OBUL" */
+#define OCTEON_PCI_BULK_VERSION		1
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t size;		/* payload size in bytes */
+	uint32_t crc32;		/* crc32 of the payload */
+	uint32_t pad;
+} octeon_pci_bulk_hdr_t;
+
 #ifdef CVMX_BUILD_FOR_UBOOT
 uint64_t octeon_pci_console_init(int num_consoles, int buffer_size);
+uint64_t octeon_pci_console_init_named(const char *name, int num_consoles,
+				       int buffer_size);
 #endif
 
 /* Flag definitions for read/write functions */
@@ -98,6 +98,14 @@ int octeon_setup_boot_desc_block (uint32_t core_mask,
 				  uint32_t new_core_mask, int app_index);
 int octeon_setup_boot_vector (uint32_t func_addr, uint32_t core_mask);
 void start_cores (uint32_t coremask_to_start);
+uint32_t octeon_core_work_mask (void);
+int octeon_core_work_start (int core, void (*func)(void *arg), void *arg);
+int octeon_core_work_done (int core);
+int octeon_bunzip (char *dst, unsigned int *dst_len, char *src,
+		   unsigned int src_len);
+void octeon_serial_poll (void);
+void octeon_serial_flush (void);
+void octeon_perf_boot (void);
 int cvmx_spi4000_initialize (int interface);
 int cvmx_spi4000_detect (int interface);
 void octeon_flush_l2_cache (void);
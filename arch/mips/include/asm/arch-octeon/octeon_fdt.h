@@ -88,4 +88,26 @@ void octeon_fixup_fdt(void);
  */
 int octeon_fdt_find_phy(const struct eth_device *eth);
 
+/**
+ * Finds a node by path using the index linked in by the board Makefile,
+ * falling back to walking the tree if there is no usable index.
+ *
+ * @param fdt	device tree
+ * @param path	full path ("/soc/uart@1180000000800") or a path starting
+ *		with an alias ("pip/interface@0/ethernet@1")
+ *
+ * @return node offset or -FDT_ERR_NOTFOUND
+ */
+int octeon_fdt_path_offset(const void *fdt, const char *path);
+
+/**
+ * Finds a node by phandle using the device tree index if possible.
+ *
+ * @param fdt		device tree
+ * @param phandle	phandle to look for
+ *
+ * @return node offset or -FDT_ERR_NOTFOUND
+ */
+int octeon_fdt_node_offset_by_phandle(const void *fdt, uint32_t phandle);
+
 #endif /* __OCTEON_FDT_H__ */
\ No newline at end of file
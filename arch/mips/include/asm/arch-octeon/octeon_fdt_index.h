@@ -0,0 +1,68 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+#ifndef __OCTEON_FDT_INDEX_H__
+#define __OCTEON_FDT_INDEX_H__
+
+/*
+ * Pre-resolved node offsets for the embedded device tree.
+ *
+ * tools/mkfdtidx writes this next to the board DTB at build time.  Keys
+ * are full node paths ("/soc@0/serial@1180000000800"), alias relative
+ * paths ("pip/interface@0/ethernet@1"), bare aliases ("uart0") and
+ * phandles ("&1a").  The buckets form an open-addressed hash table with
+ * linear probing; an empty bucket has a node offset of -1.  Key and name
+ * fields are offsets into the string table following the buckets, the
+ * name being the node's own name that is checked against the live tree
+ * before an offset is trusted.
+ *
+ * All fields are big-endian, like the FDT itself.
+ */
+#define OCTEON_FDT_INDEX_MAGIC		0x46444958	/* "FDIX" */
+#define OCTEON_FDT_INDEX_VERSION	1
+
+struct octeon_fdt_index_hdr {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size_dt_struct;	/* of the DTB the index was built for */
+	uint32_t num_buckets;		/* power of 2 */
+	uint32_t num_entries;
+	uint32_t strings_off;		/* from the start of the header */
+};
+
+struct octeon_fdt_index_entry {
+	uint32_t hash;
+	int32_t node;			/* node offset, -1 if empty */
+	uint32_t key;			/* key string */
+	uint32_t name;			/* expected node name */
+};
+
+/* FNV-1a */
+static inline uint32_t octeon_fdt_index_hash(const char *key)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*key) {
+		hash ^= (unsigned char)*key++;
+		hash *= 16777619;
+	}
+	return hash;
+}
+
+#endif /* __OCTEON_FDT_INDEX_H__ */
@@ -0,0 +1,68 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+#ifndef __OCTEON_L2_LOCK_H__
+#define __OCTEON_L2_LOCK_H__
+
+/*
+ * Pins DMA buffers and descriptor memory that U-Boot touches for every
+ * packet or block in the L2 cache.
+ *
+ * The amount of L2 that may be locked is limited to
+ * CONFIG_OCTEON_L2_LOCK_SIZE bytes (a quarter of the L2 by default) so
+ * normal caching of DRAM keeps enough ways.  Each locked region belongs
+ * to a group so a driver can release its regions when it shuts its
+ * hardware down; everything still locked is released before U-Boot hands
+ * over to an application or operating system.
+ */
+
+#define OCTEON_L2_LOCK_NET	0	/* FPA pools of the network ports */
+#define OCTEON_L2_LOCK_STORAGE	1	/* MMC and NAND bounce buffers */
+#define OCTEON_L2_LOCK_ALL	-1
+
+#ifdef CONFIG_OCTEON_L2_LOCK
+/**
+ * Locks the start of a memory region in L2
+ *
+ * @param phys	physical address of the region
+ * @param len	length of the region in bytes
+ * @param group	OCTEON_L2_LOCK_NET or OCTEON_L2_LOCK_STORAGE
+ *
+ * @return number of bytes from phys that were locked, which is less than
+ *	   len when the L2 lock budget is used up.  Regions that are
+ *	   already locked are not locked twice and report their old length.
+ */
+uint64_t octeon_l2_lock(uint64_t phys, uint64_t len, int group);
+
+/**
+ * Unlocks all regions of a group, writing them back to DRAM
+ *
+ * @param group	group to unlock, or OCTEON_L2_LOCK_ALL
+ */
+void octeon_l2_unlock(int group);
+#else
+static inline uint64_t octeon_l2_lock(uint64_t phys, uint64_t len, int group)
+{
+	return 0;
+}
+
+static inline void octeon_l2_unlock(int group) { }
+#endif
+
+#endif /* __OCTEON_L2_LOCK_H__ */
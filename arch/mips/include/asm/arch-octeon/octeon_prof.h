@@ -0,0 +1,83 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+#ifndef __OCTEON_PROF_H__
+#define __OCTEON_PROF_H__
+
+/*
+ * Polled PC sampler.
+ *
+ * U-Boot runs with Status[ERL] set, so a performance counter overflow can
+ * never raise an interrupt.  Instead CP0 performance counter 0 counts core
+ * cycles and the overflow is checked from the functions that every wait
+ * loop ends up calling (get_timer(), udelay()).  Each check that finds the
+ * counter overflowed records the caller of the polling function in the
+ * cvmx-profiler sample buffers, once for every sampling period that has
+ * elapsed since the last one.
+ */
+
+#ifdef CONFIG_CMD_OCTEON_PROF
+extern int octeon_prof_active;
+extern void *octeon_prof_udelay_pc;
+
+void __octeon_prof_sample(unsigned long pc);
+
+/*
+ * The profiler state is in .bss, which must not be touched before
+ * relocation, and only core 0 takes samples.  These are macros because
+ * they need the gd of the including file (DECLARE_GLOBAL_DATA_PTR) and
+ * cvmx_get_core_num() from cvmx.h.
+ */
+#define octeon_prof_usable()						\
+	((gd->flags & GD_FLG_RELOC) && cvmx_get_core_num() == 0)
+
+/**
+ * Records a sample if the sampling period has expired.
+ *
+ * @param pc	address to charge the sample to, normally the return
+ *		address of the caller
+ */
+#define octeon_prof_poll(pc)						\
+	do {								\
+		if (octeon_prof_usable() && octeon_prof_active)		\
+			__octeon_prof_sample((unsigned long)(pc));	\
+	} while (0)
+
+/**
+ * Makes __udelay() charge its samples to the caller of udelay() rather
+ * than to udelay() itself.  udelay() sets it on entry and clears it
+ * (NULL) on return.
+ */
+#define octeon_prof_set_udelay_pc(pc)					\
+	do {								\
+		if (octeon_prof_usable())				\
+			octeon_prof_udelay_pc = (pc);			\
+	} while (0)
+
+/* Address __udelay() charges its samples to */
+#define octeon_prof_udelay_caller()					\
+	(octeon_prof_udelay_pc ? octeon_prof_udelay_pc :		\
+	 __builtin_return_address(0))
+#else
+#define octeon_prof_poll(pc)		do { } while (0)
+#define octeon_prof_set_udelay_pc(pc)	do { } while (0)
+#define octeon_prof_udelay_caller()	NULL
+#endif
+
+#endif /* __OCTEON_PROF_H__ */
@@ -2259,5 +2259,6 @@ extern int uboot_octeon_pci_console_init(void);
 void hang(void)
 {
 	puts("### ERROR ### Please RESET the board ###\n");
+	octeon_serial_flush();
 	for (;;) ;
 }
@@ -22,6 +22,7 @@
 #include <asm/mipsregs.h>
 #include <asm/arch/octeon_boot.h>
 #include <asm/arch/octeon_board_common.h>
+#include <asm/arch/octeon_fdt.h>
 #include <pci.h>
 #include <miiphy.h>
 #include <asm/arch/lib_octeon_shared.h>
@@ -55,11 +56,10 @@ int board_fixup_fdt(void)
 
 void octeon_fixup_fdt(void)
 {
-	const char *p;
 	int pip, interface, ethernet;
 	int i, e;
 	uint64_t mac;
-	char name[20];
+	char name[32];
 
 	__octeon_fixup_fdt();
 
@@ -73,23 +73,18 @@ void octeon_fixup_fdt(void)
 		((gd->ogd.mac_desc.mac_addr_base[1] & 0xffull) << 32) |
 		((gd->ogd.mac_desc.mac_addr_base[0] & 0xffull) << 40);
 
-	p = fdt_get_alias(working_fdt, "pip");
-	if (!p)
-		return;
-
-	pip = fdt_path_offset(working_fdt, p);
+	pip = octeon_fdt_path_offset(working_fdt, "pip");
 	if (pip <= 0)
 		return;
 
 	for (i = 1; i >= 0; i--) {
-		sprintf(name, "interface@%d", i);
-		interface = fdt_subnode_offset(working_fdt, pip, name);
+		sprintf(name, "pip/interface@%d", i);
+		interface = octeon_fdt_path_offset(working_fdt, name);
 		if (interface <= 0)
 			continue;
 		for (e = 0; e < 4; e++) {
-			sprintf(name, "ethernet@%d", e);
-			ethernet = fdt_subnode_offset(working_fdt, interface,
-						      name);
+			sprintf(name, "pip/interface@%d/ethernet@%d", i, e);
+			ethernet = octeon_fdt_path_offset(working_fdt, name);
 			if (ethernet <= 0)
 				break;
 			octeon_set_one_fdt_mac(ethernet, &mac);
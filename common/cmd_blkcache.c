@@ -0,0 +1,66 @@
+/*
+ * blkcache command, shows and controls the block device read cache
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <command.h>
+#include <blkcache.h>
+
+static int do_blkcache(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	struct blkcache_stats stats;
+
+	if (argc != 2)
+		return cmd_usage(cmdtp);
+
+	if (strcmp(argv[1], "info") == 0) {
+		blkcache_get_stats(&stats);
+		printf("Block cache: %s, %d windows of %d KiB\n",
+		       stats.enabled ? "enabled" : "disabled",
+		       stats.entries, stats.window / 1024);
+		printf("    hits:       %lu\n", stats.hits);
+		printf("    misses:     %lu\n", stats.misses);
+		printf("    bypassed:   %lu\n", stats.bypass);
+		printf("    read-ahead: %lu blocks\n", stats.ra_blocks);
+		printf("    writes:     %lu\n", stats.writes);
+	} else if (strcmp(argv[1], "invalidate") == 0) {
+		blkcache_invalidate_all();
+	} else if (strcmp(argv[1], "reset") == 0) {
+		blkcache_clear_stats();
+	} else if (strcmp(argv[1], "on") == 0) {
+		blkcache_enable(1);
+	} else if (strcmp(argv[1], "off") == 0) {
+		blkcache_enable(0);
+	} else {
+		return cmd_usage(cmdtp);
+	}
+	return 0;
+}
+
+U_BOOT_CMD(
+	blkcache,	2,	0,	do_blkcache,
+	"block device read cache control",
+	"info       - show cache statistics\n"
+	"blkcache invalidate - drop all cached blocks\n"
+	"blkcache reset      - clear the statistics\n"
+	"blkcache on|off     - enable or disable the cache"
+);
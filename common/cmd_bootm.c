@@ -62,6 +62,14 @@
 #include <linux/lzo.h>
 #endif /* CONFIG_LZO */
 
+#ifdef CONFIG_LZ4
+#include <linux/lz4.h>
+#endif /* CONFIG_LZ4 */
+
+#ifdef CONFIG_OCTEON_PARALLEL_BUNZIP
+#include <asm/arch/octeon_boot.h>
+#endif
+
 DECLARE_GLOBAL_DATA_PTR;
 
 #ifndef CONFIG_SYS_BOOTM_LEN
@@ -324,9 +332,9 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 	ulong image_len = os.image_len;
 	__maybe_unused uint unc_len = CONFIG_SYS_BOOTM_LEN;
 	int no_overlap = 0;
-#if defined(CONFIG_LZMA) || defined(CONFIG_LZO)
+#if defined(CONFIG_LZMA) || defined(CONFIG_LZO) || defined(CONFIG_LZ4)
 	int ret;
-#endif /* defined(CONFIG_LZMA) || defined(CONFIG_LZO) */
+#endif /* defined(CONFIG_LZMA) || defined(CONFIG_LZO) || defined(CONFIG_LZ4) */
 
 	const char *type_name = genimg_get_type_name(os.type);
 
@@ -366,9 +374,20 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 		 * use slower decompression algorithm which requires
 		 * at most 2300 KB of memory.
 		 */
-		int i = BZ2_bzBuffToBuffDecompress((char *)load,
+		int i = 1;
+#ifdef CONFIG_OCTEON_PARALLEL_BUNZIP
+		i = octeon_bunzip((char *)load, &unc_len,
+				  (char *)image_start, image_len);
+		/* Decompress every stream if it could not be done in parallel */
+		if (i)
+			i = BZ2_bzBuffToBuffDecompressMulti((char *)load,
 					&unc_len, (char *)image_start, image_len,
 					CONFIG_SYS_MALLOC_LEN < (4096 * 1024), 0);
+#else
+		i = BZ2_bzBuffToBuffDecompress((char *)load,
+					&unc_len, (char *)image_start, image_len,
+					CONFIG_SYS_MALLOC_LEN < (4096 * 1024), 0);
+#endif
 		if (i != BZ_OK) {
 			printf("BUNZIP2: uncompress or overwrite error %d "
 				"- must RESET board to recover\n", i);
@@ -417,6 +436,27 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 		*load_end = load + unc_len;
 		break;
 #endif /* CONFIG_LZO */
+#ifdef CONFIG_LZ4
+	case IH_COMP_LZ4: {
+		size_t lz4_len = unc_len;
+
+		printf("   Uncompressing %s ... ", type_name);
+
+		ret = lz4_decompress((const unsigned char *)image_start,
+				     image_len, (unsigned char *)load,
+				     &lz4_len);
+		if (ret != LZ4_E_OK) {
+			printf("LZ4: uncompress or overwrite error %d "
+			      "- must RESET board to recover\n", ret);
+			if (boot_progress)
+				bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
+			return BOOTM_ERR_RESET;
+		}
+
+		*load_end = load + lz4_len;
+		break;
+	}
+#endif /* CONFIG_LZ4 */
 	default:
 		printf("Unimplemented compression type %d\n", comp);
 		return BOOTM_ERR_UNIMPLEMENTED;
@@ -24,6 +24,9 @@
 #include <common.h>
 #include <command.h>
 #include <bzlib.h>
+#ifdef CONFIG_OCTEON_PARALLEL_BUNZIP
+#include <asm/arch/octeon_boot.h>
+#endif
 
 extern void bz_internal_error(int);
 
@@ -42,6 +45,9 @@ static int do_bunzip(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	char buf[32];
 
 	switch (argc) {
+		case 5:
+			src_len = simple_strtoul(argv[4], NULL, 16);
+			/* fall through */
 		case 4:
 			dst_len = simple_strtoul(argv[3], NULL, 16);
 			/* fall through */
@@ -53,10 +59,22 @@ static int do_bunzip(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			return CMD_RET_USAGE;
 	}
 
+#ifdef CONFIG_OCTEON_PARALLEL_BUNZIP
+	/* Multi-stream images are split up by stream, so need the length */
+	ret = octeon_bunzip((char *)dst, &dst_len, (char *)src,
+			    src_len != ~0UL ? src_len :
+			    getenv_ulong("filesize", 16, 0));
+	if (ret)
+		ret = BZ2_bzBuffToBuffDecompressMulti((char *)dst, &dst_len,
+					(char *)src, src_len,
+					CONFIG_SYS_MALLOC_LEN < (4096 * 1024),
+					0);
+#else
 	ret = BZ2_bzBuffToBuffDecompress((char *)dst, &dst_len,
 				         (char *)src, src_len,
 					 CONFIG_SYS_MALLOC_LEN < (4096 * 1024),
 					 0);
+#endif
 
 	if (ret != BZ_OK) {
 		printf("BUNZIP2: decompression error %d "
@@ -74,7 +92,7 @@ static int do_bunzip(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 }
 
 U_BOOT_CMD(
-	bunzip,	4,	1,	do_bunzip,
+	bunzip,	5,	1,	do_bunzip,
 	"uncompress a bzip2 compressed memory region",
-	"srcaddr dstaddr [dstsize]"
+	"srcaddr dstaddr [dstsize [srcsize]]"
 );
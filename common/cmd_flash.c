@@ -26,6 +26,7 @@
  */
 #include <common.h>
 #include <command.h>
+#include <exports.h>
 
 #ifdef CONFIG_HAS_DATAFLASH
 #include <dataflash.h>
@@ -681,6 +682,116 @@ int flash_sect_protect (int p, ulong addr_first, ulong addr_last)
 }
 #endif /* CONFIG_SYS_NO_FLASH */
 
+#if defined(CONFIG_CMD_FLASH_UPDATE) && !defined(CONFIG_SYS_NO_FLASH)
+#ifndef CONFIG_FLASH_UPDATE_MTDID
+# define CONFIG_FLASH_UPDATE_MTDID	"phys_mapped_flash"
+#endif
+
+/*
+ * Look up partition 'name' of CONFIG_FLASH_UPDATE_MTDID in $mtdparts,
+ * which uses the Linux syntax, e.g.
+ * "phys_mapped_flash:640k(boot0),640k(boot1),64k(eeprom)".
+ * Returns 0 and the flash address and size of the partition if found.
+ */
+static int flash_find_part(const char *name, ulong *addr, ulong *size)
+{
+	const char *id = CONFIG_FLASH_UPDATE_MTDID;
+	char *p = getenv("mtdparts"), *end;
+	ulong offset = 0, total = 0, psize;
+	int i;
+
+	if (!p)
+		return -1;
+	if (!strncmp(p, "mtdparts=", 9))
+		p += 9;
+
+	/* find our device among the ';' separated ones */
+	while (strncmp(p, id, strlen(id)) || p[strlen(id)] != ':') {
+		p = strchr(p, ';');
+		if (!p)
+			return -1;
+		p++;
+	}
+	p += strlen(id) + 1;
+
+	for (i = 0; i < CONFIG_SYS_MAX_FLASH_BANKS; i++)
+		total += flash_info[i].size;
+
+	while (*p && *p != ';') {
+		if (*p == '-') {
+			psize = total > offset ? total - offset : 0;
+			p++;
+		} else {
+			psize = ustrtoul(p, &p, 0);
+		}
+		if (*p == '@')
+			offset = ustrtoul(p + 1, &p, 0);
+
+		if (*p == '(') {
+			end = strchr(++p, ')');
+			if (!end)
+				return -1;
+			if (end - p == strlen(name) &&
+			    !strncmp(p, name, end - p)) {
+				*addr = flash_info[0].start[0] + offset;
+				*size = psize;
+				return 0;
+			}
+			p = end + 1;
+		}
+
+		offset += psize;
+		end = strpbrk(p, ",;");
+		if (!end || *end == ';')
+			break;
+		p = end + 1;
+	}
+	return -1;
+}
+
+int do_flupdate(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	ulong addr, len, src = load_addr, psize = 0;
+	char *ep;
+	int rc;
+
+	if (argc < 3 || strcmp(argv[1], "update"))
+		return CMD_RET_USAGE;
+
+	addr = simple_strtoul(argv[2], &ep, 16);
+	if (ep == argv[2] || *ep != '\0') {
+		if (flash_find_part(argv[2], &addr, &psize)) {
+			printf("Unknown partition '%s'\n", argv[2]);
+			return 1;
+		}
+	}
+
+	len = getenv_ulong("filesize", 16, 0);
+	if (argc > 3)
+		len = simple_strtoul(argv[3], NULL, 16);
+	if (argc > 4)
+		src = simple_strtoul(argv[4], NULL, 16);
+	if (!len) {
+		puts("No length given and $filesize not set\n");
+		return 1;
+	}
+	if (psize && len > psize) {
+		printf("0x%lx bytes do not fit in '%s' (0x%lx bytes)\n",
+		       len, argv[2], psize);
+		return 1;
+	}
+
+	printf("Updating 0x%lx bytes at 0x%08lx from 0x%08lx\n",
+	       len, addr, src);
+	rc = flash_update((char *)src, addr, len);
+	if (rc) {
+		flash_perror(rc);
+		return 1;
+	}
+	return 0;
+}
+#endif /* CONFIG_CMD_FLASH_UPDATE && !CONFIG_SYS_NO_FLASH */
+
 
 /**************************************************/
 #if defined(CONFIG_CMD_MTDPARTS)
@@ -739,6 +850,17 @@ U_BOOT_CMD(
 	"protect off all\n    - make all FLASH banks writable"
 );
 
+#if defined(CONFIG_CMD_FLASH_UPDATE) && !defined(CONFIG_SYS_NO_FLASH)
+U_BOOT_CMD(
+	flash,  5,  0,  do_flupdate,
+	"update FLASH, rewriting only sectors that differ",
+	"update target [len [src]]\n"
+	"    - write 'len' bytes (default $filesize) from 'src' (default\n"
+	"      $loadaddr) to 'target', a FLASH address or a partition\n"
+	"      named in $mtdparts"
+);
+#endif
+
 #undef	TMP_ERASE
 #undef	TMP_PROT_ON
 #undef	TMP_PROT_OFF
@@ -46,6 +46,7 @@
 
 #include <ide.h>
 #include <ata.h>
+#include <blkcache.h>
 
 #ifdef CONFIG_STATUS_LED
 # include <status_led.h>
@@ -275,6 +276,8 @@ int do_ide (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 #endif
 
 			n = ide_write(curr_device, blk, cnt, (ulong *)addr);
+			blkcache_invalidate(&ide_dev_desc[IDE_BUS(curr_device)]
+						[IDE_DEV(curr_device)]);
 
 			printf("%ld blocks written: %s\n",
 			       n, (n == cnt) ? "OK" : "ERROR");
@@ -622,6 +625,7 @@ void ide_init (void)
 				continue;
 #endif
 			ide_led (led, 1);		/* LED on	*/
+			blkcache_invalidate(&ide_dev_desc[bus][dev]);
 			ide_ident(&ide_dev_desc[bus][dev]);
 			ide_led (led, 0);		/* LED off	*/
 			dev_print(&ide_dev_desc[bus][dev]);
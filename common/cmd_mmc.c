@@ -24,6 +24,7 @@
 #include <common.h>
 #include <command.h>
 #include <mmc.h>
+#include <blkcache.h>
 
 static int curr_device = -1;
 #if !defined(CONFIG_GENERIC_MMC) && !defined(CONFIG_OCTEON_MMC)
@@ -331,11 +332,11 @@ int do_mmcops(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			flush_cache((ulong)addr, cnt * 512); /* FIXME */
 			break;
 		case MMC_WRITE:
-			n = mmc->block_dev.block_write(curr_device, blk,
-						      cnt, addr);
+			n = blkcache_write(&mmc->block_dev, blk, cnt, addr);
 			break;
 		case MMC_ERASE:
 			n = mmc->block_dev.block_erase(curr_device, blk, cnt);
+			blkcache_invalidate(&mmc->block_dev);
 			break;
 		default:
 			BUG();
@@ -47,6 +47,7 @@
 #include <errno.h>
 #include <malloc.h>
 #include <watchdog.h>
+#include <hush.h>
 #include <serial.h>
 #include <linux/stddef.h>
 #include <asm/byteorder.h>
@@ -325,6 +326,12 @@ int _do_env_set(int flag, int argc, char * const argv[])
 		}
 	}
 
+#ifdef CONFIG_HUSH_SCRIPT_CACHE
+	/* A cached parse of the old value must not outlive it */
+	if (ep)
+		hush_script_cache_forget(ep->data);
+#endif
+
 	/* Delete only ? */
 	if ((argc < 3) || argv[2] == NULL) {
 		if (!in_hook) {
@@ -618,6 +625,13 @@ int getenv_f(const char *name, char *buf, unsigned len)
 {
 	int i, nxt;
 
+#ifdef CONFIG_ENV_FLASH_LOG
+	/* Values appended since the last full save override the list */
+	i = env_log_getenv_f(name, buf, len);
+	if (i != -2)
+		return i;
+#endif
+
 	for (i = 0; env_get_char(i) != '\0'; i = nxt + 1) {
 		int val, n;
 
@@ -47,6 +47,10 @@ DECLARE_GLOBAL_DATA_PTR;
 #error CONFIG_ENV_SIZE_REDUND should not be less then CONFIG_ENV_SIZE
 #endif
 
+#if defined(CONFIG_ENV_FLASH_LOG) && defined(CONFIG_ENV_ADDR_REDUND)
+#error CONFIG_ENV_FLASH_LOG does not support CONFIG_ENV_ADDR_REDUND
+#endif
+
 char *env_name_spec = "Flash";
 
 #ifdef ENV_IS_EMBEDDED
@@ -72,6 +76,299 @@ static env_t *flash_addr_new = (env_t *)CONFIG_ENV_ADDR_REDUND;
 static ulong end_addr_new = CONFIG_ENV_ADDR_REDUND + CONFIG_ENV_SECT_SIZE - 1;
 #endif /* CONFIG_ENV_ADDR_REDUND */
 
+#ifdef CONFIG_ENV_FLASH_LOG
+/*
+ * Saves append the variables that changed since the last save to the log
+ * behind the exported list (see environment.h) and only erase the sector
+ * when the log is full.  env_log_saved holds the sorted export matching
+ * what is in flash, so a save is a merge of two sorted lists.
+ */
+static int env_log_tail;	/* offset of the next record, 0 if none */
+static int env_log_dirty;	/* programmed bytes past the tail */
+static char *env_log_saved;
+
+/* Length of the exported list including its terminating empty string */
+static int env_log_list_len(const unsigned char *data)
+{
+	int i = 0;
+
+	while (i < ENV_SIZE && data[i]) {
+		while (i < ENV_SIZE && data[i])
+			i++;
+		i++;
+	}
+	return i + 1;
+}
+
+/*
+ * Return the offset of the first record if env has a log head matching
+ * its list, 0 otherwise.  Only reads flash, so it is usable before
+ * relocation.
+ */
+static int env_log_base(const env_t *env)
+{
+	const struct env_log_head *head;
+	int len, off;
+
+	len = env_log_list_len(env->data);
+	off = ALIGN(len, ENV_LOG_ALIGN);
+	if (off + sizeof(*head) > ENV_SIZE)
+		return 0;
+
+	head = (const struct env_log_head *)(env->data + off);
+	if (head->magic != ENV_LOG_MAGIC ||
+	    head->base_crc != crc32(0, env->data, len))
+		return 0;
+
+	return off + sizeof(*head);
+}
+
+/*
+ * Return the record at *off and advance *off past it, or NULL at the end
+ * of the log.
+ */
+static const struct env_log_rec *env_log_next(const env_t *env, int *off)
+{
+	const struct env_log_rec *rec;
+
+	if (*off + sizeof(*rec) > ENV_SIZE)
+		return NULL;
+
+	rec = (const struct env_log_rec *)(env->data + *off);
+	if (rec->len > ENV_SIZE - *off - sizeof(*rec) ||
+	    rec->crc != crc32(0, (const uchar *)&rec->len,
+			      sizeof(rec->len) + rec->len))
+		return NULL;
+
+	*off += ALIGN(sizeof(*rec) + rec->len, ENV_LOG_ALIGN);
+	return rec;
+}
+
+int env_log_getenv_f(const char *name, char *buf, unsigned len)
+{
+	const struct env_log_rec *rec;
+	const char *p, *end, *val = NULL;
+	int off, n = strlen(name);
+
+	if (!gd->env_valid)
+		return -2;
+
+	off = env_log_base(flash_addr);
+	if (!off)
+		return -2;
+
+	while ((rec = env_log_next(flash_addr, &off)) != NULL) {
+		end = (const char *)(rec + 1) + rec->len;
+		for (p = (const char *)(rec + 1); p < end;
+		     p += strnlen(p, end - p) + 1) {
+			if (!strncmp(p, name, n) &&
+			    (p[n] == '=' || p[n] == '\0'))
+				val = p + n;
+		}
+	}
+
+	if (!val)
+		return -2;
+	if (*val++ != '=')
+		return -1;
+
+	for (n = 0; n < len; ++n, ++buf) {
+		*buf = *val++;
+		if (*buf == '\0')
+			return n;
+	}
+
+	if (n)
+		*--buf = '\0';
+
+	printf("env_buf [%d bytes] too small for value of \"%s\"\n",
+		len, name);
+
+	return n;
+}
+
+/*
+ * Import the list and replay the records.  Returns -1 if the flash does
+ * not hold a log, so the caller falls back to env_import().
+ */
+static int env_log_import(void)
+{
+	const struct env_log_rec *rec;
+	const uchar *p;
+	int off;
+
+	off = env_log_base(flash_addr);
+	if (!off)
+		return -1;
+
+	if (!himport_r(&env_htab, (char *)flash_addr->data, ENV_SIZE,
+		       '\0', 0)) {
+		error("Cannot import environment: errno = %d\n", errno);
+		set_default_env("!import failed");
+		return 0;
+	}
+
+	while ((rec = env_log_next(flash_addr, &off)) != NULL) {
+		if (rec->len && !himport_r(&env_htab, (char *)(rec + 1),
+					   rec->len, '\0', H_NOCLEAR))
+			error("Cannot replay environment log: errno = %d\n",
+			      errno);
+	}
+
+	/* An interrupted append leaves bytes we cannot program over */
+	for (p = flash_addr->data + off; p < flash_addr->data + ENV_SIZE; p++)
+		if (*p != 0xff)
+			break;
+	env_log_dirty = p < flash_addr->data + ENV_SIZE;
+	env_log_tail = off;
+
+	env_log_saved = malloc(ENV_SIZE);
+	if (env_log_saved &&
+	    hexport_r(&env_htab, '\0', &env_log_saved, ENV_SIZE, 0, NULL) < 0) {
+		free(env_log_saved);
+		env_log_saved = NULL;
+	}
+
+	gd->flags |= GD_FLG_ENV_READY;
+	return 0;
+}
+
+#ifdef CMD_SAVEENV
+/* strcmp() on the names of two "name=value" entries */
+static int env_log_keycmp(const char *a, const char *b)
+{
+	for (; *a == *b; a++, b++)
+		if (*a == '=' || *a == '\0')
+			return 0;
+
+	return (*a == '=' ? 0 : (uchar)*a) - (*b == '=' ? 0 : (uchar)*b);
+}
+
+/*
+ * Append the difference between env_log_saved and data, both sorted
+ * exports.  Returns 0 on success, a flash error code, or -1 if the
+ * sector has to be rewritten instead.
+ */
+static int env_log_append(const char *data)
+{
+	struct env_log_rec *rec;
+	const char *o = env_log_saved, *n = data;
+	char *p, *end;
+	int avail, cmp, len, rc;
+	ulong addr;
+
+	if (!env_log_tail || !env_log_saved || env_log_dirty)
+		return -1;
+
+	avail = ENV_SIZE - env_log_tail - (int)sizeof(*rec);
+	if (avail <= 0)
+		return -1;
+
+	rec = malloc(sizeof(*rec) + avail);
+	if (!rec)
+		return -1;
+	p = (char *)(rec + 1);
+	end = p + avail;
+
+	while (*o || *n) {
+		if (!*o)
+			cmp = 1;
+		else if (!*n)
+			cmp = -1;
+		else
+			cmp = env_log_keycmp(o, n);
+
+		if (cmp < 0) {
+			/* deleted: record the bare name */
+			len = strchr(o, '=') - o;
+			if (p + len + 1 > end)
+				goto full;
+			memcpy(p, o, len);
+			p[len] = '\0';
+			p += len + 1;
+		} else if (cmp > 0 || strcmp(o, n)) {
+			len = strlen(n) + 1;
+			if (p + len > end)
+				goto full;
+			memcpy(p, n, len);
+			p += len;
+		}
+
+		if (cmp <= 0)
+			o += strlen(o) + 1;
+		if (cmp >= 0)
+			n += strlen(n) + 1;
+	}
+
+	rec->len = p - (char *)(rec + 1);
+	if (!rec->len) {
+		free(rec);
+		puts("Environment unchanged\n");
+		return 0;
+	}
+	rec->crc = crc32(0, (const uchar *)&rec->len,
+			 sizeof(rec->len) + rec->len);
+
+	/* The header goes last so a torn append reads as the end of log */
+	addr = (ulong)flash_addr->data + env_log_tail;
+	puts("Appending to Flash... ");
+	rc = flash_write((char *)(rec + 1), addr + sizeof(*rec), rec->len);
+	if (!rc)
+		rc = flash_write((char *)rec, addr, sizeof(*rec));
+	if (rc) {
+		env_log_dirty = 1;
+		free(rec);
+		return rc;
+	}
+
+	env_log_tail += ALIGN(sizeof(*rec) + rec->len, ENV_LOG_ALIGN);
+	memcpy(env_log_saved, data, ENV_SIZE);
+	free(rec);
+	puts("done\n");
+	return 0;
+
+full:
+	free(rec);
+	return -1;
+}
+
+/*
+ * Put an empty log behind the exported list before the whole sector is
+ * written.  Returns the offset of the first record, or 0 if the list
+ * leaves no room for a log.
+ */
+static int env_log_prepare(unsigned char *data)
+{
+	struct env_log_head *head;
+	int len, off;
+
+	len = env_log_list_len(data);
+	off = ALIGN(len, ENV_LOG_ALIGN);
+	if (off + sizeof(*head) >= ENV_SIZE)
+		return 0;
+
+	head = (struct env_log_head *)(data + off);
+	head->magic = ENV_LOG_MAGIC;
+	head->base_crc = crc32(0, data, len);
+	off += sizeof(*head);
+	memset(data + off, 0xff, ENV_SIZE - off);
+
+	return off;
+}
+
+/* The sector now holds data with an empty log starting at tail */
+static void env_log_reset(const unsigned char *data, int tail)
+{
+	env_log_tail = tail;
+	env_log_dirty = 0;
+	if (!env_log_saved)
+		env_log_saved = malloc(ENV_SIZE);
+	if (env_log_saved)
+		memcpy(env_log_saved, data, ENV_SIZE);
+}
+#endif /* CMD_SAVEENV */
+#endif /* CONFIG_ENV_FLASH_LOG */
+
 #ifdef CONFIG_ENV_ADDR_REDUND
 int __env_init(void)
 {
@@ -231,6 +528,13 @@ done:
 
 int __env_init(void)
 {
+#ifdef CONFIG_ENV_FLASH_LOG
+	if (env_log_base(env_ptr)) {
+		gd->env_addr	= (ulong)&(env_ptr->data);
+		gd->env_valid	= 1;
+		return 0;
+	}
+#endif
 	if (crc32(0, env_ptr->data, ENV_SIZE) == env_ptr->crc) {
 		gd->env_addr	= (ulong)&(env_ptr->data);
 		gd->env_valid	= 1;
@@ -249,6 +553,9 @@ int saveenv(void)
 	ssize_t	len;
 	int	rc = 1;
 	char	*res, *saved_data = NULL;
+#ifdef CONFIG_ENV_FLASH_LOG
+	int	tail;
+#endif
 #if CONFIG_ENV_SECT_SIZE > CONFIG_ENV_SIZE
 	ulong	up_data = 0;
 
@@ -281,6 +588,15 @@ int saveenv(void)
 		error("Cannot export environment: errno = %d\n", errno);
 		goto done;
 	}
+#ifdef CONFIG_ENV_FLASH_LOG
+	rc = env_log_append((char *)env_new.data);
+	if (rc == 0)
+		goto done;
+	if (rc > 0)
+		goto perror;
+	tail = env_log_prepare(env_new.data);
+	rc = 1;
+#endif
 	env_new.crc = crc32(0, env_new.data, ENV_SIZE);
 
 	puts("Erasing Flash...");
@@ -303,6 +619,9 @@ int saveenv(void)
 	}
 #endif
 	puts("done\n");
+#ifdef CONFIG_ENV_FLASH_LOG
+	env_log_reset(env_new.data, tail);
+#endif
 	rc = 0;
 	goto done;
 perror:
@@ -363,5 +682,9 @@ void env_relocate_spec(void)
 		     "reading environment; recovered successfully\n\n");
 #endif /* CONFIG_ENV_ADDR_REDUND */
 
+#ifdef CONFIG_ENV_FLASH_LOG
+	if (env_log_import() == 0)
+		return;
+#endif
 	env_import((char *)flash_addr, 1);
 }
@@ -29,6 +29,7 @@
 #include <linux/stddef.h>
 #include <malloc.h>
 #include <mmc.h>
+#include <blkcache.h>
 #include <search.h>
 #include <errno.h>
 
@@ -87,8 +88,8 @@ static inline int write_env(struct mmc *mmc, unsigned long size,
 	blk_start	= ALIGN(offset, mmc->write_bl_len) / mmc->write_bl_len;
 	blk_cnt		= ALIGN(size, mmc->write_bl_len) / mmc->write_bl_len;
 
-	n = mmc->block_dev.block_write(CONFIG_SYS_MMC_ENV_DEV, blk_start,
-					blk_cnt, (u_char *)buffer);
+	n = blkcache_write(&mmc->block_dev, blk_start, blk_cnt,
+			   (u_char *)buffer);
 
 	return (n == blk_cnt) ? 0 : -1;
 }
@@ -1541,6 +1541,7 @@ static int run_pipe_real(struct pipe *pi)
 	struct child_prog *child;
 	struct built_in_command *x;
 	char *p;
+	int sp;
 # if __GNUC__
 	/* Avoid longjmp clobbering */
 	(void) &i;
@@ -1553,6 +1554,7 @@ static int run_pipe_real(struct pipe *pi)
 	int flag = do_repeat ? CMD_FLAG_REPEAT : 0;
 	struct child_prog *child;
 	char *p;
+	int sp;
 # if __GNUC__
 	/* Avoid longjmp clobbering */
 	(void) &i;
@@ -1619,6 +1621,8 @@ static int run_pipe_real(struct pipe *pi)
 			}
 			return EXIT_SUCCESS;   /* don't worry about errors in set_local_var() yet */
 		}
+		/* The pipe may be run again, leave child->sp alone */
+		sp = child->sp;
 		for (i = 0; is_assignment(child->argv[i]); i++) {
 			p = insert_var_value(child->argv[i]);
 #ifndef __U_BOOT__
@@ -1627,11 +1631,11 @@ static int run_pipe_real(struct pipe *pi)
 			set_local_var(p, 0);
 #endif
 			if (p != child->argv[i]) {
-				child->sp--;
+				sp--;
 				free(p);
 			}
 		}
-		if (child->sp) {
+		if (sp) {
 			char * str = NULL;
 
 			str = make_string((child->argv + i));
@@ -1763,6 +1767,7 @@ static int run_list_real(struct pipe *pi)
 	char *save_name = NULL;
 	char **list = NULL;
 	char **save_list = NULL;
+	struct pipe *save_pipe = NULL;
 	struct pipe *rpipe;
 	int flag_rep = 0;
 #ifndef __U_BOOT__
@@ -1802,7 +1807,8 @@ static int run_list_real(struct pipe *pi)
 				/* check Ctrl-C */
 				ctrlc();
 				if ((had_ctrlc())) {
-					return 1;
+					rcode = 1;
+					goto out;
 				}
 #endif
 				flag_restore = 0;
@@ -1831,6 +1837,7 @@ static int run_list_real(struct pipe *pi)
 				list = make_list_in(pi->next->progs->argv,
 					pi->progs->argv[0]);
 				save_list = list;
+				save_pipe = pi;
 				save_name = pi->progs->argv[0];
 				pi->progs->argv[0] = NULL;
 				flag_rep = 1;
@@ -1902,7 +1909,8 @@ static int run_list_real(struct pipe *pi)
 #else
 		if (rcode < -1) {
 			last_return_code = -rcode - 2;
-			return -2;	/* exit */
+			rcode = -2;	/* exit */
+			goto out;
 		}
 		last_return_code=(rcode == 0) ? 0 : 1;
 #endif
@@ -1920,6 +1928,20 @@ static int run_list_real(struct pipe *pi)
 			skip_more_in_this_rmode=rmode;
 #ifndef __U_BOOT__
 		checkjobs(NULL);
+#endif
+	}
+out:
+	if (list) {
+		/* Left a "for" loop early, put the variable name back so the
+		 * pipe list can be run again.
+		 */
+		free(save_pipe->progs->argv[0]);
+		while (*list)
+			free(*list++);
+		free(save_list);
+		save_pipe->progs->argv[0] = save_name;
+#ifndef __U_BOOT__
+		save_pipe->progs->glob_result.gl_pathv[0] = save_name;
 #endif
 	}
 	return rcode;
@@ -3109,9 +3131,171 @@ void update_ifs_map(void)
 	mapset(ifs, 2);            /* also flow through if quoted */
 }
 
-/* most recursion does not come through here, the exeception is
- * from builtin_source() */
-int parse_stream_outer(struct in_str *inp, int flag)
+#ifdef CONFIG_HUSH_SCRIPT_CACHE
+/*
+ * Parsed form of the strings run through parse_string_outer(): bootcmd,
+ * "run" targets and "source"d scripts.  Each entry keeps the pipe list of
+ * every line so a script that is run again is only executed, not parsed.
+ * Entries are looked up by the text itself, so a changed variable simply
+ * misses; setenv drops the entry of the old value to free its memory.
+ */
+#ifndef CONFIG_HUSH_SCRIPT_CACHE_ENTRIES
+# define CONFIG_HUSH_SCRIPT_CACHE_ENTRIES	16
+#endif
+
+struct script_cache {
+	char *text;		/* NULL if the entry is unused */
+	unsigned int hash;
+	int flag;
+	int busy;		/* number of runs using the lists right now */
+	int stale;		/* free once the last run is done */
+	unsigned long stamp;	/* LRU stamp */
+	int num_lists;
+	struct pipe **lists;	/* one pipe list per line */
+};
+
+static struct script_cache script_cache[CONFIG_HUSH_SCRIPT_CACHE_ENTRIES];
+static unsigned long script_cache_clock;
+
+static unsigned int script_hash(const char *s)
+{
+	unsigned int hash = 0;
+
+	while (*s)
+		hash = hash * 31 + (unsigned char)*s++;
+	return hash;
+}
+
+static void script_free_lists(struct script_cache *sc)
+{
+	int i;
+
+	for (i = 0; i < sc->num_lists; i++)
+		free_pipe_list(sc->lists[i], 0);
+	free(sc->lists);
+	sc->lists = NULL;
+	sc->num_lists = 0;
+}
+
+static void script_cache_free(struct script_cache *sc)
+{
+	script_free_lists(sc);
+	free(sc->text);
+	memset(sc, 0, sizeof(*sc));
+}
+
+static struct script_cache *script_cache_find(const char *s,
+					      unsigned int hash, int flag)
+{
+	struct script_cache *sc;
+	int i;
+
+	for (i = 0; i < CONFIG_HUSH_SCRIPT_CACHE_ENTRIES; i++) {
+		sc = &script_cache[i];
+		if (sc->text && !sc->stale && sc->hash == hash &&
+		    sc->flag == flag && !strcmp(sc->text, s))
+			return sc;
+	}
+	return NULL;
+}
+
+/* Keeps a pipe list that parse_stream_outer() has just run */
+static void script_record_list(struct script_cache *rec, struct pipe *list)
+{
+	struct pipe **lists;
+
+	lists = realloc(rec->lists, (rec->num_lists + 1) * sizeof(*lists));
+	if (!lists) {
+		free_pipe_list(list, 0);
+		rec->stale = 1;
+		return;
+	}
+	lists[rec->num_lists++] = list;
+	rec->lists = lists;
+}
+
+/* Moves a recording into the cache, or throws it away */
+static void script_cache_store(struct script_cache *rec)
+{
+	struct script_cache *sc = NULL;
+	int i;
+
+	if (rec->stale || !rec->num_lists ||
+	    script_cache_find(rec->text, rec->hash, rec->flag))
+		goto discard;
+
+	for (i = 0; i < CONFIG_HUSH_SCRIPT_CACHE_ENTRIES; i++) {
+		if (!script_cache[i].text) {
+			sc = &script_cache[i];
+			break;
+		}
+		if (script_cache[i].busy)
+			continue;
+		if (!sc || script_cache[i].stamp < sc->stamp)
+			sc = &script_cache[i];
+	}
+	if (!sc)
+		goto discard;
+	if (sc->text)
+		script_cache_free(sc);
+
+	*sc = *rec;
+	sc->stamp = ++script_cache_clock;
+	return;
+
+discard:
+	script_free_lists(rec);
+	free(rec->text);
+}
+
+void hush_script_cache_forget(const char *s)
+{
+	struct script_cache *sc;
+	int i;
+
+	if (!s)
+		return;
+	for (i = 0; i < CONFIG_HUSH_SCRIPT_CACHE_ENTRIES; i++) {
+		sc = &script_cache[i];
+		if (!sc->text || strcmp(sc->text, s))
+			continue;
+		if (sc->busy)
+			sc->stale = 1;
+		else
+			script_cache_free(sc);
+	}
+}
+
+static int script_cache_run(struct script_cache *sc)
+{
+	int code = 0;
+	int i;
+
+	sc->busy++;
+	sc->stamp = ++script_cache_clock;
+	for (i = 0; i < sc->num_lists; i++) {
+		/* Same handling of the result as parse_stream_outer() */
+		code = run_list_real(sc->lists[i]);
+		if (code == -2) {	/* exit */
+			code = 0;
+			break;
+		}
+		if (code == -1)
+			flag_repeat = 0;
+	}
+	if (!--sc->busy && sc->stale)
+		script_cache_free(sc);
+	return (code != 0) ? 1 : 0;
+}
+#endif /* CONFIG_HUSH_SCRIPT_CACHE */
+
+struct script_cache;
+
+/* Parses and runs the input line by line.  With rec set, the pipe list
+ * of each line is kept in rec instead of being freed after it ran.
+ */
+static int parse_stream_outer_rec(struct in_str *inp, int flag,
+				  struct script_cache *rec)
 {
 
 	struct p_context ctx;
@@ -3142,10 +3326,21 @@ int parse_stream_outer(struct in_str *inp, int flag)
 #ifndef __U_BOOT__
 			run_list(ctx.list_head);
 #else
+#ifdef CONFIG_HUSH_SCRIPT_CACHE
+			if (rec) {
+				code = run_list_real(ctx.list_head);
+				script_record_list(rec, ctx.list_head);
+			} else
+#endif
 			code = run_list(ctx.list_head);
 			if (code == -2) {	/* exit */
 				b_free(&temp);
 				code = 0;
+#ifdef CONFIG_HUSH_SCRIPT_CACHE
+				/* The rest of the input was never parsed */
+				if (rec)
+					rec->stale = 1;
+#endif
 				/* XXX hackish way to not allow exit from main loop */
 				if (inp->peek == file_peek) {
 					printf("exit not allowed from main input shell.\n");
@@ -3169,6 +3364,11 @@ int parse_stream_outer(struct in_str *inp, int flag)
 			temp.quote = 0;
 			inp->p = NULL;
 			free_pipe_list(ctx.list_head,0);
+#ifdef CONFIG_HUSH_SCRIPT_CACHE
+			/* Keep reporting syntax errors every time */
+			if (rec)
+				rec->stale = 1;
+#endif
 		}
 		b_free(&temp);
 	} while (rcode != -1 && !(flag & FLAG_EXIT_FROM_LOOP));   /* loop on syntax errors, return on EOF */
@@ -3179,6 +3379,13 @@ int parse_stream_outer(struct in_str *inp, int flag)
 #endif /* __U_BOOT__ */
 }
 
+/* most recursion does not come through here, the exeception is
+ * from builtin_source() */
+int parse_stream_outer(struct in_str *inp, int flag)
+{
+	return parse_stream_outer_rec(inp, flag, NULL);
+}
+
 #ifndef __U_BOOT__
 static int parse_string_outer(const char *s, int flag)
 #else
@@ -3189,22 +3396,53 @@ int parse_string_outer(const char *s, int flag)
 #ifdef __U_BOOT__
 	char *p = NULL;
 	int rcode;
+	struct script_cache *rec = NULL;
+#ifdef CONFIG_HUSH_SCRIPT_CACHE
+	struct script_cache *sc, new_rec;
+	unsigned int hash;
+#endif
 	if ( !s || !*s)
 		return 1;
+#ifdef CONFIG_HUSH_SCRIPT_CACHE
+	/* Expanded variables are parsed again with FLAG_REPARSING and differ
+	 * every time.  IFS changes how lines are split into words, so scripts
+	 * that may set it are not cached.
+	 */
+	if (!(flag & FLAG_REPARSING) && !getenv("IFS") && !strstr(s, "IFS")) {
+		hash = script_hash(s);
+		sc = script_cache_find(s, hash, flag);
+		if (sc && !sc->busy)
+			return script_cache_run(sc);
+		/* The text may be freed by a setenv while it runs */
+		memset(&new_rec, 0, sizeof(new_rec));
+		new_rec.text = strdup(s);
+		new_rec.hash = hash;
+		new_rec.flag = flag;
+		if (!sc && new_rec.text)
+			rec = &new_rec;
+		else
+			free(new_rec.text);
+	}
+#endif
 	if (!(p = strchr(s, '\n')) || *++p) {
 		p = xmalloc(strlen(s) + 2);
 		strcpy(p, s);
 		strcat(p, "\n");
 		setup_string_in_str(&input, p);
-		rcode = parse_stream_outer(&input, flag);
+		rcode = parse_stream_outer_rec(&input, flag, rec);
 		free(p);
-		return rcode;
 	} else {
+		setup_string_in_str(&input, s);
+		rcode = parse_stream_outer_rec(&input, flag, rec);
+	}
+#ifdef CONFIG_HUSH_SCRIPT_CACHE
+	if (rec)
+		script_cache_store(rec);
 #endif
+	return rcode;
+#else
 	setup_string_in_str(&input, s);
 	return parse_stream_outer(&input, flag);
-#ifdef __U_BOOT__
-	}
 #endif
 }
 
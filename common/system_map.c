@@ -5,4 +5,10 @@
  * Licensed under the GPL-2 or later.
  */
 
-const char const system_map[] = SYSTEM_MAP;
+/*
+ * One "<address> <symbol>\0" string per text symbol, generated by the top
+ * level Makefile from the first link of u-boot.
+ */
+const char const system_map[] =
+#include <generated/system_map.h>
+	"";
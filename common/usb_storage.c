@@ -54,6 +54,7 @@
 #include <asm/processor.h>
 
 #include <part.h>
+#include <blkcache.h>
 #include <usb.h>
 
 #undef BBB_COMDAT_TRACE
@@ -136,6 +137,7 @@ struct us_data {
 	struct usb_device *pusb_dev;	 /* this usb_device */
 
 	unsigned int	flags;			/* from filter initially */
+#	define USB_READY	(1 << 0)	/* unit ready, skip TUR */
 	unsigned char	ifnum;			/* interface number */
 	unsigned char	ep_in;			/* in endpoint */
 	unsigned char	ep_out;			/* out ....... */
@@ -159,6 +161,23 @@ struct us_data {
 static struct us_data usb_stor[USB_MAX_STOR_DEV];
 
 
+/*
+ * The EHCI driver chains as many qTDs as a transfer needs, so a single
+ * READ(10)/WRITE(10) can move many blocks.  Every command costs a CBW and
+ * a CSW round trip, so bigger is much faster, but each command has to
+ * finish within the fixed bulk timeout (USB_TIMEOUT_MS) even on a slow
+ * stick that is writing, so it is capped at 1 MiB.
+ * Other host drivers are limited to 16 KiB per transfer.
+ */
+#ifdef CONFIG_USB_EHCI
+#define USB_MAX_XFER_BYTES	(1 << 20)
+#define USB_MAX_XFER_BLK(blksz)	\
+	((USB_MAX_XFER_BYTES / (blksz)) < 65535 ? \
+	 (USB_MAX_XFER_BYTES / (blksz)) : 65535)
+#else
+#define USB_MAX_XFER_BLK(blksz)	((4096 * 4) / (blksz))
+#endif
+
 #define USB_STOR_TRANSPORT_GOOD	   0
 #define USB_STOR_TRANSPORT_FAILED -1
 #define USB_STOR_TRANSPORT_ERROR  -2
@@ -238,6 +257,7 @@ int usb_stor_scan(int mode)
 	usb_disable_asynch(1); /* asynch transfer not allowed */
 
 	for (i = 0; i < USB_MAX_STOR_DEV; i++) {
+		blkcache_invalidate(&usb_dev_desc[i]);
 		memset(&usb_dev_desc[i], 0, sizeof(block_dev_desc_t));
 		usb_dev_desc[i].if_type = IF_TYPE_USB;
 		usb_dev_desc[i].dev = i;
@@ -485,6 +505,7 @@ static int usb_stor_BBB_reset(struct us_data *us)
 	 * This comment stolen from FreeBSD's /sys/dev/usb/umass.c.
 	 */
 	USB_STOR_PRINTF("BBB_reset\n");
+	us->flags &= ~USB_READY;
 	result = usb_control_msg(us->pusb_dev, usb_sndctrlpipe(us->pusb_dev, 0),
 				 US_BBB_RESET,
 				 USB_TYPE_CLASS | USB_RECIP_INTERFACE,
@@ -526,6 +547,7 @@ static int usb_stor_CB_reset(struct us_data *us)
 	int result;
 
 	USB_STOR_PRINTF("CB_reset\n");
+	us->flags &= ~USB_READY;
 	memset(cmd, 0xff, sizeof(cmd));
 	cmd[0] = SCSI_SEND_DIAG;
 	cmd[1] = 4;
@@ -750,7 +772,9 @@ int usb_stor_BBB_transport(ccb *srb, struct us_data *us)
 		usb_stor_BBB_reset(us);
 		return USB_STOR_TRANSPORT_FAILED;
 	}
-	mdelay(5);
+	/* Only give a device that is not known to be ready time to settle */
+	if (!(us->flags & USB_READY))
+		mdelay(5);
 	pipein = usb_rcvbulkpipe(us->pusb_dev, us->ep_in);
 	pipeout = usb_sndbulkpipe(us->pusb_dev, us->ep_out);
 	/* DATA phase + error handling */
@@ -1015,8 +1039,10 @@ static int usb_test_unit_ready(ccb *srb, struct us_data *ss)
 		srb->cmd[1] = srb->lun << 5;
 		srb->datalen = 0;
 		srb->cmdlen = 12;
-		if (ss->transport(srb, ss) == USB_STOR_TRANSPORT_GOOD)
+		if (ss->transport(srb, ss) == USB_STOR_TRANSPORT_GOOD) {
+			ss->flags |= USB_READY;
 			return 0;
+		}
 		usb_request_sense(srb, ss);
 		/*
 		 * Check the Key Code Qualifier, if it matches
@@ -1141,7 +1167,7 @@ unsigned long usb_stor_read(int device, unsigned long blknr,
 	buf_addr = (unsigned long)buffer;
 	start = blknr;
 	blks = blkcnt;
-	if (usb_test_unit_ready(srb, ss)) {
+	if (!(ss->flags & USB_READY) && usb_test_unit_ready(srb, ss)) {
 		printf("Device NOT ready\n   Request Sense returned %02X %02X"
 		       " %02X\n", srb->sense_buf[2], srb->sense_buf[12],
 		       srb->sense_buf[13]);
@@ -1166,6 +1192,7 @@ retry_it:
 		srb->pdata = (unsigned char *)buf_addr;
 		if (usb_read_10(srb, ss, start, smallblks)) {
 			USB_STOR_PRINTF("Read ERROR\n");
+			ss->flags &= ~USB_READY;
 			usb_request_sense(srb, ss);
 			if (retry--)
 				goto retry_it;
@@ -1218,7 +1245,7 @@ unsigned long usb_stor_write(int device, unsigned long blknr,
 	buf_addr = (unsigned long)buffer;
 	start = blknr;
 	blks = blkcnt;
-	if (usb_test_unit_ready(srb, ss)) {
+	if (!(ss->flags & USB_READY) && usb_test_unit_ready(srb, ss)) {
 		printf("Device NOT ready\n   Request Sense returned %02X %02X"
 		       " %02X\n", srb->sense_buf[2], srb->sense_buf[12],
 			srb->sense_buf[13]);
@@ -1245,6 +1272,7 @@ retry_it:
 		srb->pdata = (unsigned char *)buf_addr;
 		if (usb_write_10(srb, ss, start, smallblks)) {
 			USB_STOR_PRINTF("Write ERROR\n");
+			ss->flags &= ~USB_READY;
 			usb_request_sense(srb, ss);
 			if (retry--)
 				goto retry_it;
@@ -1487,11 +1515,7 @@ int usb_stor_get_info(struct usb_device *dev, struct us_data *ss,
 	USB_STOR_PRINTF(" address %d\n", dev_desc->target);
 	USB_STOR_PRINTF("partype: %d\n", dev_desc->part_type);
 
-	/*
-	 * The U-Boot EHCI driver cannot handle more than 4096 * 5 bytes in a
-	 * transfer without running itself out of qt_buffers.
-	 */
-	ss->max_xfer_blk = (4096 * 4) / dev_desc->blksz;
+	ss->max_xfer_blk = USB_MAX_XFER_BLK(dev_desc->blksz);
 
 	init_part(dev_desc);
 
@@ -0,0 +1,270 @@
+/*
+ * Block device read cache
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * The cache holds CONFIG_SYS_BLKCACHE_ENTRIES windows of
+ * CONFIG_SYS_BLKCACHE_WINDOW bytes each.  A read that fits in a window
+ * and misses fetches a whole window starting at the requested block, so
+ * the FAT, directory clusters and ext2 group descriptors that follow are
+ * already in memory for the next request.  Reads larger than a window
+ * go straight to the device.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <part.h>
+#include <blkcache.h>
+
+#ifndef CONFIG_SYS_BLKCACHE_ENTRIES
+# define CONFIG_SYS_BLKCACHE_ENTRIES	16
+#endif
+
+#ifndef CONFIG_SYS_BLKCACHE_WINDOW
+# define CONFIG_SYS_BLKCACHE_WINDOW	(32 * 1024)
+#endif
+
+struct blkcache_entry {
+	block_dev_desc_t	*dev_desc;	/* NULL if unused */
+	unsigned long		start;		/* first cached block */
+	lbaint_t		blkcnt;		/* valid blocks in buf */
+	unsigned long		blksz;		/* block size when filled */
+	unsigned long		stamp;		/* LRU stamp */
+	void			*buf;
+};
+
+static struct blkcache_entry *blkcache;
+static unsigned long blkcache_clock;
+static int blkcache_disabled;
+static int blkcache_nomem;
+static struct blkcache_stats stats;
+
+/*
+ * Allocate the windows on first use so boards that never touch a disk pay
+ * nothing.  Returns 0 if the cache can be used.
+ */
+static int blkcache_setup(void)
+{
+	int i;
+
+	if (blkcache)
+		return 0;
+	if (blkcache_nomem)
+		return -1;
+
+	blkcache = calloc(CONFIG_SYS_BLKCACHE_ENTRIES, sizeof(*blkcache));
+	if (!blkcache)
+		goto nomem;
+
+	for (i = 0; i < CONFIG_SYS_BLKCACHE_ENTRIES; i++) {
+		blkcache[i].buf = memalign(ARCH_DMA_MINALIGN,
+					   CONFIG_SYS_BLKCACHE_WINDOW);
+		if (!blkcache[i].buf)
+			goto nomem;
+	}
+	return 0;
+
+nomem:
+	if (blkcache) {
+		for (i = 0; i < CONFIG_SYS_BLKCACHE_ENTRIES; i++)
+			free(blkcache[i].buf);
+		free(blkcache);
+		blkcache = NULL;
+	}
+	printf("blkcache: out of memory, caching disabled\n");
+	blkcache_nomem = 1;
+	return -1;
+}
+
+static struct blkcache_entry *blkcache_lookup(block_dev_desc_t *dev_desc,
+					      unsigned long start,
+					      lbaint_t blkcnt)
+{
+	struct blkcache_entry *e;
+	int i;
+
+	for (i = 0; i < CONFIG_SYS_BLKCACHE_ENTRIES; i++) {
+		e = &blkcache[i];
+		if (e->dev_desc == dev_desc &&
+		    e->blksz == dev_desc->blksz &&
+		    start >= e->start &&
+		    start + blkcnt <= e->start + e->blkcnt)
+			return e;
+	}
+	return NULL;
+}
+
+static struct blkcache_entry *blkcache_victim(void)
+{
+	struct blkcache_entry *victim = &blkcache[0];
+	int i;
+
+	for (i = 0; i < CONFIG_SYS_BLKCACHE_ENTRIES; i++) {
+		if (!blkcache[i].dev_desc)
+			return &blkcache[i];
+		if (blkcache[i].stamp < victim->stamp)
+			victim = &blkcache[i];
+	}
+	return victim;
+}
+
+unsigned long blkcache_read(block_dev_desc_t *dev_desc, unsigned long start,
+			    lbaint_t blkcnt, void *buffer)
+{
+	struct blkcache_entry *e;
+	unsigned long blksz = dev_desc->blksz;
+	lbaint_t window;
+	unsigned long n;
+
+	if (!dev_desc->block_read)
+		return 0;
+
+	if (blkcache_disabled || !blksz || blkcnt == 0 ||
+	    blkcnt * blksz > CONFIG_SYS_BLKCACHE_WINDOW ||
+	    blkcache_setup()) {
+		stats.bypass++;
+		return dev_desc->block_read(dev_desc->dev, start, blkcnt,
+					    buffer);
+	}
+
+	e = blkcache_lookup(dev_desc, start, blkcnt);
+	if (e) {
+		stats.hits++;
+		e->stamp = ++blkcache_clock;
+		memcpy(buffer, e->buf + (start - e->start) * blksz,
+		       blkcnt * blksz);
+		return blkcnt;
+	}
+
+	stats.misses++;
+	window = CONFIG_SYS_BLKCACHE_WINDOW / blksz;
+	if (dev_desc->lba && start + window > dev_desc->lba)
+		window = dev_desc->lba > start ? dev_desc->lba - start : blkcnt;
+	if (window < blkcnt)
+		window = blkcnt;
+
+	e = blkcache_victim();
+	e->dev_desc = NULL;
+	n = dev_desc->block_read(dev_desc->dev, start, window, e->buf);
+	if (n < blkcnt) {
+		/*
+		 * The read-ahead may have failed past a bad or missing block;
+		 * retry just what was asked for without caching it.
+		 */
+		if (window == blkcnt) {
+			memcpy(buffer, e->buf, n * blksz);
+			return n;
+		}
+		return dev_desc->block_read(dev_desc->dev, start, blkcnt,
+					    buffer);
+	}
+
+	e->dev_desc = dev_desc;
+	e->start = start;
+	e->blkcnt = n;
+	e->blksz = blksz;
+	e->stamp = ++blkcache_clock;
+	stats.ra_blocks += n - blkcnt;
+	memcpy(buffer, e->buf, blkcnt * blksz);
+	return blkcnt;
+}
+
+unsigned long blkcache_write(block_dev_desc_t *dev_desc, unsigned long start,
+			     lbaint_t blkcnt, const void *buffer)
+{
+	struct blkcache_entry *e;
+	unsigned long blksz = dev_desc->blksz;
+	unsigned long first, last, n;
+	int i;
+
+	if (!dev_desc->block_write)
+		return 0;
+
+	fat_dcache_invalidate(dev_desc);
+	n = dev_desc->block_write(dev_desc->dev, start, blkcnt, buffer);
+	if (!blkcache)
+		return n;
+
+	stats.writes++;
+	for (i = 0; i < CONFIG_SYS_BLKCACHE_ENTRIES; i++) {
+		e = &blkcache[i];
+		if (e->dev_desc != dev_desc)
+			continue;
+		first = max(start, e->start);
+		last = min(start + blkcnt, e->start + e->blkcnt);
+		if (first >= last)
+			continue;
+		/* On a short write we do not know what the device holds */
+		if (n != blkcnt || e->blksz != blksz) {
+			e->dev_desc = NULL;
+			continue;
+		}
+		memcpy(e->buf + (first - e->start) * blksz,
+		       buffer + (first - start) * blksz,
+		       (last - first) * blksz);
+	}
+	return n;
+}
+
+void blkcache_invalidate(block_dev_desc_t *dev_desc)
+{
+	int i;
+
+	fat_dcache_invalidate(dev_desc);
+	if (!blkcache)
+		return;
+
+	for (i = 0; i < CONFIG_SYS_BLKCACHE_ENTRIES; i++)
+		if (blkcache[i].dev_desc == dev_desc)
+			blkcache[i].dev_desc = NULL;
+}
+
+void blkcache_invalidate_all(void)
+{
+	int i;
+
+	fat_dcache_invalidate(NULL);
+	if (!blkcache)
+		return;
+
+	for (i = 0; i < CONFIG_SYS_BLKCACHE_ENTRIES; i++)
+		blkcache[i].dev_desc = NULL;
+}
+
+void blkcache_enable(int enable)
+{
+	if (!enable)
+		blkcache_invalidate_all();
+	blkcache_disabled = !enable;
+}
+
+void blkcache_get_stats(struct blkcache_stats *s)
+{
+	*s = stats;
+	s->entries = CONFIG_SYS_BLKCACHE_ENTRIES;
+	s->window = CONFIG_SYS_BLKCACHE_WINDOW;
+	s->enabled = !blkcache_disabled && !blkcache_nomem;
+}
+
+void blkcache_clear_stats(void)
+{
+	memset(&stats, 0, sizeof(stats));
+}
@@ -33,6 +33,7 @@
 #include <common.h>
 #include <command.h>
 #include <ide.h>
+#include <blkcache.h>
 #include "part_dos.h"
 
 #if defined(CONFIG_CMD_IDE) || \
@@ -88,7 +89,7 @@ int test_part_dos (block_dev_desc_t *dev_desc)
 {
 	ALLOC_CACHE_ALIGN_BUFFER(unsigned char, buffer, dev_desc->blksz);
 
-	if ((dev_desc->block_read(dev_desc->dev, 0, 1, (ulong *) buffer) != 1) ||
+	if ((blkcache_read(dev_desc, 0, 1, (ulong *) buffer) != 1) ||
 	    (buffer[DOS_PART_MAGIC_OFFSET + 0] != 0x55) ||
 	    (buffer[DOS_PART_MAGIC_OFFSET + 1] != 0xaa) ) {
 		return (-1);
@@ -105,7 +106,7 @@ static void print_partition_extended (block_dev_desc_t *dev_desc, int ext_part_s
 	dos_partition_t *pt;
 	int i;
 
-	if (dev_desc->block_read(dev_desc->dev, ext_part_sector, 1, (ulong *) buffer) != 1) {
+	if (blkcache_read(dev_desc, ext_part_sector, 1, (ulong *) buffer) != 1) {
 		printf ("** Can't read partition table on %d:%d **\n",
 			dev_desc->dev, ext_part_sector);
 		return;
@@ -169,7 +170,7 @@ static int get_partition_info_extended (block_dev_desc_t *dev_desc, int ext_part
 	dos_partition_t *pt;
 	int i;
 
-	if (dev_desc->block_read (dev_desc->dev, ext_part_sector, 1, (ulong *) buffer) != 1) {
+	if (blkcache_read(dev_desc, ext_part_sector, 1, (ulong *) buffer) != 1) {
 		printf ("** Can't read partition table on %d:%d **\n",
 			dev_desc->dev, ext_part_sector);
 		return -1;
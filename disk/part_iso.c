@@ -23,6 +23,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <blkcache.h>
 #include "part_iso.h"
 
 #if defined(CONFIG_CMD_IDE) || \
@@ -80,7 +81,7 @@ int get_partition_info_iso_verb(block_dev_desc_t * dev_desc, int part_num, disk_
 
 	/* the first sector (sector 0x10) must be a primary volume desc */
 	blkaddr=PVD_OFFSET;
-	if (dev_desc->block_read (dev_desc->dev, PVD_OFFSET, 1, (ulong *) tmpbuf) != 1)
+	if (blkcache_read(dev_desc, PVD_OFFSET, 1, (ulong *) tmpbuf) != 1)
 	return (-1);
 	if(ppr->desctype!=0x01) {
 		if(verb)
@@ -102,7 +103,7 @@ int get_partition_info_iso_verb(block_dev_desc_t * dev_desc, int part_num, disk_
 	PRINTF(" Lastsect:%08lx\n",lastsect);
 	for(i=blkaddr;i<lastsect;i++) {
 		PRINTF("Reading block %d\n", i);
-		if (dev_desc->block_read (dev_desc->dev, i, 1, (ulong *) tmpbuf) != 1)
+		if (blkcache_read(dev_desc, i, 1, (ulong *) tmpbuf) != 1)
 		return (-1);
 		if(ppr->desctype==0x00)
 			break; /* boot entry found */
@@ -122,7 +123,7 @@ int get_partition_info_iso_verb(block_dev_desc_t * dev_desc, int part_num, disk_
 	}
 	bootaddr=le32_to_int(pbr->pointer);
 	PRINTF(" Boot Entry at: %08lX\n",bootaddr);
-	if (dev_desc->block_read (dev_desc->dev, bootaddr, 1, (ulong *) tmpbuf) != 1) {
+	if (blkcache_read(dev_desc, bootaddr, 1, (ulong *) tmpbuf) != 1) {
 		if(verb)
 			printf ("** Can't read Boot Entry at %lX on %d:%d **\n",
 				bootaddr,dev_desc->dev, part_num);
@@ -32,6 +32,7 @@
 #include <common.h>
 #include <command.h>
 #include <ide.h>
+#include <blkcache.h>
 #include "part_mac.h"
 
 #if defined(CONFIG_CMD_IDE) || \
@@ -71,7 +72,7 @@ int test_part_mac (block_dev_desc_t *dev_desc)
 
 	n = 1;	/* assuming at least one partition */
 	for (i=1; i<=n; ++i) {
-		if ((dev_desc->block_read(dev_desc->dev, i, 1, (ulong *)&mpart) != 1) ||
+		if ((blkcache_read(dev_desc, i, 1, (ulong *)&mpart) != 1) ||
 		    (mpart.signature != MAC_PARTITION_MAGIC) ) {
 			return (-1);
 		}
@@ -124,7 +125,7 @@ void print_part_mac (block_dev_desc_t *dev_desc)
 		char c;
 
 		printf ("%4ld: ", i);
-		if (dev_desc->block_read (dev_desc->dev, i, 1, (ulong *)&mpart) != 1) {
+		if (blkcache_read(dev_desc, i, 1, (ulong *)&mpart) != 1) {
 			printf ("** Can't read Partition Map on %d:%ld **\n",
 				dev_desc->dev, i);
 			return;
@@ -170,7 +171,7 @@ void print_part_mac (block_dev_desc_t *dev_desc)
  */
 static int part_mac_read_ddb (block_dev_desc_t *dev_desc, mac_driver_desc_t *ddb_p)
 {
-	if (dev_desc->block_read(dev_desc->dev, 0, 1, (ulong *)ddb_p) != 1) {
+	if (blkcache_read(dev_desc, 0, 1, (ulong *)ddb_p) != 1) {
 		printf ("** Can't read Driver Desriptor Block **\n");
 		return (-1);
 	}
@@ -198,7 +199,7 @@ static int part_mac_read_pdb (block_dev_desc_t *dev_desc, int part, mac_partitio
 		 * partition 1 first since this is the only way to
 		 * know how many partitions we have.
 		 */
-		if (dev_desc->block_read (dev_desc->dev, n, 1, (ulong *)pdb_p) != 1) {
+		if (blkcache_read(dev_desc, n, 1, (ulong *)pdb_p) != 1) {
 			printf ("** Can't read Partition Map on %d:%d **\n",
 				dev_desc->dev, n);
 			return (-1);
@@ -28,6 +28,7 @@
 #include <command.h>
 #include <mmc.h>
 #include <part.h>
+#include <blkcache.h>
 #include <malloc.h>
 #include <linux/list.h>
 #include <div64.h>
@@ -1242,6 +1243,7 @@ int mmc_startup(struct mmc *mmc)
 	}
 
 	/* fill in device description */
+	blkcache_invalidate(&mmc->block_dev);
 	mmc->block_dev.lun = 0;
 	mmc->block_dev.type = 0;
 	mmc->block_dev.blksz = mmc->read_bl_len;
@@ -41,6 +41,7 @@
 #include <command.h>
 #include <mmc.h>
 #include <part.h>
+#include <blkcache.h>
 #include <malloc.h>
 #include <errno.h>
 #include <asm/arch/octeon_mmc.h>
@@ -50,6 +51,7 @@
 #include <asm/arch/cvmx-access.h>
 #include <asm/arch/cvmx-mio-defs.h>
 #include <asm/arch/octeon_board_mmc.h>
+#include <asm/arch/octeon_l2_lock.h>
 #include <linux/list.h>
 #include <div64.h>
 #include <watchdog.h>
@@ -703,11 +705,35 @@ err_out:
 	return err;
 }
 
+#ifdef CONFIG_OCTEON_L2_LOCK
+/**
+ * Returns the buffer used for unaligned transfers.  It is allocated once
+ * and locked in L2 so block-at-a-time transfers do not go through DRAM;
+ * if that fails the caller's stack buffer is used.
+ */
+static unsigned char *mmc_bounce_buffer(unsigned char *stack_buffer)
+{
+	static unsigned char *l2_buffer;
+
+	if (!l2_buffer) {
+		l2_buffer = memalign(CVMX_CACHE_LINE_SIZE, 4096);
+		if (!l2_buffer)
+			return stack_buffer;
+		octeon_l2_lock(cvmx_ptr_to_phys(l2_buffer), 4096,
+			       OCTEON_L2_LOCK_STORAGE);
+	}
+	return l2_buffer;
+}
+#else
+# define mmc_bounce_buffer(stack_buffer)	(stack_buffer)
+#endif
+
 static ulong mmc_bread(int dev_num, ulong start, lbaint_t blkcnt, void *dst)
 {
 	lbaint_t cur, blocks_todo = blkcnt;
 	struct mmc *mmc = find_mmc_device(dev_num);
-	unsigned char bounce_buffer[4096];
+	unsigned char stack_buffer[4096];
+	unsigned char *bounce_buffer;
 
 	debug("%s(%d, %lu, %llu, %p)\n", __func__, dev_num, start,
 	      (uint64_t)blkcnt, dst);
@@ -726,6 +752,7 @@ static ulong mmc_bread(int dev_num, ulong start, lbaint_t blkcnt, void *dst)
 
 	if (((ulong)dst) & 7) {
 		debug("%s: Using bounce buffer due to alignment\n", __func__);
+		bounce_buffer = mmc_bounce_buffer(stack_buffer);
 		do {
 			if (mmc_read(mmc, start, bounce_buffer, 1) != 1)
 				return 0;
@@ -755,7 +782,8 @@ static ulong mmc_bwrite(int dev_num, ulong start, lbaint_t blkcnt,
 {
 	lbaint_t cur, blocks_todo = blkcnt;
 	struct mmc *mmc = find_mmc_device(dev_num);
-	unsigned char bounce_buffer[4096];
+	unsigned char stack_buffer[4096];
+	unsigned char *bounce_buffer;
 	struct mmc_host *host;
 
 	debug("%s(%d, %lu, %llu, %p)\n", __func__, dev_num, start,
@@ -791,6 +819,7 @@ static ulong mmc_bwrite(int dev_num, ulong start, lbaint_t blkcnt,
 	}
 	if (((ulong)src) & 7) {
 		debug("%s: Using bounce buffer due to alignment\n", __func__);
+		bounce_buffer = mmc_bounce_buffer(stack_buffer);
 		do {
 			memcpy(bounce_buffer, src, mmc->write_bl_len);
 			if (mmc_write(mmc, start, 1, bounce_buffer) != 1)
@@ -2814,6 +2843,7 @@ int mmc_startup(struct mmc *mmc)
 
 	/* Fill in device description */
 	debug("%s: Filling in block descriptor\n",  __func__);
+	blkcache_invalidate(&mmc->block_dev);
 	mmc->block_dev.lun = 0;
 	mmc->block_dev.type = 0;
 	mmc->block_dev.blksz = mmc->read_bl_len;
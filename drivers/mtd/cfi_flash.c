@@ -42,6 +42,7 @@
 #include <asm/io.h>
 #include <asm/byteorder.h>
 #include <environment.h>
+#include <malloc.h>
 #include <mtd/cfi_flash.h>
 #include <watchdog.h>
 
@@ -1049,6 +1050,64 @@ out_unmap:
 #endif /* CONFIG_SYS_FLASH_USE_BUFFER_WRITE */
 
 
+/*-----------------------------------------------------------------------
+ * Issue the erase command for one sector without waiting for it.
+ */
+static void flash_erase_start (flash_info_t * info, flash_sect_t sect)
+{
+	switch (info->vendor) {
+	case CFI_CMDSET_INTEL_PROG_REGIONS:
+	case CFI_CMDSET_INTEL_STANDARD:
+	case CFI_CMDSET_INTEL_EXTENDED:
+		flash_write_cmd (info, sect, 0, FLASH_CMD_CLEAR_STATUS);
+		flash_write_cmd (info, sect, 0, FLASH_CMD_BLOCK_ERASE);
+		flash_write_cmd (info, sect, 0, FLASH_CMD_ERASE_CONFIRM);
+		break;
+	case CFI_CMDSET_AMD_STANDARD:
+	case CFI_CMDSET_AMD_EXTENDED:
+		flash_write_cmd (info, 0, 0, AMD_CMD_RESET);
+		flash_unlock_seq (info, sect);
+		flash_write_cmd (info, sect, info->addr_unlock1,
+				 AMD_CMD_ERASE_START);
+		flash_unlock_seq (info, sect);
+		flash_write_cmd (info, sect, 0, AMD_CMD_ERASE_SECTOR);
+		break;
+#ifdef CONFIG_FLASH_CFI_LEGACY
+	case CFI_CMDSET_AMD_LEGACY:
+		flash_unlock_seq (info, 0);
+		flash_write_cmd (info, 0, info->addr_unlock1,
+				 AMD_CMD_ERASE_START);
+		flash_unlock_seq (info, 0);
+		flash_write_cmd (info, sect, 0, AMD_CMD_ERASE_SECTOR);
+		break;
+#endif
+	default:
+		debug ("Unkown flash vendor %d\n", info->vendor);
+		break;
+	}
+}
+
+/*-----------------------------------------------------------------------
+ * Wait for an erase started by flash_erase_start() to complete.
+ */
+static int flash_erase_wait (flash_info_t * info, flash_sect_t sect)
+{
+	if (use_flash_status_poll(info)) {
+		cfiword_t cword = (cfiword_t)0xffffffffffffffffULL;
+		void *dest;
+		int st;
+
+		dest = flash_map(info, sect, 0);
+		st = flash_status_poll(info, &cword, dest,
+				       info->erase_blk_tout, "erase");
+		flash_unmap(info, sect, 0, dest);
+		return st;
+	}
+
+	return flash_full_status_check(info, sect, info->erase_blk_tout,
+				       "erase");
+}
+
 /*-----------------------------------------------------------------------
  */
 int flash_erase (flash_info_t * info, int s_first, int s_last)
@@ -1056,7 +1115,6 @@ int flash_erase (flash_info_t * info, int s_first, int s_last)
 	int rcode = 0;
 	int prot;
 	flash_sect_t sect;
-	int st;
 
 	if (info->flash_id != FLASH_MAN_CFI) {
 		puts ("Can't erase unknown flash type - aborted\n");
@@ -1083,56 +1141,8 @@ int flash_erase (flash_info_t * info, int s_first, int s_last)
 
 	for (sect = s_first; sect <= s_last; sect++) {
 		if (info->protect[sect] == 0) { /* not protected */
-			switch (info->vendor) {
-			case CFI_CMDSET_INTEL_PROG_REGIONS:
-			case CFI_CMDSET_INTEL_STANDARD:
-			case CFI_CMDSET_INTEL_EXTENDED:
-				flash_write_cmd (info, sect, 0,
-						 FLASH_CMD_CLEAR_STATUS);
-				flash_write_cmd (info, sect, 0,
-						 FLASH_CMD_BLOCK_ERASE);
-				flash_write_cmd (info, sect, 0,
-						 FLASH_CMD_ERASE_CONFIRM);
-				break;
-			case CFI_CMDSET_AMD_STANDARD:
-			case CFI_CMDSET_AMD_EXTENDED:
-				flash_write_cmd (info, 0, 0, AMD_CMD_RESET);
-				flash_unlock_seq (info, sect);
-				flash_write_cmd (info, sect,
-						info->addr_unlock1,
-						AMD_CMD_ERASE_START);
-				flash_unlock_seq (info, sect);
-				flash_write_cmd (info, sect, 0,
-						 AMD_CMD_ERASE_SECTOR);
-				break;
-#ifdef CONFIG_FLASH_CFI_LEGACY
-			case CFI_CMDSET_AMD_LEGACY:
-				flash_unlock_seq (info, 0);
-				flash_write_cmd (info, 0, info->addr_unlock1,
-						AMD_CMD_ERASE_START);
-				flash_unlock_seq (info, 0);
-				flash_write_cmd (info, sect, 0,
-						AMD_CMD_ERASE_SECTOR);
-				break;
-#endif
-			default:
-				debug ("Unkown flash vendor %d\n",
-				       info->vendor);
-				break;
-			}
-
-			if (use_flash_status_poll(info)) {
-				cfiword_t cword = (cfiword_t)0xffffffffffffffffULL;
-				void *dest;
-				dest = flash_map(info, sect, 0);
-				st = flash_status_poll(info, &cword, dest,
-						       info->erase_blk_tout, "erase");
-				flash_unmap(info, sect, 0, dest);
-			} else
-				st = flash_full_status_check(info, sect,
-							     info->erase_blk_tout,
-							     "erase");
-			if (st)
+			flash_erase_start (info, sect);
+			if (flash_erase_wait (info, sect))
 				rcode = 1;
 			else if (flash_verbose)
 				putc ('.');
@@ -1145,6 +1155,238 @@ int flash_erase (flash_info_t * info, int s_first, int s_last)
 	return rcode;
 }
 
+/*-----------------------------------------------------------------------
+ * Sector-wise update of a flash range.
+ *
+ * Each sector touched by the range is compared with the new data first:
+ * sectors that already match are left alone and sectors that are still
+ * blank over the range are programmed without an erase.  Sectors that
+ * need an erase and lie in another bank than the sector being programmed
+ * are erased in the background, so on boards with several flash chips
+ * the erase of sector N+1 overlaps programming and verifying sector N.
+ * Within one chip the steps run back to back, since a single-bank part
+ * can not read or program while it erases.
+ */
+enum {
+	UPD_SAME,		/* already holds the data */
+	UPD_PROGRAM,		/* blank, program only */
+	UPD_ERASE,		/* erase and program */
+};
+
+struct flash_upd {
+	flash_info_t	*info;
+	flash_sect_t	sect;
+	ulong		start;		/* sector address */
+	ulong		size;		/* sector size */
+	ulong		addr;		/* updated part of the sector */
+	ulong		len;
+	uchar		*src;		/* new data for addr */
+	int		state;
+	int		erasing;	/* erase started, not yet waited for */
+	int		erase_rc;
+	ulong		t_erase;	/* ms, start time while erasing */
+	ulong		t_prog;
+};
+
+/*
+ * Non-zero if the flash at addr differs from src.  With
+ * CONFIG_FLASH_UPDATE_CRC both sides are hashed with crc32() instead,
+ * which pays off where crc32() reads the flash in wide words or has
+ * hardware help (Octeon) while memcmp() goes a byte at a time.
+ */
+static int flash_upd_differs (ulong addr, const uchar *src, ulong len)
+{
+#ifdef CONFIG_FLASH_UPDATE_CRC
+	return crc32(0, (const uchar *)addr, len) != crc32(0, src, len);
+#else
+	return memcmp((void *)addr, src, len);
+#endif
+}
+
+/* Describe the sector containing addr; returns 0 if addr is not in flash */
+static int flash_upd_get (struct flash_upd *u, uchar *src, ulong addr,
+			  ulong end)
+{
+	uchar *p;
+
+	memset(u, 0, sizeof(*u));
+	u->info = addr2info(addr);
+	if (!u->info)
+		return 0;
+	u->sect = find_sector(u->info, addr);
+	u->start = u->info->start[u->sect];
+	u->size = flash_sector_size(u->info, u->sect);
+	u->addr = addr;
+	u->len = min(end, u->start + u->size) - addr;
+	u->src = src;
+
+	if (!flash_upd_differs(u->addr, u->src, u->len)) {
+		u->state = UPD_SAME;
+		return 1;
+	}
+
+	u->state = UPD_PROGRAM;
+	for (p = (uchar *)u->addr; p < (uchar *)u->addr + u->len; p++) {
+		if (*p != 0xff) {
+			u->state = UPD_ERASE;
+			break;
+		}
+	}
+	return 1;
+}
+
+static void flash_upd_erase_start (struct flash_upd *u)
+{
+	flash_erase_start(u->info, u->sect);
+	u->erasing = 1;
+	u->t_erase = get_timer(0);
+}
+
+static int flash_upd_erase_wait (struct flash_upd *u)
+{
+	if (!u->erasing)
+		return u->erase_rc;
+	if (flash_erase_wait(u->info, u->sect))
+		u->erase_rc = ERR_NOT_ERASED;
+	u->erasing = 0;
+	u->t_erase = get_timer(u->t_erase);
+	return u->erase_rc;
+}
+
+/*
+ * Erase if needed and program one sector.  When only part of an erased
+ * sector is updated the rest is carried over from a copy in RAM.
+ */
+static int flash_upd_program (struct flash_upd *u)
+{
+	uchar *buf = NULL;
+	ulong addr = u->addr, len = u->len;
+	uchar *src = u->src;
+	int rc;
+
+	if (u->state == UPD_ERASE && u->len != u->size) {
+		buf = malloc(u->size);
+		if (!buf) {
+			puts("Out of memory\n");
+			return ERR_PROG_ERROR;
+		}
+		memcpy(buf, (void *)u->start, u->size);
+		memcpy(buf + (u->addr - u->start), u->src, u->len);
+		addr = u->start;
+		len = u->size;
+		src = buf;
+	}
+
+	if (u->state == UPD_ERASE && !u->erasing)
+		flash_upd_erase_start(u);
+	rc = flash_upd_erase_wait(u);
+
+	if (rc == ERR_OK) {
+		u->t_prog = get_timer(0);
+		rc = write_buff(u->info, src, addr, len);
+		u->t_prog = get_timer(u->t_prog);
+	}
+
+	free(buf);
+	return rc;
+}
+
+/*-----------------------------------------------------------------------
+ * Update the flash range at addr with cnt bytes from src, touching only
+ * the sectors whose contents differ.  Returns an ERR_* code like
+ * flash_write().
+ */
+int flash_update (char *src, ulong addr, ulong cnt)
+{
+	struct flash_upd upd[2], *cur = &upd[0], *next = &upd[1], *tmp;
+	ulong end = addr + cnt;
+	ulong start_time = get_timer(0);
+	int same = 0, erased = 0, programmed = 0;
+	flash_info_t *info, *info_first, *info_last;
+	flash_sect_t sect;
+	int rc = ERR_OK;
+
+	if (cnt == 0)
+		return ERR_OK;
+
+	info_first = addr2info(addr);
+	info_last = addr2info(end - 1);
+	if (!info_first || !info_last || info_last < info_first)
+		return ERR_INVAL;
+
+	for (info = info_first; info <= info_last; info++) {
+		/* Refuse a range across a gap between banks up front */
+		if (info < info_last &&
+		    info->start[0] + info->size != (info + 1)->start[0])
+			return ERR_INVAL;
+		for (sect = 0; sect < info->sector_count; sect++) {
+			ulong s_start = info->start[sect];
+			ulong s_end = s_start + flash_sector_size(info, sect);
+
+			if (s_start < end && addr < s_end &&
+			    info->protect[sect])
+				return ERR_PROTECTED;
+		}
+	}
+
+	if (!flash_upd_get(cur, (uchar *)src, addr, end))
+		return ERR_INVAL;
+
+	while (cur) {
+		ulong cur_end = cur->addr + cur->len;
+
+		/* The chip can not be read while it erases */
+		if (cur->erasing && addr2info(cur_end) == cur->info)
+			flash_upd_erase_wait(cur);
+		if (cur_end >= end ||
+		    !flash_upd_get(next, cur->src + cur->len, cur_end, end))
+			next = NULL;
+
+		/*
+		 * Let another chip erase while this one is busy.  A partly
+		 * updated sector is copied to RAM first, so it waits.
+		 */
+		if (next && next->state == UPD_ERASE &&
+		    next->info != cur->info && next->len == next->size)
+			flash_upd_erase_start(next);
+
+		printf("  %08lX ", cur->start);
+		if (cur->state == UPD_SAME) {
+			puts("unchanged\n");
+			same++;
+		} else {
+			rc = flash_upd_program(cur);
+			if (rc == ERR_OK &&
+			    flash_upd_differs(cur->addr, cur->src, cur->len)) {
+				puts("verify failed ");
+				rc = ERR_PROG_ERROR;
+			}
+			if (rc != ERR_OK) {
+				if (next)
+					flash_upd_erase_wait(next);
+				putc('\n');
+				return rc;
+			}
+
+			if (cur->state == UPD_ERASE) {
+				printf("erase %4lu ms, ", cur->t_erase);
+				erased++;
+			}
+			printf("program %4lu ms\n", cur->t_prog);
+			programmed++;
+		}
+
+		WATCHDOG_RESET();
+		tmp = cur;
+		cur = next;
+		next = tmp;
+	}
+
+	printf("%d sectors unchanged, %d erased, %d programmed in %lu ms\n",
+	       same, erased, programmed, get_timer(start_time));
+	return ERR_OK;
+}
+
 #ifdef CONFIG_SYS_FLASH_EMPTY_INFO
 static int sector_erased(flash_info_t *info, int i)
 {
@@ -26,6 +26,8 @@
 #include <linux/module.h>
 #include <linux/compiler.h>
 #endif
+#include <common.h>
+#include <u-boot/crc.h>
 #include <linux/types.h>
 
 #include <asm/byteorder.h>
@@ -68,7 +70,16 @@ MODULE_LICENSE("GPL");
  */
 u32  crc32_le(u32 crc, unsigned char const *p, size_t len);
 
-#if CRC_LE_BITS == 1
+#ifdef __HAVE_ARCH_CRC32
+/*
+ * The architecture has its own CRC32 (the CRC unit on Octeon). Its
+ * crc32_no_comp() computes exactly this CRC: no pre- or post-inversion.
+ */
+u32 crc32_le(u32 crc, unsigned char const *p, size_t len)
+{
+	return crc32_no_comp(crc, p, len);
+}
+#elif CRC_LE_BITS == 1
 /*
  * In fact, the table-based code will work in this case, but it can be
  * simplified by inlining the table in ?: form.
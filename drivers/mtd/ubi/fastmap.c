@@ -0,0 +1,630 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * UBI fastmap reader.
+ *
+ * A fastmap is a checkpoint of the scanning information which Linux UBI
+ * writes when it is built with fastmap support. It consists of a super block
+ * (the "anchor") stored in one of the first %UBI_FM_MAX_START physical
+ * eraseblocks and up to %UBI_FM_MAX_BLOCKS - 1 data eraseblocks. Together
+ * they record the erase counter of every PEB and the EBA table of every
+ * volume. Attaching from a fastmap only has to read those PEBs and the PEBs
+ * of the two pools, which UBI may have written since the fastmap was taken,
+ * so attach time no longer grows with the size of the flash.
+ *
+ * This unit only reads fastmaps. The PEBs of the fastmap are put to the
+ * @alien list so that they are preserved for Linux. Once U-Boot writes a VID
+ * header or erases a PEB the fastmap no longer describes the flash, so the
+ * anchor is erased before the first such change (see
+ * 'ubi_fastmap_invalidate()') and Linux falls back to full scanning on its
+ * next attach.
+ */
+
+#include <ubi_uboot.h>
+#include "ubi.h"
+
+/* Return codes of 'ubi_scan_fastmap()' asking for a full scan */
+#define UBI_NO_FASTMAP	1
+#define UBI_BAD_FASTMAP	2
+
+/* What the fastmap tells about a physical eraseblock */
+enum {
+	FM_PEB_UNKNOWN = 0,
+	FM_PEB_FREE,
+	FM_PEB_USED,
+	FM_PEB_SCRUB,
+	FM_PEB_ERASE,
+	FM_PEB_POOL,
+	FM_PEB_FASTMAP,
+	FM_PEB_MAPPED,
+};
+
+/**
+ * fm_get - get the next record of the fastmap.
+ * @fm: fastmap data
+ * @fm_pos: current position in @fm, advanced past the record
+ * @size: size of the record
+ * @fm_size: size of @fm
+ *
+ * Returns a pointer to the record or %NULL if it does not fit into @fm.
+ */
+static void *fm_get(void *fm, int *fm_pos, int size, int fm_size)
+{
+	void *p;
+
+	if (size < 0 || *fm_pos + size > fm_size)
+		return NULL;
+
+	p = fm + *fm_pos;
+	*fm_pos += size;
+	return p;
+}
+
+/**
+ * find_anchor - find the newest fastmap super block.
+ * @ubi: UBI device description object
+ * @ech: buffer for both headers, see 'ubi_io_read_hdrs()'
+ * @vidh: buffer for the VID header
+ * @ec: erase counter of the anchor is returned here
+ *
+ * Returns the PEB number of the anchor, %-1 if there is none, or a negative
+ * error code (less than %-1) in case of failure.
+ */
+static int find_anchor(struct ubi_device *ubi, struct ubi_ec_hdr *ech,
+		       struct ubi_vid_hdr *vidh, int *ec)
+{
+	int err, vid_err, pnum, anchor = -1, count;
+	unsigned long long sqnum, max_sqnum = 0;
+
+	count = min_t(int, ubi->peb_count, UBI_FM_MAX_START);
+	for (pnum = 0; pnum < count; pnum++) {
+		err = ubi_io_is_bad(ubi, pnum);
+		if (err < 0)
+			return err;
+		else if (err)
+			continue;
+
+		err = ubi_io_read_hdrs(ubi, pnum, ech, vidh, &vid_err, 0);
+		if (err < 0)
+			return err;
+		else if (err && err != UBI_IO_BITFLIPS)
+			continue;
+
+		err = vid_err;
+		if (err < 0)
+			return err;
+		else if (err && err != UBI_IO_BITFLIPS)
+			continue;
+
+		if (be32_to_cpu(vidh->vol_id) != UBI_FM_SB_VOLUME_ID)
+			continue;
+
+		sqnum = be64_to_cpu(vidh->sqnum);
+		if (anchor < 0 || sqnum > max_sqnum) {
+			anchor = pnum;
+			max_sqnum = sqnum;
+			*ec = be64_to_cpu(ech->ec);
+		}
+	}
+
+	return anchor;
+}
+
+/**
+ * read_fastmap - read and verify all PEBs of a fastmap.
+ * @ubi: UBI device description object
+ * @si: scanning information
+ * @anchor: PEB holding the fastmap super block
+ * @ech: buffer for both headers, see 'ubi_io_read_hdrs()'
+ * @vidh: buffer for the VID header
+ * @fm_size: size of the fastmap data is returned here
+ *
+ * Returns a vmalloc'ed buffer with the fastmap data, or %NULL if the fastmap
+ * is unreadable or inconsistent.
+ */
+static void *read_fastmap(struct ubi_device *ubi, struct ubi_scan_info *si,
+			  int anchor, struct ubi_ec_hdr *ech,
+			  struct ubi_vid_hdr *vidh, int *fm_size)
+{
+	int err, vid_err, i, pnum, used_blocks;
+	uint32_t crc, data_crc;
+	unsigned long long sqnum;
+	struct ubi_fm_sb *fmsb;
+	void *fm;
+
+	fmsb = kmalloc(sizeof(struct ubi_fm_sb), GFP_KERNEL);
+	if (!fmsb)
+		return NULL;
+
+	err = ubi_io_read(ubi, fmsb, anchor, ubi->leb_start, sizeof(*fmsb));
+	if (err && err != UBI_IO_BITFLIPS)
+		goto out_sb;
+
+	if (be32_to_cpu(fmsb->magic) != UBI_FM_SB_MAGIC) {
+		ubi_err("bad fastmap super block magic %#08x",
+			be32_to_cpu(fmsb->magic));
+		goto out_sb;
+	}
+
+	if (fmsb->version != UBI_FM_FMT_VERSION) {
+		ubi_err("fastmap version %d is not supported",
+			(int)fmsb->version);
+		goto out_sb;
+	}
+
+	used_blocks = be32_to_cpu(fmsb->used_blocks);
+	if (used_blocks < 1 || used_blocks > UBI_FM_MAX_BLOCKS ||
+	    be32_to_cpu(fmsb->block_loc[0]) != anchor) {
+		ubi_err("bad fastmap super block at PEB %d", anchor);
+		goto out_sb;
+	}
+
+	*fm_size = ubi->leb_size * used_blocks;
+	fm = vmalloc(*fm_size);
+	if (!fm)
+		goto out_sb;
+
+	for (i = 0; i < used_blocks; i++) {
+		pnum = be32_to_cpu(fmsb->block_loc[i]);
+		if (pnum < 0 || pnum >= ubi->peb_count)
+			goto out_fm;
+
+		if (i > 0) {
+			err = ubi_io_read_hdrs(ubi, pnum, ech, vidh, &vid_err, 0);
+			if (err && err != UBI_IO_BITFLIPS)
+				goto out_fm;
+
+			if (vid_err && vid_err != UBI_IO_BITFLIPS)
+				goto out_fm;
+
+			if (be32_to_cpu(vidh->vol_id) != UBI_FM_DATA_VOLUME_ID) {
+				ubi_err("PEB %d is not a fastmap data block",
+					pnum);
+				goto out_fm;
+			}
+
+			sqnum = be64_to_cpu(vidh->sqnum);
+			if (si->max_sqnum < sqnum)
+				si->max_sqnum = sqnum;
+		}
+
+		err = ubi_io_read(ubi, fm + i * ubi->leb_size, pnum,
+				  ubi->leb_start, ubi->leb_size);
+		if (err && err != UBI_IO_BITFLIPS) {
+			ubi_err("cannot read fastmap PEB %d", pnum);
+			goto out_fm;
+		}
+	}
+
+	/* The CRC covers the whole fastmap with the CRC field zeroed */
+	data_crc = be32_to_cpu(fmsb->data_crc);
+	((struct ubi_fm_sb *)fm)->data_crc = 0;
+	crc = crc32(UBI_CRC32_INIT, fm, *fm_size);
+	if (crc != data_crc) {
+		ubi_err("fastmap CRC error: calculated %#08x, must be %#08x",
+			crc, data_crc);
+		goto out_fm;
+	}
+
+	sqnum = be64_to_cpu(fmsb->sqnum);
+	if (si->max_sqnum < sqnum)
+		si->max_sqnum = sqnum;
+
+	kfree(fmsb);
+	return fm;
+
+out_fm:
+	vfree(fm);
+out_sb:
+	kfree(fmsb);
+	return NULL;
+}
+
+/**
+ * mark_pebs - record the state of the PEBs of a fastmap list.
+ * @ubi: UBI device description object
+ * @fm: fastmap data
+ * @fm_pos: current position in @fm
+ * @fm_size: size of @fm
+ * @count: number of &struct ubi_fm_ec records in the list
+ * @state: state to record
+ * @pebs: per-PEB state array
+ * @ecs: per-PEB erase counter array
+ *
+ * Returns zero in case of success and %UBI_BAD_FASTMAP if the list is
+ * inconsistent.
+ */
+static int mark_pebs(struct ubi_device *ubi, void *fm, int *fm_pos,
+		     int fm_size, int count, int state, unsigned char *pebs,
+		     int *ecs)
+{
+	int i, pnum, ec;
+	struct ubi_fm_ec *fmec;
+
+	for (i = 0; i < count; i++) {
+		fmec = fm_get(fm, fm_pos, sizeof(*fmec), fm_size);
+		if (!fmec)
+			return UBI_BAD_FASTMAP;
+
+		pnum = be32_to_cpu(fmec->pnum);
+		ec = be32_to_cpu(fmec->ec);
+		if (pnum < 0 || pnum >= ubi->peb_count ||
+		    ec < 0 || ec > UBI_MAX_ERASECOUNTER) {
+			ubi_err("bad fastmap EC record: PEB %d, EC %d",
+				pnum, ec);
+			return UBI_BAD_FASTMAP;
+		}
+
+		if (pebs[pnum] != FM_PEB_UNKNOWN) {
+			ubi_err("PEB %d is listed twice in the fastmap", pnum);
+			return UBI_BAD_FASTMAP;
+		}
+
+		pebs[pnum] = state;
+		ecs[pnum] = ec;
+	}
+
+	return 0;
+}
+
+/**
+ * mark_pool - record the PEBs of a fastmap pool.
+ * @ubi: UBI device description object
+ * @fmpl: the pool
+ * @pebs: per-PEB state array
+ *
+ * Returns zero in case of success and %UBI_BAD_FASTMAP if the pool is
+ * inconsistent.
+ */
+static int mark_pool(struct ubi_device *ubi, struct ubi_fm_scan_pool *fmpl,
+		     unsigned char *pebs)
+{
+	int i, pnum, size = be16_to_cpu(fmpl->size);
+
+	if (be32_to_cpu(fmpl->magic) != UBI_FM_POOL_MAGIC ||
+	    size > UBI_FM_MAX_POOL_SIZE) {
+		ubi_err("bad fastmap pool");
+		return UBI_BAD_FASTMAP;
+	}
+
+	for (i = 0; i < size; i++) {
+		pnum = be32_to_cpu(fmpl->pebs[i]);
+		if (pnum < 0 || pnum >= ubi->peb_count) {
+			ubi_err("bad fastmap pool PEB %d", pnum);
+			return UBI_BAD_FASTMAP;
+		}
+		pebs[pnum] = FM_PEB_POOL;
+	}
+
+	return 0;
+}
+
+/**
+ * add_volumes - add the volumes and LEBs described by a fastmap.
+ * @ubi: UBI device description object
+ * @si: scanning information
+ * @fm: fastmap data
+ * @fm_pos: current position in @fm
+ * @fm_size: size of @fm
+ * @vol_count: number of volumes in the fastmap
+ * @pebs: per-PEB state array
+ * @ecs: per-PEB erase counter array
+ *
+ * Returns zero in case of success, %UBI_BAD_FASTMAP if the EBA tables are
+ * inconsistent and a negative error code in case of failure.
+ */
+static int add_volumes(struct ubi_device *ubi, struct ubi_scan_info *si,
+		       void *fm, int *fm_pos, int fm_size, int vol_count,
+		       unsigned char *pebs, int *ecs)
+{
+	int i, err, lnum, pnum, vol_id, data_pad, used_ebs, last_eb_bytes;
+	int reserved_pebs;
+	struct ubi_fm_volhdr *fmvhdr;
+	struct ubi_fm_eba *fm_eba;
+	struct ubi_vid_hdr *vid_hdr;
+
+	vid_hdr = kzalloc(sizeof(struct ubi_vid_hdr), GFP_KERNEL);
+	if (!vid_hdr)
+		return -ENOMEM;
+
+	for (i = 0; i < vol_count; i++) {
+		err = UBI_BAD_FASTMAP;
+		fmvhdr = fm_get(fm, fm_pos, sizeof(*fmvhdr), fm_size);
+		if (!fmvhdr || be32_to_cpu(fmvhdr->magic) != UBI_FM_VHDR_MAGIC)
+			goto out;
+
+		vol_id = be32_to_cpu(fmvhdr->vol_id);
+		data_pad = be32_to_cpu(fmvhdr->data_pad);
+		used_ebs = be32_to_cpu(fmvhdr->used_ebs);
+		last_eb_bytes = be32_to_cpu(fmvhdr->last_eb_bytes);
+		if ((vol_id < 0 || vol_id >= UBI_MAX_VOLUMES) &&
+		    vol_id != UBI_LAYOUT_VOLUME_ID)
+			goto out;
+		if (fmvhdr->vol_type != UBI_DYNAMIC_VOLUME &&
+		    fmvhdr->vol_type != UBI_STATIC_VOLUME)
+			goto out;
+		if (data_pad < 0 || data_pad >= ubi->leb_size ||
+		    used_ebs < 0 || last_eb_bytes < 0 ||
+		    last_eb_bytes > ubi->leb_size - data_pad)
+			goto out;
+
+		fm_eba = fm_get(fm, fm_pos, sizeof(*fm_eba), fm_size);
+		if (!fm_eba || be32_to_cpu(fm_eba->magic) != UBI_FM_EBA_MAGIC)
+			goto out;
+
+		reserved_pebs = be32_to_cpu(fm_eba->reserved_pebs);
+		if (reserved_pebs < 0 || reserved_pebs > ubi->peb_count ||
+		    !fm_get(fm, fm_pos, reserved_pebs * sizeof(__be32),
+			    fm_size))
+			goto out;
+
+		/*
+		 * Build the VID header UBI would have found on the media. LEBs
+		 * of dynamic volumes do not store @used_ebs and @data_size.
+		 */
+		memset(vid_hdr, 0, sizeof(struct ubi_vid_hdr));
+		vid_hdr->vol_id = cpu_to_be32(vol_id);
+		vid_hdr->data_pad = cpu_to_be32(data_pad);
+		if (vol_id == UBI_LAYOUT_VOLUME_ID)
+			vid_hdr->compat = UBI_LAYOUT_VOLUME_COMPAT;
+		if (fmvhdr->vol_type == UBI_STATIC_VOLUME) {
+			vid_hdr->vol_type = UBI_VID_STATIC;
+			vid_hdr->used_ebs = cpu_to_be32(used_ebs);
+		} else
+			vid_hdr->vol_type = UBI_VID_DYNAMIC;
+
+		for (lnum = 0; lnum < reserved_pebs; lnum++) {
+			pnum = be32_to_cpu(fm_eba->pnum[lnum]);
+			if (pnum < 0)
+				continue;
+
+			if (pnum >= ubi->peb_count ||
+			    (pebs[pnum] != FM_PEB_USED &&
+			     pebs[pnum] != FM_PEB_SCRUB)) {
+				ubi_err("LEB %d:%d is mapped to PEB %d which "
+					"is not in use", vol_id, lnum, pnum);
+				goto out;
+			}
+
+			vid_hdr->lnum = cpu_to_be32(lnum);
+			if (fmvhdr->vol_type == UBI_STATIC_VOLUME)
+				vid_hdr->data_size = cpu_to_be32(
+					lnum == used_ebs - 1 ? last_eb_bytes :
+					ubi->leb_size - data_pad);
+
+			err = ubi_scan_add_used(ubi, si, pnum, ecs[pnum],
+						vid_hdr,
+						pebs[pnum] == FM_PEB_SCRUB);
+			if (err) {
+				if (err != -ENOMEM)
+					err = UBI_BAD_FASTMAP;
+				goto out;
+			}
+
+			pebs[pnum] = FM_PEB_MAPPED;
+		}
+	}
+
+	err = 0;
+out:
+	kfree(vid_hdr);
+	return err;
+}
+
+/**
+ * account_ec - account the erase counter of a fastmap-described PEB.
+ * @si: scanning information
+ * @ec: the erase counter
+ */
+static void account_ec(struct ubi_scan_info *si, int ec)
+{
+	si->ec_sum += ec;
+	si->ec_count += 1;
+	if (ec > si->max_ec)
+		si->max_ec = ec;
+	if (ec < si->min_ec)
+		si->min_ec = ec;
+}
+
+/**
+ * ubi_scan_fastmap - build scanning information from a fastmap.
+ * @ubi: UBI device description object
+ * @si: scanning information to fill
+ *
+ * This function looks for a fastmap on @ubi and, if it finds a valid one,
+ * fills @si the way full scanning would. PEBs the fastmap does not describe,
+ * including the pool PEBs, are scanned. Returns zero in case of success, a
+ * positive value if there is no usable fastmap and the device has to be
+ * scanned (@si has to be thrown away then), and a negative error code in case
+ * of failure.
+ */
+int ubi_scan_fastmap(struct ubi_device *ubi, struct ubi_scan_info *si)
+{
+	int err, i, pnum, anchor, anchor_ec = 0, fm_pos, fm_size;
+	struct ubi_ec_hdr *ech;
+	struct ubi_vid_hdr *vidh;
+	struct ubi_fm_sb *fmsb;
+	struct ubi_fm_hdr *fmhdr;
+	struct ubi_fm_scan_pool *fmpl1, *fmpl2;
+	unsigned char *pebs;
+	int *ecs;
+	void *fm;
+
+	err = -ENOMEM;
+	ech = kzalloc(ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize, GFP_KERNEL);
+	if (!ech)
+		return err;
+
+	vidh = ubi_zalloc_vid_hdr(ubi, GFP_KERNEL);
+	if (!vidh)
+		goto out_ech;
+
+	anchor = find_anchor(ubi, ech, vidh, &anchor_ec);
+	if (anchor < -1) {
+		err = anchor;
+		goto out_vidh;
+	} else if (anchor < 0) {
+		dbg_bld("no fastmap found");
+		err = UBI_NO_FASTMAP;
+		goto out_vidh;
+	}
+
+	err = UBI_BAD_FASTMAP;
+	fm = read_fastmap(ubi, si, anchor, ech, vidh, &fm_size);
+	if (!fm)
+		goto out_vidh;
+
+	err = -ENOMEM;
+	pebs = kzalloc(ubi->peb_count, GFP_KERNEL);
+	if (!pebs)
+		goto out_fm;
+
+	ecs = kmalloc(ubi->peb_count * sizeof(int), GFP_KERNEL);
+	if (!ecs)
+		goto out_pebs;
+
+	err = UBI_BAD_FASTMAP;
+	fm_pos = 0;
+	fmsb = fm_get(fm, &fm_pos, sizeof(*fmsb), fm_size);
+	fmhdr = fm_get(fm, &fm_pos, sizeof(*fmhdr), fm_size);
+	fmpl1 = fm_get(fm, &fm_pos, sizeof(*fmpl1), fm_size);
+	fmpl2 = fm_get(fm, &fm_pos, sizeof(*fmpl2), fm_size);
+	if (!fmsb || !fmhdr || !fmpl1 || !fmpl2 ||
+	    be32_to_cpu(fmhdr->magic) != UBI_FM_HDR_MAGIC) {
+		ubi_err("bad fastmap header");
+		goto out_ecs;
+	}
+
+	for (i = 0; i < be32_to_cpu(fmsb->used_blocks); i++) {
+		pnum = be32_to_cpu(fmsb->block_loc[i]);
+		pebs[pnum] = FM_PEB_FASTMAP;
+		ecs[pnum] = be32_to_cpu(fmsb->block_ec[i]);
+	}
+
+	err = mark_pebs(ubi, fm, &fm_pos, fm_size,
+			be32_to_cpu(fmhdr->free_peb_count), FM_PEB_FREE,
+			pebs, ecs);
+	if (!err)
+		err = mark_pebs(ubi, fm, &fm_pos, fm_size,
+				be32_to_cpu(fmhdr->used_peb_count),
+				FM_PEB_USED, pebs, ecs);
+	if (!err)
+		err = mark_pebs(ubi, fm, &fm_pos, fm_size,
+				be32_to_cpu(fmhdr->scrub_peb_count),
+				FM_PEB_SCRUB, pebs, ecs);
+	if (!err)
+		err = mark_pebs(ubi, fm, &fm_pos, fm_size,
+				be32_to_cpu(fmhdr->erase_peb_count),
+				FM_PEB_ERASE, pebs, ecs);
+	/* Pool PEBs may have been written after the fastmap was taken */
+	if (!err)
+		err = mark_pool(ubi, fmpl1, pebs);
+	if (!err)
+		err = mark_pool(ubi, fmpl2, pebs);
+	if (!err)
+		err = add_volumes(ubi, si, fm, &fm_pos, fm_size,
+				  be32_to_cpu(fmhdr->vol_count), pebs, ecs);
+	if (err)
+		goto out_ecs;
+
+	/*
+	 * The scan functions below use the scanning unit's own header
+	 * buffers, so everything the fastmap does not vouch for is handled
+	 * exactly as full scanning would handle it.
+	 */
+	for (pnum = 0; pnum < ubi->peb_count; pnum++) {
+		switch (pebs[pnum]) {
+		case FM_PEB_FREE:
+			err = ubi_scan_add_to_list(si, pnum, ecs[pnum],
+						   &si->free);
+			break;
+		case FM_PEB_USED:
+		case FM_PEB_SCRUB:
+			/* In use but not mapped by any LEB - stale */
+		case FM_PEB_ERASE:
+			err = ubi_scan_add_to_list(si, pnum, ecs[pnum],
+						   &si->erase);
+			break;
+		case FM_PEB_FASTMAP:
+			err = ubi_scan_add_to_list(si, pnum, ecs[pnum],
+						   &si->alien);
+			si->alien_peb_count += 1;
+			break;
+		case FM_PEB_MAPPED:
+			err = 0;
+			break;
+		default:
+			cond_resched();
+			err = ubi_scan_process_eb(ubi, si, pnum);
+			if (err < 0)
+				goto out_ecs;
+			continue;
+		}
+		if (err)
+			goto out_ecs;
+		account_ec(si, ecs[pnum]);
+	}
+
+	si->is_empty = 0;
+	ubi->fm_anchor = anchor;
+	ubi->fm_anchor_ec = anchor_ec;
+	ubi_msg("attached from fastmap at PEB %d (%d PEBs)", anchor,
+		be32_to_cpu(fmsb->used_blocks));
+	err = 0;
+
+out_ecs:
+	kfree(ecs);
+out_pebs:
+	kfree(pebs);
+out_fm:
+	vfree(fm);
+out_vidh:
+	ubi_free_vid_hdr(ubi, vidh);
+out_ech:
+	kfree(ech);
+	return err;
+}
+
+/**
+ * ubi_fastmap_invalidate - invalidate the fastmap the device was attached from.
+ * @ubi: UBI device description object
+ *
+ * UBI in U-Boot does not maintain the fastmap, so it has to be invalidated
+ * before the media is changed in any way Linux would not find in the pools.
+ * This function erases the fastmap anchor. Returns zero in case of success
+ * and a negative error code in case of failure.
+ */
+int ubi_fastmap_invalidate(struct ubi_device *ubi)
+{
+	int err, pnum = ubi->fm_anchor;
+
+	if (pnum < 0)
+		return 0;
+
+	/* The erase below comes back here through ubi_io_sync_erase() */
+	ubi->fm_anchor = -1;
+
+	dbg_bld("invalidate fastmap at PEB %d", pnum);
+	err = ubi_scan_erase_peb(ubi, NULL, pnum, ubi->fm_anchor_ec + 1);
+	if (err) {
+		ubi_err("cannot invalidate fastmap at PEB %d", pnum);
+		ubi->fm_anchor = pnum;
+		return err;
+	}
+
+	return 0;
+}
@@ -113,6 +113,12 @@ static int paranoid_check_all_ff(struct ubi_device *ubi, int pnum, int offset,
 #define paranoid_check_all_ff(ubi, pnum, offset, len) 0
 #endif
 
+static int check_ec_hdr(struct ubi_device *ubi, int pnum,
+			struct ubi_ec_hdr *ec_hdr, int read_err, int verbose);
+static int check_vid_hdr(struct ubi_device *ubi, int pnum,
+			 struct ubi_vid_hdr *vid_hdr, int read_err,
+			 int verbose);
+
 /**
  * ubi_io_read - read data from a physical eraseblock.
  * @ubi: UBI device description object
@@ -486,6 +492,11 @@ int ubi_io_sync_erase(struct ubi_device *ubi, int pnum, int torture)
 		return -EROFS;
 	}
 
+	/* An erased PEB the fastmap still describes makes it stale too */
+	err = ubi_fastmap_invalidate(ubi);
+	if (err)
+		return err;
+
 	if (torture) {
 		ret = torture_peb(ubi, pnum);
 		if (ret < 0)
@@ -632,12 +643,9 @@ int ubi_io_read_ec_hdr(struct ubi_device *ubi, int pnum,
 		       struct ubi_ec_hdr *ec_hdr, int verbose)
 {
 	int err, read_err = 0;
-	uint32_t crc, magic, hdr_crc;
 
 	dbg_io("read EC header from PEB %d", pnum);
 	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
-	if (UBI_IO_DEBUG)
-		verbose = 1;
 
 	err = ubi_io_read(ubi, ec_hdr, pnum, 0, UBI_EC_HDR_SIZE);
 	if (err) {
@@ -656,6 +664,28 @@ int ubi_io_read_ec_hdr(struct ubi_device *ubi, int pnum,
 		read_err = err;
 	}
 
+	return check_ec_hdr(ubi, pnum, ec_hdr, read_err, verbose);
+}
+
+/**
+ * check_ec_hdr - check an erase counter header which has been read.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock the header was read from
+ * @ec_hdr: the erase counter header to check
+ * @read_err: %UBI_IO_BITFLIPS or %-EBADMSG if the read reported so, else %0
+ * @verbose: be verbose if the header is corrupted or was not found
+ *
+ * Returns the same codes as 'ubi_io_read_ec_hdr()'.
+ */
+static int check_ec_hdr(struct ubi_device *ubi, int pnum,
+			struct ubi_ec_hdr *ec_hdr, int read_err, int verbose)
+{
+	int err;
+	uint32_t crc, magic, hdr_crc;
+
+	if (UBI_IO_DEBUG)
+		verbose = 1;
+
 	magic = be32_to_cpu(ec_hdr->magic);
 	if (magic != UBI_EC_HDR_MAGIC) {
 		/*
@@ -906,13 +936,10 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 			struct ubi_vid_hdr *vid_hdr, int verbose)
 {
 	int err, read_err = 0;
-	uint32_t crc, magic, hdr_crc;
 	void *p;
 
 	dbg_io("read VID header from PEB %d", pnum);
 	ubi_assert(pnum >= 0 &&  pnum < ubi->peb_count);
-	if (UBI_IO_DEBUG)
-		verbose = 1;
 
 	p = (char *)vid_hdr - ubi->vid_hdr_shift;
 	err = ubi_io_read(ubi, p, pnum, ubi->vid_hdr_aloffset,
@@ -932,6 +959,29 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 		read_err = err;
 	}
 
+	return check_vid_hdr(ubi, pnum, vid_hdr, read_err, verbose);
+}
+
+/**
+ * check_vid_hdr - check a volume identifier header which has been read.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock the header was read from
+ * @vid_hdr: the volume identifier header to check
+ * @read_err: %UBI_IO_BITFLIPS or %-EBADMSG if the read reported so, else %0
+ * @verbose: be verbose if the header is corrupted or wasn't found
+ *
+ * Returns the same codes as 'ubi_io_read_vid_hdr()'.
+ */
+static int check_vid_hdr(struct ubi_device *ubi, int pnum,
+			 struct ubi_vid_hdr *vid_hdr, int read_err,
+			 int verbose)
+{
+	int err;
+	uint32_t crc, magic, hdr_crc;
+
+	if (UBI_IO_DEBUG)
+		verbose = 1;
+
 	magic = be32_to_cpu(vid_hdr->magic);
 	if (magic != UBI_VID_HDR_MAGIC) {
 		/*
@@ -996,6 +1046,60 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 	return read_err ? UBI_IO_BITFLIPS : 0;
 }
 
+/**
+ * ubi_io_read_hdrs - read and check both UBI headers of a PEB at once.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock number to read from
+ * @ec_hdr: buffer of at least @ubi->vid_hdr_aloffset + @ubi->vid_hdr_alsize
+ *          bytes where the erase counter header is stored
+ * @vid_hdr: &struct ubi_vid_hdr object where to store the volume identifier
+ *           header
+ * @vid_err: the result of checking the VID header is returned here
+ * @verbose: be verbose if a header is corrupted or was not found
+ *
+ * This function is used when scanning. Instead of two flash reads, one for
+ * each header, it reads everything up to the end of the VID header with a
+ * single request and then checks both headers as 'ubi_io_read_ec_hdr()' and
+ * 'ubi_io_read_vid_hdr()' do. If the read reports an ECC error, it is not
+ * known which of the headers it hit, so the headers are re-read one by one.
+ *
+ * Returns the EC header result as 'ubi_io_read_ec_hdr()' does. @vid_err is
+ * only valid if the returned value is %0, %UBI_IO_BITFLIPS or
+ * %UBI_IO_BAD_EC_HDR, and holds what 'ubi_io_read_vid_hdr()' would return.
+ */
+int ubi_io_read_hdrs(struct ubi_device *ubi, int pnum,
+		     struct ubi_ec_hdr *ec_hdr, struct ubi_vid_hdr *vid_hdr,
+		     int *vid_err, int verbose)
+{
+	int err, read_err = 0;
+	void *p;
+
+	dbg_io("read EC and VID headers from PEB %d", pnum);
+	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
+
+	err = ubi_io_read(ubi, ec_hdr, pnum, 0,
+			  ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize);
+	if (err == -EBADMSG) {
+		err = ubi_io_read_ec_hdr(ubi, pnum, ec_hdr, verbose);
+		if (err >= 0 && err != UBI_IO_PEB_EMPTY)
+			*vid_err = ubi_io_read_vid_hdr(ubi, pnum, vid_hdr,
+						       verbose);
+		return err;
+	} else if (err == UBI_IO_BITFLIPS)
+		read_err = err;
+	else if (err)
+		return err;
+
+	p = (char *)vid_hdr - ubi->vid_hdr_shift;
+	memcpy(p, (char *)ec_hdr + ubi->vid_hdr_aloffset, ubi->vid_hdr_alsize);
+
+	err = check_ec_hdr(ubi, pnum, ec_hdr, read_err, verbose);
+	if (err >= 0 && err != UBI_IO_PEB_EMPTY)
+		*vid_err = check_vid_hdr(ubi, pnum, vid_hdr, read_err,
+					 verbose);
+	return err;
+}
+
 /**
  * ubi_io_write_vid_hdr - write a volume identifier header.
  * @ubi: UBI device description object
@@ -1025,6 +1129,11 @@ int ubi_io_write_vid_hdr(struct ubi_device *ubi, int pnum,
 	if (err)
 		return err > 0 ? -EINVAL: err;
 
+	/* A fastmap we attached from goes stale with the first write */
+	err = ubi_fastmap_invalidate(ubi);
+	if (err)
+		return err;
+
 	vid_hdr->magic = cpu_to_be32(UBI_VID_HDR_MAGIC);
 	vid_hdr->version = UBI_VERSION;
 	crc = crc32(UBI_CRC32_INIT, vid_hdr, UBI_VID_HDR_SIZE_CRC);
@@ -60,7 +60,7 @@ static struct ubi_ec_hdr *ech;
 static struct ubi_vid_hdr *vidh;
 
 /**
- * add_to_list - add physical eraseblock to a list.
+ * ubi_scan_add_to_list - add physical eraseblock to a list.
  * @si: scanning information
  * @pnum: physical eraseblock number to add
  * @ec: erase counter of the physical eraseblock
@@ -70,8 +70,8 @@ static struct ubi_vid_hdr *vidh;
  * alien lists. Returns zero in case of success and a negative error code in
  * case of failure.
  */
-static int add_to_list(struct ubi_scan_info *si, int pnum, int ec,
-		       struct list_head *list)
+int ubi_scan_add_to_list(struct ubi_scan_info *si, int pnum, int ec,
+			 struct list_head *list)
 {
 	struct ubi_scan_leb *seb;
 
@@ -495,11 +495,11 @@ int ubi_scan_add_used(struct ubi_device *ubi, struct ubi_scan_info *si,
 				return err;
 
 			if (cmp_res & 4)
-				err = add_to_list(si, seb->pnum, seb->ec,
-						  &si->corr);
+				err = ubi_scan_add_to_list(si, seb->pnum,
+							   seb->ec, &si->corr);
 			else
-				err = add_to_list(si, seb->pnum, seb->ec,
-						  &si->erase);
+				err = ubi_scan_add_to_list(si, seb->pnum,
+							   seb->ec, &si->erase);
 			if (err)
 				return err;
 
@@ -520,9 +520,11 @@ int ubi_scan_add_used(struct ubi_device *ubi, struct ubi_scan_info *si,
 			 * previously.
 			 */
 			if (cmp_res & 4)
-				return add_to_list(si, pnum, ec, &si->corr);
+				return ubi_scan_add_to_list(si, pnum, ec,
+							    &si->corr);
 			else
-				return add_to_list(si, pnum, ec, &si->erase);
+				return ubi_scan_add_to_list(si, pnum, ec,
+							    &si->erase);
 		}
 	}
 
@@ -746,8 +748,8 @@ struct ubi_scan_leb *ubi_scan_get_free_peb(struct ubi_device *ubi,
 }
 
 /**
- * process_eb - read UBI headers, check them and add corresponding data
- * to the scanning information.
+ * ubi_scan_process_eb - read UBI headers, check them and add corresponding
+ * data to the scanning information.
  * @ubi: UBI device description object
  * @si: scanning information
  * @pnum: the physical eraseblock number
@@ -755,10 +757,11 @@ struct ubi_scan_leb *ubi_scan_get_free_peb(struct ubi_device *ubi,
  * This function returns a zero if the physical eraseblock was successfully
  * handled and a negative error code in case of failure.
  */
-static int process_eb(struct ubi_device *ubi, struct ubi_scan_info *si, int pnum)
+int ubi_scan_process_eb(struct ubi_device *ubi, struct ubi_scan_info *si,
+			int pnum)
 {
 	long long uninitialized_var(ec);
-	int err, bitflips = 0, vol_id, ec_corr = 0;
+	int err, bitflips = 0, vol_id, ec_corr = 0, vid_err = 0;
 
 	dbg_bld("scan PEB %d", pnum);
 
@@ -775,13 +778,14 @@ static int process_eb(struct ubi_device *ubi, struct ubi_scan_info *si, int pnum
 		return 0;
 	}
 
-	err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
+	err = ubi_io_read_hdrs(ubi, pnum, ech, vidh, &vid_err, 0);
 	if (err < 0)
 		return err;
 	else if (err == UBI_IO_BITFLIPS)
 		bitflips = 1;
 	else if (err == UBI_IO_PEB_EMPTY)
-		return add_to_list(si, pnum, UBI_SCAN_UNKNOWN_EC, &si->erase);
+		return ubi_scan_add_to_list(si, pnum, UBI_SCAN_UNKNOWN_EC,
+					    &si->erase);
 	else if (err == UBI_IO_BAD_EC_HDR) {
 		/*
 		 * We have to also look at the VID header, possibly it is not
@@ -821,7 +825,7 @@ static int process_eb(struct ubi_device *ubi, struct ubi_scan_info *si, int pnum
 
 	/* OK, we've done with the EC header, let's look at the VID header */
 
-	err = ubi_io_read_vid_hdr(ubi, pnum, vidh, 0);
+	err = vid_err;
 	if (err < 0)
 		return err;
 	else if (err == UBI_IO_BITFLIPS)
@@ -829,13 +833,13 @@ static int process_eb(struct ubi_device *ubi, struct ubi_scan_info *si, int pnum
 	else if (err == UBI_IO_BAD_VID_HDR ||
 		 (err == UBI_IO_PEB_FREE && ec_corr)) {
 		/* VID header is corrupted */
-		err = add_to_list(si, pnum, ec, &si->corr);
+		err = ubi_scan_add_to_list(si, pnum, ec, &si->corr);
 		if (err)
 			return err;
 		goto adjust_mean_ec;
 	} else if (err == UBI_IO_PEB_FREE) {
 		/* No VID header - the physical eraseblock is free */
-		err = add_to_list(si, pnum, ec, &si->free);
+		err = ubi_scan_add_to_list(si, pnum, ec, &si->free);
 		if (err)
 			return err;
 		goto adjust_mean_ec;
@@ -850,7 +854,7 @@ static int process_eb(struct ubi_device *ubi, struct ubi_scan_info *si, int pnum
 		case UBI_COMPAT_DELETE:
 			ubi_msg("\"delete\" compatible internal volume %d:%d"
 				" found, remove it", vol_id, lnum);
-			err = add_to_list(si, pnum, ec, &si->corr);
+			err = ubi_scan_add_to_list(si, pnum, ec, &si->corr);
 			if (err)
 				return err;
 			break;
@@ -865,7 +869,7 @@ static int process_eb(struct ubi_device *ubi, struct ubi_scan_info *si, int pnum
 		case UBI_COMPAT_PRESERVE:
 			ubi_msg("\"preserve\" compatible internal volume %d:%d"
 				" found", vol_id, lnum);
-			err = add_to_list(si, pnum, ec, &si->alien);
+			err = ubi_scan_add_to_list(si, pnum, ec, &si->alien);
 			if (err)
 				return err;
 			si->alien_peb_count += 1;
@@ -897,23 +901,17 @@ adjust_mean_ec:
 }
 
 /**
- * ubi_scan - scan an MTD device.
- * @ubi: UBI device description object
+ * alloc_si - allocate and initialize scanning information.
  *
- * This function does full scanning of an MTD device and returns complete
- * information about it. In case of failure, an error code is returned.
+ * Returns a pointer to the new object or %NULL if there is not enough memory.
  */
-struct ubi_scan_info *ubi_scan(struct ubi_device *ubi)
+static struct ubi_scan_info *alloc_si(void)
 {
-	int err, pnum;
-	struct rb_node *rb1, *rb2;
-	struct ubi_scan_volume *sv;
-	struct ubi_scan_leb *seb;
 	struct ubi_scan_info *si;
 
 	si = kzalloc(sizeof(struct ubi_scan_info), GFP_KERNEL);
 	if (!si)
-		return ERR_PTR(-ENOMEM);
+		return NULL;
 
 	INIT_LIST_HEAD(&si->corr);
 	INIT_LIST_HEAD(&si->free);
@@ -921,9 +919,33 @@ struct ubi_scan_info *ubi_scan(struct ubi_device *ubi)
 	INIT_LIST_HEAD(&si->alien);
 	si->volumes = RB_ROOT;
 	si->is_empty = 1;
+	return si;
+}
 
+/**
+ * ubi_scan - scan an MTD device.
+ * @ubi: UBI device description object
+ *
+ * This function does full scanning of an MTD device and returns complete
+ * information about it. If the device carries a valid fastmap, the scanning
+ * information is built from the fastmap instead and only the PEBs it does not
+ * describe are scanned. In case of failure, an error code is returned.
+ */
+struct ubi_scan_info *ubi_scan(struct ubi_device *ubi)
+{
+	int err, pnum, fastmap = 0;
+	struct rb_node *rb1, *rb2;
+	struct ubi_scan_volume *sv;
+	struct ubi_scan_leb *seb;
+	struct ubi_scan_info *si;
+
+	si = alloc_si();
+	if (!si)
+		return ERR_PTR(-ENOMEM);
+
+	/* Both headers are read into @ech at once, see 'ubi_io_read_hdrs()' */
 	err = -ENOMEM;
-	ech = kzalloc(ubi->ec_hdr_alsize, GFP_KERNEL);
+	ech = kzalloc(ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize, GFP_KERNEL);
 	if (!ech)
 		goto out_si;
 
@@ -931,17 +953,42 @@ struct ubi_scan_info *ubi_scan(struct ubi_device *ubi)
 	if (!vidh)
 		goto out_ech;
 
+#ifdef CONFIG_MTD_UBI_FASTMAP
+	ubi->fm_anchor = -1;
+	err = ubi_scan_fastmap(ubi, si);
+	if (err < 0)
+		goto out_vidh;
+	if (err == 0) {
+		fastmap = 1;
+		goto scan_done;
+	}
+
+	/* No usable fastmap, forget whatever was collected and scan it all */
+	ubi_scan_destroy_si(si);
+	si = alloc_si();
+	if (!si) {
+		err = -ENOMEM;
+		ubi_free_vid_hdr(ubi, vidh);
+		kfree(ech);
+		return ERR_PTR(err);
+	}
+#endif
+
 	for (pnum = 0; pnum < ubi->peb_count; pnum++) {
 		cond_resched();
 
 		dbg_msg("process PEB %d", pnum);
-		err = process_eb(ubi, si, pnum);
+		err = ubi_scan_process_eb(ubi, si, pnum);
 		if (err < 0)
 			goto out_vidh;
 	}
 
 	dbg_msg("scanning is finished");
 
+#ifdef CONFIG_MTD_UBI_FASTMAP
+scan_done:
+#endif
+
 	/* Calculate mean erase counter */
 	if (si->ec_count) {
 		do_div(si->ec_sum, si->ec_count);
@@ -974,7 +1021,8 @@ struct ubi_scan_info *ubi_scan(struct ubi_device *ubi)
 		if (seb->ec == UBI_SCAN_UNKNOWN_EC)
 			seb->ec = si->mean_ec;
 
-	err = paranoid_check_si(ubi, si);
+	/* Fastmap-derived LEBs carry no sequence numbers to cross-check */
+	err = fastmap ? 0 : paranoid_check_si(ubi, si);
 	if (err) {
 		if (err > 0)
 			err = -EINVAL;
@@ -342,6 +342,10 @@ struct ubi_wl_entry;
  * @buf_mutex: proptects @peb_buf1 and @peb_buf2
  * @dbg_peb_buf: buffer of PEB size used for debugging
  * @dbg_buf_mutex: proptects @dbg_peb_buf
+ *
+ * @fm_anchor: PEB holding the fastmap super block the device was attached
+ *             from (%-1 if the device was attached by full scanning)
+ * @fm_anchor_ec: erase counter of @fm_anchor
  */
 struct ubi_device {
 	struct cdev cdev;
@@ -424,6 +428,10 @@ struct ubi_device {
 	void *dbg_peb_buf;
 	struct mutex dbg_buf_mutex;
 #endif
+#ifdef CONFIG_MTD_UBI_FASTMAP
+	int fm_anchor;
+	int fm_anchor_ec;
+#endif
 };
 
 extern struct kmem_cache *ubi_wl_entry_slab;
@@ -476,6 +484,14 @@ static inline int ubi_destroy_gluebi(struct ubi_volume *vol)
 #define ubi_gluebi_updated(vol)
 #endif
 
+/* fastmap.c */
+#ifdef CONFIG_MTD_UBI_FASTMAP
+int ubi_scan_fastmap(struct ubi_device *ubi, struct ubi_scan_info *si);
+int ubi_fastmap_invalidate(struct ubi_device *ubi);
+#else
+#define ubi_fastmap_invalidate(ubi) 0
+#endif
+
 /* eba.c */
 int ubi_eba_unmap_leb(struct ubi_device *ubi, struct ubi_volume *vol,
 		      int lnum);
@@ -516,6 +532,9 @@ int ubi_io_write_ec_hdr(struct ubi_device *ubi, int pnum,
 			struct ubi_ec_hdr *ec_hdr);
 int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 			struct ubi_vid_hdr *vid_hdr, int verbose);
+int ubi_io_read_hdrs(struct ubi_device *ubi, int pnum,
+		     struct ubi_ec_hdr *ec_hdr, struct ubi_vid_hdr *vid_hdr,
+		     int *vid_err, int verbose);
 int ubi_io_write_vid_hdr(struct ubi_device *ubi, int pnum,
 			 struct ubi_vid_hdr *vid_hdr);
 
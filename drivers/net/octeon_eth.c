@@ -70,6 +70,7 @@
 #include <asm/arch/cvmx-helper-util.h>
 #include <asm/arch/cvmx-bootmem.h>
 #include <asm/arch/cvmx-global-resources.h>
+#include <asm/arch/octeon_l2_lock.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -160,6 +161,12 @@ static void cvm_oct_fill_hw_memory(uint64_t pool, uint64_t size,
 		       elements * size, pool);
 		return;
 	}
+	/*
+	 * The buffers are freed top down so the FPA hands out the ones at the
+	 * start of the block first.  Lock as many of those in L2 as the lock
+	 * budget allows, the pools are filled in order of how hot they are.
+	 */
+	octeon_l2_lock(memory, size * elements, OCTEON_L2_LOCK_NET);
 	while (elements--)
 		cvmx_fpa_free((void *)(uint32_t) (memory + elements * size),
 			      pool, 0);
@@ -456,6 +463,8 @@ int octeon_network_hw_shutdown(void)
 			sso_err.s.fpe = 1;
 			cvmx_write_csr(CVMX_SSO_ERR, sso_err.u64);
 		}
+		/* Nothing can DMA into the pools any more */
+		octeon_l2_unlock(OCTEON_L2_LOCK_NET);
 	}
 
 	free_global_resources();
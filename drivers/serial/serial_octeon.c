@@ -65,6 +65,31 @@ int octeon_serial_pci_tstc(void);
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/*
+ * Console output is queued in a ring buffer once U-Boot has relocated to
+ * DRAM and fed to the UART's 64 byte TX FIFO whenever there is room:
+ * on every putc, while polling for input and while waiting in udelay().
+ * The CPU only spins on the UART when the ring is full.
+ * octeon_serial_flush() drains everything before control leaves U-Boot.
+ * Before relocation, and on any core but core 0, bytes go straight to
+ * the FIFO so that the ring only ever has one producer and one consumer.
+ */
+#ifndef CONFIG_OCTEON_SERIAL_TXBUF_SIZE
+# define CONFIG_OCTEON_SERIAL_TXBUF_SIZE	8192	/* power of 2, 0 = off */
+#endif
+
+#if CONFIG_OCTEON_SERIAL_TXBUF_SIZE
+static char tx_buf[CONFIG_OCTEON_SERIAL_TXBUF_SIZE];
+static unsigned int tx_head;	/* next free slot */
+static unsigned int tx_tail;	/* next byte to send */
+
+/* The ring is only used by core 0 once running from DRAM */
+static inline int serial_txbuf_active(void)
+{
+	return (gd->flags & GD_FLG_RELOC) && cvmx_get_core_num() == 0;
+}
+#endif
+
 struct serial_device octeon_serial0_device = {
 	.name = "serial",
 	.init = serial_init,
@@ -274,15 +299,19 @@ void octeon_set_baud(uint32_t uart_index, uint32_t baud)
  * @param uart_index Uart to write to (0 or 1)
  * @param ch         Byte to write
  */
-static inline void uart_write_byte(int uart_index, uint8_t ch)
+static inline int uart_tx_fifo_full(int uart_index)
 {
-	cvmx_uart_lsr_t lsrval;
+	cvmx_uart_usr_t usrval;
 
-	/* Spin until there is room */
-	do {
-		lsrval.u64 = cvmx_read_csr(CVMX_MIO_UARTX_LSR(uart_index));
-	}
-	while (lsrval.s.thre == 0);
+	usrval.u64 = cvmx_read_csr(CVMX_MIO_UARTX_USR(uart_index));
+	return !usrval.s.tfnf;
+}
+
+static inline void uart_write_byte(int uart_index, uint8_t ch)
+{
+	/* Spin until there is room in the FIFO */
+	while (uart_tx_fifo_full(uart_index))
+		;
 	WATCHDOG_RESET();
 	/* Write the byte */
 	cvmx_write_csr(CVMX_MIO_UARTX_THR(uart_index), ch);
@@ -333,20 +362,82 @@ int serial_init(void)
 	return 0;
 }
 
+/**
+ * Move queued console output into the UART TX FIFO until either the
+ * queue is empty or the FIFO is full.  Never waits.
+ */
+void octeon_serial_poll(void)
+{
+#if CONFIG_OCTEON_SERIAL_TXBUF_SIZE
+	int uart = gd->ogd.console_uart;
+
+	if (!serial_txbuf_active())
+		return;
+
+	while (tx_tail != tx_head && !uart_tx_fifo_full(uart)) {
+		cvmx_write_csr(CVMX_MIO_UARTX_THR(uart),
+			       tx_buf[tx_tail & (CONFIG_OCTEON_SERIAL_TXBUF_SIZE - 1)]);
+		tx_tail++;
+	}
+#endif
+}
+
+/**
+ * Send all queued console output and wait until the last byte has left
+ * the transmitter.  Must be called before the UART is reprogrammed or
+ * control is passed to another program.
+ */
+void octeon_serial_flush(void)
+{
+	int uart = gd->ogd.console_uart;
+	cvmx_uart_lsr_t lsrval;
+
+#if CONFIG_OCTEON_SERIAL_TXBUF_SIZE
+	while (serial_txbuf_active() && tx_tail != tx_head) {
+		uart_write_byte(uart,
+				tx_buf[tx_tail & (CONFIG_OCTEON_SERIAL_TXBUF_SIZE - 1)]);
+		tx_tail++;
+	}
+#endif
+	do {
+		lsrval.u64 = cvmx_read_csr(CVMX_MIO_UARTX_LSR(uart));
+	} while (!lsrval.s.temt);
+}
+
 void serial_setbrg(void)
 {
+	octeon_serial_flush();
 	octeon_set_baud(gd->ogd.console_uart, gd->baudrate);
 }
 
+static inline void serial_queue_byte(uint8_t ch)
+{
+#if CONFIG_OCTEON_SERIAL_TXBUF_SIZE
+	if (serial_txbuf_active()) {
+		if (tx_head - tx_tail == CONFIG_OCTEON_SERIAL_TXBUF_SIZE) {
+			/* Ring full, make room for one byte */
+			uart_write_byte(gd->ogd.console_uart,
+					tx_buf[tx_tail & (CONFIG_OCTEON_SERIAL_TXBUF_SIZE - 1)]);
+			tx_tail++;
+		}
+		tx_buf[tx_head & (CONFIG_OCTEON_SERIAL_TXBUF_SIZE - 1)] = ch;
+		tx_head++;
+		return;
+	}
+#endif
+	uart_write_byte(gd->ogd.console_uart, ch);
+}
+
 void serial_putc(const char c)
 {
 #if !CONFIG_OCTEON_SIM_HW_DIFF
 	if (c == '\n') {
-		uart_write_byte(gd->ogd.console_uart, '\r');
+		serial_queue_byte('\r');
 	}
 #endif
 
-	uart_write_byte(gd->ogd.console_uart, c);
+	serial_queue_byte(c);
+	octeon_serial_poll();
 }
 
 void serial_puts(const char *s)
@@ -358,6 +449,8 @@ void serial_puts(const char *s)
 
 int serial_getc(void)
 {
+	while (!serial_tstc())
+		WATCHDOG_RESET();
 	return (uart_read_byte(gd->ogd.console_uart));
 }
 
@@ -365,6 +458,7 @@ int serial_tstc(void)
 {
 	cvmx_uart_lsr_t lsrval;
 
+	octeon_serial_poll();
 	lsrval.u64 = cvmx_read_csr(CVMX_MIO_UARTX_LSR(gd->ogd.console_uart));
 	return (lsrval.s.dr);
 }
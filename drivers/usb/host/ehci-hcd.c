@@ -498,7 +498,8 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 	flush_dcache_range((uint32_t)&qh_list,
 		(uint32_t)&qh_list + sizeof(struct QH));
 	flush_dcache_range((uint32_t)&qh, (uint32_t)&qh + sizeof(struct QH));
-	flush_dcache_range((uint32_t)qtd, (uint32_t)qtd + sizeof(qtd));
+	flush_dcache_range((uint32_t)qtd,
+			   (uint32_t)qtd + qtd_count * sizeof(struct qTD));
 
 	/* Set async. queue head pointer. */
 #ifdef CONFIG_OCTEON
@@ -535,7 +536,7 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 		invalidate_dcache_range((uint32_t)&qh,
 			(uint32_t)&qh + sizeof(struct QH));
 		invalidate_dcache_range((uint32_t)qtd,
-			(uint32_t)qtd + sizeof(qtd));
+			(uint32_t)qtd + qtd_count * sizeof(struct qTD));
 
 		token = hc32_to_cpu(vtd->qt_token);
 		if (!(token & 0x80))
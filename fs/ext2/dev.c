@@ -27,6 +27,7 @@
 #include <common.h>
 #include <config.h>
 #include <ext2fs.h>
+#include <blkcache.h>
 
 static block_dev_desc_t *ext2fs_block_dev_desc;
 static disk_partition_t part_info;
@@ -84,10 +85,9 @@ int ext2fs_devread(int sector, int byte_offset, int byte_len, char *buf)
 
 	if (byte_offset != 0) {
 		/* read first part which isn't aligned with start of sector */
-		if (ext2fs_block_dev_desc->
-		    block_read(ext2fs_block_dev_desc->dev,
-			       part_info.start + sector, 1,
-			       (unsigned long *) sec_buf) != 1) {
+		if (blkcache_read(ext2fs_block_dev_desc,
+				  part_info.start + sector, 1,
+				  (unsigned long *) sec_buf) != 1) {
 			printf(" ** %s read error **\n", __func__);
 			return 0;
 		}
@@ -102,8 +102,7 @@ int ext2fs_devread(int sector, int byte_offset, int byte_len, char *buf)
 	sectors = byte_len / SECTOR_SIZE;
 
 	if (sectors > 0) {
-		if (ext2fs_block_dev_desc->block_read(
-			ext2fs_block_dev_desc->dev,
+		if (blkcache_read(ext2fs_block_dev_desc,
 			part_info.start + sector,
 			sectors,
 			(unsigned long *) buf) != sectors) {
@@ -118,10 +117,9 @@ int ext2fs_devread(int sector, int byte_offset, int byte_len, char *buf)
 
 	if (byte_len != 0) {
 		/* read rest of data which are not in whole sector */
-		if (ext2fs_block_dev_desc->
-		    block_read(ext2fs_block_dev_desc->dev,
-			       part_info.start + sector, 1,
-			       (unsigned long *) sec_buf) != 1) {
+		if (blkcache_read(ext2fs_block_dev_desc,
+				  part_info.start + sector, 1,
+				  (unsigned long *) sec_buf) != 1) {
 			printf(" ** %s read error - last part\n", __func__);
 			return 0;
 		}
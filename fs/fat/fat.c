@@ -31,6 +31,7 @@
 #include <fat.h>
 #include <asm/byteorder.h>
 #include <part.h>
+#include <blkcache.h>
 #include <malloc.h>
 #include <linux/compiler.h>
 
@@ -58,8 +59,8 @@ static int disk_read(__u32 block, __u32 nr_blocks, void *buf)
 	if (!cur_dev || !cur_dev->block_read)
 		return -1;
 
-	return cur_dev->block_read(cur_dev->dev,
-			cur_part_info.start + block, nr_blocks, buf);
+	return blkcache_read(cur_dev, cur_part_info.start + block,
+			nr_blocks, buf);
 }
 
 int fat_register_device(block_dev_desc_t * dev_desc, int part_no)
@@ -582,6 +583,137 @@ static __u8 mkcksum(const char name[8], const char ext[3])
 }
 #endif	/* CONFIG_SUPPORT_VFAT */
 
+/*
+ * Directory entry cache
+ *
+ * Every directory entry seen while resolving a path or listing a
+ * directory is remembered under its parent directory's start cluster
+ * (0 for the root directory) and its lowercased short and long names.
+ * Repeated lookups of the same path then skip the directory scan and
+ * the VFAT name reconstruction.  The cache belongs to one mounted
+ * volume and is dropped when a different volume is read or when the
+ * volume is written.
+ */
+#ifndef CONFIG_SYS_FAT_DCACHE_ENTRIES
+# define CONFIG_SYS_FAT_DCACHE_ENTRIES	256	/* must be a power of 2 */
+#endif
+#define FAT_DCACHE_PROBE	4
+
+struct fat_dcache_entry {
+	char		*name;		/* NULL if unused */
+	__u32		parent;		/* start cluster of parent dir */
+	__u32		hash;
+	dir_entry	dent;
+};
+
+static struct fat_dcache_entry fat_dcache[CONFIG_SYS_FAT_DCACHE_ENTRIES];
+
+static struct {
+	block_dev_desc_t *dev;
+	ulong		part_start;
+	__u8		volume_id[4];
+} fat_dcache_vol;
+
+static void fat_dcache_flush(void)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_SYS_FAT_DCACHE_ENTRIES; i++) {
+		free(fat_dcache[i].name);
+		fat_dcache[i].name = NULL;
+	}
+}
+
+/*
+ * Called by the block cache whenever blocks of dev_desc are written
+ * behind our back or the device is rescanned (dev_desc NULL: all
+ * devices).  The next mount then refills the cache from the media.
+ */
+void fat_dcache_invalidate(block_dev_desc_t *dev_desc)
+{
+	if (!fat_dcache_vol.dev ||
+	    (dev_desc && dev_desc != fat_dcache_vol.dev))
+		return;
+
+	fat_dcache_flush();
+	fat_dcache_vol.dev = NULL;
+}
+
+/* Drop the cache if it was filled from a different volume */
+static void fat_dcache_check(volume_info *volinfo)
+{
+	if (fat_dcache_vol.dev == cur_dev &&
+	    fat_dcache_vol.part_start == cur_part_info.start &&
+	    !memcmp(fat_dcache_vol.volume_id, volinfo->volume_id,
+		    sizeof(fat_dcache_vol.volume_id)))
+		return;
+
+	fat_dcache_flush();
+	fat_dcache_vol.dev = cur_dev;
+	fat_dcache_vol.part_start = cur_part_info.start;
+	memcpy(fat_dcache_vol.volume_id, volinfo->volume_id,
+	       sizeof(fat_dcache_vol.volume_id));
+}
+
+static __u32 fat_dcache_hash(__u32 parent, const char *name)
+{
+	__u32 hash = 2166136261u ^ parent;
+
+	while (*name)
+		hash = (hash ^ (__u8)*name++) * 16777619u;
+	return hash;
+}
+
+static dir_entry *fat_dcache_lookup(__u32 parent, const char *name)
+{
+	__u32 hash = fat_dcache_hash(parent, name);
+	struct fat_dcache_entry *e;
+	int i;
+
+	for (i = 0; i < FAT_DCACHE_PROBE; i++) {
+		e = &fat_dcache[(hash + i) & (CONFIG_SYS_FAT_DCACHE_ENTRIES - 1)];
+		if (e->name && e->hash == hash && e->parent == parent &&
+		    !strcmp(e->name, name))
+			return &e->dent;
+	}
+	return NULL;
+}
+
+static void fat_dcache_insert(__u32 parent, const char *name,
+			      const dir_entry *dent)
+{
+	__u32 hash;
+	struct fat_dcache_entry *e, *victim = NULL;
+	int i;
+
+	if (!*name)
+		return;
+
+	hash = fat_dcache_hash(parent, name);
+	for (i = 0; i < FAT_DCACHE_PROBE; i++) {
+		e = &fat_dcache[(hash + i) & (CONFIG_SYS_FAT_DCACHE_ENTRIES - 1)];
+		if (e->name && e->hash == hash && e->parent == parent &&
+		    !strcmp(e->name, name)) {
+			memcpy(&e->dent, dent, sizeof(dir_entry));
+			return;
+		}
+		if (!e->name && !victim)
+			victim = e;
+	}
+
+	/* All probe slots busy: replace the home slot */
+	if (!victim)
+		victim = &fat_dcache[hash & (CONFIG_SYS_FAT_DCACHE_ENTRIES - 1)];
+
+	free(victim->name);
+	victim->name = strdup(name);
+	if (!victim->name)
+		return;
+	victim->hash = hash;
+	victim->parent = parent;
+	memcpy(&victim->dent, dent, sizeof(dir_entry));
+}
+
 /*
  * Get the directory entry associated with 'filename' from the directory
  * starting at 'startsect'
@@ -595,10 +727,20 @@ static dir_entry *get_dentfromdir(fsdata *mydata, int startsect,
 {
 	__u16 prevcksum = 0xffff;
 	__u32 curclust = START(retdent);
+	__u32 parent = curclust;
 	int files = 0, dirs = 0;
 
 	debug("get_dentfromdir: %s\n", filename);
 
+	if (!dols) {
+		dir_entry *cached = fat_dcache_lookup(parent, filename);
+
+		if (cached) {
+			memcpy(retdent, cached, sizeof(dir_entry));
+			return retdent;
+		}
+	}
+
 	while (1) {
 		dir_entry *dentptr;
 
@@ -625,9 +767,11 @@ static dir_entry *get_dentfromdir(fsdata *mydata, int startsect,
 				if ((dentptr->attr & ATTR_VFAT) == ATTR_VFAT &&
 				    (dentptr->name[0] & LAST_LONG_ENTRY_MASK)) {
 					prevcksum = ((dir_slot *)dentptr)->alias_checksum;
-					get_vfatname(mydata, curclust,
-						     get_dentfromdir_block,
-						     dentptr, l_name);
+					if (!get_vfatname(mydata, curclust,
+							  get_dentfromdir_block,
+							  dentptr, l_name))
+						fat_dcache_insert(parent, l_name,
+								  dentptr);
 					if (dols) {
 						int isdir;
 						char dirc;
@@ -687,6 +831,7 @@ static dir_entry *get_dentfromdir(fsdata *mydata, int startsect,
 			}
 #endif
 			get_name(dentptr, s_name);
+			fat_dcache_insert(parent, s_name, dentptr);
 			if (dols) {
 				int isdir = (dentptr->attr & ATTR_DIR);
 				char dirc;
@@ -847,6 +992,7 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 		debug("Error: reading boot sector\n");
 		return -1;
 	}
+	fat_dcache_check(&volinfo);
 
 	if (mydata->fatsize == 32) {
 		root_cluster = bs.root_cluster;
@@ -926,6 +1072,15 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 		isdir = 1;
 	}
 
+	if (dols != LS_ROOT) {
+		dentptr = fat_dcache_lookup(0, fnamecopy);
+		if (dentptr) {
+			if (isdir && !(dentptr->attr & ATTR_DIR))
+				goto exit;
+			goto rootdir_done;
+		}
+	}
+
 	j = 0;
 	while (1) {
 		int i;
@@ -948,7 +1103,6 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 
 		for (i = 0; i < DIRENTSPERBLOCK; i++) {
 			char s_name[14], l_name[VFAT_MAXLEN_BYTES];
-			__u8 csum;
 
 			l_name[0] = '\0';
 			if (dentptr->name[0] == DELETED_FLAG) {
@@ -956,7 +1110,6 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 				continue;
 			}
 
-			csum = mkcksum(dentptr->name, dentptr->ext);
 			if (dentptr->attr & ATTR_VOLUME) {
 #ifdef CONFIG_SUPPORT_VFAT
 				if ((dentptr->attr & ATTR_VFAT) == ATTR_VFAT &&
@@ -964,10 +1117,12 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 					prevcksum =
 						((dir_slot *)dentptr)->alias_checksum;
 
-					get_vfatname(mydata,
-						     root_cluster,
-						     do_fat_read_at_block,
-						     dentptr, l_name);
+					if (!get_vfatname(mydata,
+							  root_cluster,
+							  do_fat_read_at_block,
+							  dentptr, l_name))
+						fat_dcache_insert(0, l_name,
+								  dentptr);
 
 					if (dols == LS_ROOT) {
 						char dirc;
@@ -1020,13 +1175,16 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 				goto exit;
 			}
 #ifdef CONFIG_SUPPORT_VFAT
-			else if (dols == LS_ROOT && csum == prevcksum) {
+			else if (dols == LS_ROOT &&
+				 mkcksum(dentptr->name, dentptr->ext) ==
+				 prevcksum) {
 				prevcksum = 0xffff;
 				dentptr++;
 				continue;
 			}
 #endif
 			get_name(dentptr, s_name);
+			fat_dcache_insert(0, s_name, dentptr);
 
 			if (dols == LS_ROOT) {
 				int isdir = (dentptr->attr & ATTR_DIR);
@@ -52,8 +52,8 @@ static int disk_write(__u32 block, __u32 nr_blocks, void *buf)
 		return -1;
 	}
 
-	return cur_dev->block_write(cur_dev->dev,
-			cur_part_info.start + block, nr_blocks,	buf);
+	return blkcache_write(cur_dev, cur_part_info.start + block,
+			nr_blocks, buf);
 }
 
 /*
@@ -932,6 +932,9 @@ static int do_fat_write(const char *filename, void *buffer,
 
 	dir_curclust = 0;
 
+	/* Cached directory entries go stale once the volume is written */
+	fat_dcache_flush();
+
 	if (read_bootsectandvi(&bs, &volinfo, &mydata->fatsize)) {
 		debug("error: reading boot sector\n");
 		return -1;
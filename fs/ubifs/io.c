@@ -281,7 +281,8 @@ int ubifs_read_node(const struct ubifs_info *c, void *buf, int type, int len,
 	ubifs_assert(!(offs & 7) && offs < c->leb_size);
 	ubifs_assert(type >= 0 && type < UBIFS_NODE_TYPES_CNT);
 
-	err = ubi_read(c->ubi, lnum, buf, offs, len);
+	err = ubifs_leb_read(c, lnum, buf, offs, len,
+			     type == UBIFS_DATA_NODE);
 	if (err && err != -EBADMSG) {
 		ubifs_err("cannot read node %d from LEB %d:%d, error %d",
 			  type, lnum, offs, err);
@@ -314,3 +315,121 @@ out:
 	dbg_dump_stack();
 	return -EINVAL;
 }
+
+#ifdef CONFIG_UBIFS_READ_CACHE_SLOTS
+/**
+ * ubifs_rcache_init - allocate the LEB read cache.
+ * @c: UBIFS file-system description object
+ *
+ * This function returns zero in case of success and %-ENOMEM if there is not
+ * enough memory.
+ */
+int ubifs_rcache_init(struct ubifs_info *c)
+{
+	struct ubifs_rcache *rc;
+	int i;
+
+	rc = kzalloc(sizeof(struct ubifs_rcache), GFP_KERNEL);
+	if (!rc)
+		return -ENOMEM;
+
+	c->rcache = rc;
+	rc->win = ALIGN(min_t(int, CONFIG_UBIFS_READ_CACHE_SIZE, c->leb_size),
+			c->min_io_size);
+	for (i = 0; i < CONFIG_UBIFS_READ_CACHE_SLOTS; i++) {
+		rc->slot[i].lnum = -1;
+		rc->slot[i].buf = vmalloc(rc->win);
+		if (!rc->slot[i].buf) {
+			ubifs_rcache_free(c);
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * ubifs_rcache_free - free the LEB read cache.
+ * @c: UBIFS file-system description object
+ */
+void ubifs_rcache_free(struct ubifs_info *c)
+{
+	struct ubifs_rcache *rc = c->rcache;
+	int i;
+
+	if (!rc)
+		return;
+
+	for (i = 0; i < CONFIG_UBIFS_READ_CACHE_SLOTS; i++)
+		vfree(rc->slot[i].buf);
+	kfree(rc);
+	c->rcache = NULL;
+}
+#endif
+
+/**
+ * ubifs_leb_read - read data from a LEB through the read cache.
+ * @c: UBIFS file-system description object
+ * @lnum: logical eraseblock number
+ * @buf: buffer to read to
+ * @offs: offset within the logical eraseblock
+ * @len: how many bytes to read
+ * @ahead: read ahead as far as the cache allows
+ *
+ * Nodes are small compared to the flash pages they live in, and the index and
+ * data nodes of a file are mostly written one after another. So on a miss
+ * this function reads whole min. I/O units into the least recently used cache
+ * slot, and with @ahead set (data nodes) a whole cache window, so that the
+ * nodes which follow are then served from memory. Regions which do not fit
+ * into a slot and reads which fail are passed to UBI as they are, so that
+ * errors are reported exactly as without the cache.
+ *
+ * Returns the same as 'ubi_read()'.
+ */
+int ubifs_leb_read(const struct ubifs_info *c, int lnum, void *buf, int offs,
+		   int len, int ahead)
+{
+#ifdef CONFIG_UBIFS_READ_CACHE_SLOTS
+	struct ubifs_rcache *rc = c->rcache;
+	struct ubifs_rcache_slot *slot, *lru;
+	int i, start, end, err;
+
+	if (!rc)
+		return ubi_read(c->ubi, lnum, buf, offs, len);
+
+	lru = &rc->slot[0];
+	for (i = 0; i < CONFIG_UBIFS_READ_CACHE_SLOTS; i++) {
+		slot = &rc->slot[i];
+		if (slot->lnum == lnum && offs >= slot->offs &&
+		    offs + len <= slot->offs + slot->len) {
+			slot->age = ++rc->age;
+			memcpy(buf, slot->buf + offs - slot->offs, len);
+			return 0;
+		}
+		if (slot->age < lru->age)
+			lru = slot;
+	}
+
+	start = offs - offs % c->min_io_size;
+	end = ALIGN(offs + len, c->min_io_size);
+	if (ahead)
+		end = max_t(int, end,
+			    min_t(int, start + rc->win, c->leb_size));
+	if (end - start > rc->win)
+		return ubi_read(c->ubi, lnum, buf, offs, len);
+
+	lru->lnum = -1;
+	err = ubi_read(c->ubi, lnum, lru->buf, start, end - start);
+	if (err)
+		return ubi_read(c->ubi, lnum, buf, offs, len);
+
+	lru->lnum = lnum;
+	lru->offs = start;
+	lru->len = end - start;
+	lru->age = ++rc->age;
+	memcpy(buf, lru->buf + offs - start, len);
+	return 0;
+#else
+	return ubi_read(c->ubi, lnum, buf, offs, len);
+#endif
+}
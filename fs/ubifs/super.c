@@ -629,6 +629,10 @@ static int mount_ubifs(struct ubifs_info *c)
 	if (!c->sbuf)
 		goto out_free;
 
+	err = ubifs_rcache_init(c);
+	if (err)
+		goto out_free;
+
 	/*
 	 * We have to check all CRCs, even for data nodes, when we mount the FS
 	 * (specifically, when we are replaying).
@@ -810,6 +814,7 @@ out_master:
 out_free:
 	vfree(c->ileb_buf);
 	vfree(c->sbuf);
+	ubifs_rcache_free(c);
 	kfree(c->bottom_up_buf);
 	ubifs_debugging_exit(c);
 	return err;
@@ -844,6 +849,7 @@ void ubifs_umount(struct ubifs_info *c)
 	kfree(c->mst_node);
 	vfree(c->ileb_buf);
 	vfree(c->sbuf);
+	ubifs_rcache_free(c);
 	kfree(c->bottom_up_buf);
 	ubifs_debugging_exit(c);
 
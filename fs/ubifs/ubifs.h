@@ -1205,6 +1205,36 @@ struct bu_info {
 	int eof;
 };
 
+#ifdef CONFIG_UBIFS_READ_CACHE_SLOTS
+/**
+ * struct ubifs_rcache_slot - a cached region of a LEB.
+ * @lnum: LEB number (%-1 if the slot is empty)
+ * @offs: offset of the cached region within the LEB
+ * @len: length of the cached region
+ * @age: LRU stamp, the slot with the lowest one is reused first
+ * @buf: the cached data
+ */
+struct ubifs_rcache_slot {
+	int lnum;
+	int offs;
+	int len;
+	unsigned int age;
+	void *buf;
+};
+
+/**
+ * struct ubifs_rcache - LEB read cache.
+ * @win: size of the slot buffers, i.e. how far data node reads look ahead
+ * @age: LRU clock
+ * @slot: the cached regions
+ */
+struct ubifs_rcache {
+	int win;
+	unsigned int age;
+	struct ubifs_rcache_slot slot[CONFIG_UBIFS_READ_CACHE_SLOTS];
+};
+#endif
+
 /**
  * struct ubifs_node_range - node length range description data structure.
  * @len: fixed node length
@@ -1511,6 +1541,7 @@ struct ubifs_debug_info;
  *
  * @gc_lnum: LEB number used for garbage collection
  * @sbuf: a buffer of LEB size used by GC and replay for scanning
+ * @rcache: cache of recently read LEB regions (%NULL if disabled)
  * @idx_gc: list of index LEBs that have been garbage collected
  * @idx_gc_cnt: number of elements on the idx_gc list
  * @gc_seq: incremented for every non-index LEB garbage collected
@@ -1736,6 +1767,9 @@ struct ubifs_info {
 
 	int gc_lnum;
 	void *sbuf;
+#ifdef CONFIG_UBIFS_READ_CACHE_SLOTS
+	struct ubifs_rcache *rcache;
+#endif
 	struct list_head idx_gc;
 	int idx_gc_cnt;
 	int gc_seq;
@@ -1838,6 +1872,15 @@ int ubifs_wbuf_seek_nolock(struct ubifs_wbuf *wbuf, int lnum, int offs,
 int ubifs_wbuf_init(struct ubifs_info *c, struct ubifs_wbuf *wbuf);
 int ubifs_read_node(const struct ubifs_info *c, void *buf, int type, int len,
 		    int lnum, int offs);
+int ubifs_leb_read(const struct ubifs_info *c, int lnum, void *buf, int offs,
+		   int len, int ahead);
+#ifdef CONFIG_UBIFS_READ_CACHE_SLOTS
+int ubifs_rcache_init(struct ubifs_info *c);
+void ubifs_rcache_free(struct ubifs_info *c);
+#else
+#define ubifs_rcache_init(c) 0
+#define ubifs_rcache_free(c)
+#endif
 int ubifs_read_node_wbuf(struct ubifs_wbuf *wbuf, void *buf, int type, int len,
 			 int lnum, int offs);
 int ubifs_write_node(struct ubifs_info *c, void *node, int len, int lnum,
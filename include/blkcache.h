@@ -0,0 +1,95 @@
+/*
+ * Block device read cache
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+#ifndef _BLKCACHE_H
+#define _BLKCACHE_H
+
+#include <part.h>
+
+/*
+ * Filesystems and partition parsers read through blkcache_read() and
+ * write through blkcache_write() instead of calling the block_read and
+ * block_write hooks of the device directly.  Small reads are served
+ * from an LRU of read-ahead windows; writes go to the device first and
+ * then update any cached copy of the written blocks.
+ *
+ * Drivers must call blkcache_invalidate() whenever a descriptor is
+ * reinitialized (bus rescan, card change), since the cache is keyed by
+ * the descriptor address.  Both that and every blkcache_write() also
+ * drop the FAT directory cache of the device, so a raw write or a
+ * rescan never leaves stale directory entries behind.
+ */
+
+struct blkcache_stats {
+	unsigned long	hits;		/* reads served from the cache */
+	unsigned long	misses;		/* reads that filled a window */
+	unsigned long	bypass;		/* reads too large to cache */
+	unsigned long	ra_blocks;	/* blocks read ahead */
+	unsigned long	writes;		/* write-through requests */
+	int		entries;	/* number of windows */
+	int		window;		/* window size in bytes */
+	int		enabled;
+};
+
+#ifdef CONFIG_CMD_FAT
+void fat_dcache_invalidate(block_dev_desc_t *dev_desc);
+#else
+static inline void fat_dcache_invalidate(block_dev_desc_t *dev_desc) { }
+#endif
+
+#ifdef CONFIG_BLKCACHE
+unsigned long blkcache_read(block_dev_desc_t *dev_desc, unsigned long start,
+			    lbaint_t blkcnt, void *buffer);
+unsigned long blkcache_write(block_dev_desc_t *dev_desc, unsigned long start,
+			     lbaint_t blkcnt, const void *buffer);
+void blkcache_invalidate(block_dev_desc_t *dev_desc);
+void blkcache_invalidate_all(void);
+void blkcache_enable(int enable);
+void blkcache_get_stats(struct blkcache_stats *stats);
+void blkcache_clear_stats(void);
+#else
+static inline unsigned long blkcache_read(block_dev_desc_t *dev_desc,
+					  unsigned long start,
+					  lbaint_t blkcnt, void *buffer)
+{
+	return dev_desc->block_read(dev_desc->dev, start, blkcnt, buffer);
+}
+
+static inline unsigned long blkcache_write(block_dev_desc_t *dev_desc,
+					   unsigned long start,
+					   lbaint_t blkcnt, const void *buffer)
+{
+	fat_dcache_invalidate(dev_desc);
+	return dev_desc->block_write(dev_desc->dev, start, blkcnt, buffer);
+}
+
+static inline void blkcache_invalidate(block_dev_desc_t *dev_desc)
+{
+	fat_dcache_invalidate(dev_desc);
+}
+
+static inline void blkcache_invalidate_all(void)
+{
+	fat_dcache_invalidate(NULL);
+}
+#endif
+
+#endif /* _BLKCACHE_H */
@@ -266,6 +266,15 @@ BZ_EXTERN int BZ_API(BZ2_bzBuffToBuffDecompress) (
       int           verbosity
    );
 
+BZ_EXTERN int BZ_API(BZ2_bzBuffToBuffDecompressMulti) (
+      char*         dest,
+      unsigned int* destLen,
+      char*         source,
+      unsigned int  sourceLen,
+      int           small,
+      int           verbosity
+   );
+
 
 /*--
    Code contributed by Yoshioka Tsuneo
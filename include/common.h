@@ -739,6 +739,11 @@ int	init_timebase (void);
 
 /* lib/gunzip.c */
 int gunzip(void *, int, unsigned char *, unsigned long *);
+int gunzip_stream(int (*fill)(void *priv, unsigned char **buf,
+			      unsigned long *len),
+		  void *fill_priv,
+		  int (*sink)(void *priv, const void *buf, unsigned long len),
+		  void *sink_priv, unsigned long *lenp);
 int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 						int stoponerr, int offset);
 
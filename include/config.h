@@ -0,0 +1,9 @@
+/* Automatically generated - do not edit */
+#define CONFIG_OCTEON_UBNT_E200	1
+#define CONFIG_OCTEON_PCI_HOST	0
+#define CONFIG_BOARDDIR board/octeon/ubnt_e200
+#include <config_cmd_defaults.h>
+#include <config_defaults.h>
+#include <configs/octeon_ubnt_e200.h>
+#include <asm/config.h>
+#include <config_fallbacks.h>
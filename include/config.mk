@@ -0,0 +1,4 @@
+ARCH   = mips
+CPU    = octeon
+BOARD  = ubnt_e200
+VENDOR = octeon
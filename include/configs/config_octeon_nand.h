@@ -54,9 +54,18 @@
 /** Enable the UBI command */
 # define CONFIG_CMD_UBI
 
+/** Attach UBI from a Linux fastmap instead of scanning every PEB */
+# define CONFIG_MTD_UBI_FASTMAP
+
 /** Enable support for UBIFS */
 # define CONFIG_CMD_UBIFS
 
+/** Number of LEB regions UBIFS keeps cached for reading */
+# define CONFIG_UBIFS_READ_CACHE_SLOTS	8
+
+/** Size of each UBIFS read cache region, also the data node read-ahead */
+# define CONFIG_UBIFS_READ_CACHE_SIZE	(64 * 1024)
+
 /** Enable red-black tree support, needed for UBIFS */
 # define CONFIG_RBTREE
 
@@ -75,6 +84,19 @@
 # define CONFIG_MTD_NAND_ECC_JFFS2
 #endif
 
+/**
+ * Check and correct BCH ECC in place in the NAND DMA buffer rather than
+ * through the generic MTD software BCH page functions.  Only used when
+ * CONFIG_NAND_ECC_BCH is also enabled.
+ */
+#define CONFIG_OCTEON_NAND_DMA_BCH
+
+/**
+ * Number of pages read ahead with the ONFI read cache commands once the
+ * NAND driver sees a run of sequential page reads.
+ */
+#define CONFIG_OCTEON_NAND_READAHEAD_PAGES	8
+
 /** Enable ONFI detection */
 #define CONFIG_SYS_NAND_ONFI_DETECTION
 
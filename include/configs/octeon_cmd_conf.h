@@ -36,6 +36,8 @@
 #define CONFIG_CMD_UNZIP
 #define CONFIG_CMD_BUNZIP
 #define CONFIG_CMD_UNLZMA
+#define CONFIG_CMD_UNLZ4
+#define CONFIG_CMD_BLKCACHE	/* block cache statistics	*/
 #define CONFIG_CMD_MD5SUM
 #define CONFIG_CMD_STRINGS
 #define CONFIG_CMD_SETEXPR
@@ -48,6 +50,8 @@
 #define CONFIG_CMD_ECHO
 /*#define CONFIG_CMD_REGINFO*/		/* Not supported yet */
 #define CONFIG_CMD_OCTEON_REGINFO
+#define CONFIG_CMD_OCTEON_PERF		/* hardware counters around a command */
+#define CONFIG_CMD_OCTEON_PROF		/* sampling profiler, see CONFIG_KALLSYMS */
 #define CONFIG_CMD_ITEST
 #define CONFIG_CMD_RUN
 #define CONFIG_CMD_ASKENV
@@ -65,5 +69,10 @@
 
 #ifdef CONFIG_OCTEON_FLASH
 # define CONFIG_CMD_OCTEON_ERASEENV
+# define CONFIG_CMD_FLASH_UPDATE	/* flash update, see flash_update() */
+#endif
+
+#ifdef CONFIG_SYS_PCI_CONSOLE
+# define CONFIG_CMD_OCTEON_PCI_BULK	/* Bulk download from PCI host */
 #endif
 #endif	/* __OCTEON_CMD_CONF_H__ */
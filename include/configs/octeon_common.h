@@ -129,6 +129,16 @@
 /** Support DOS partitions for media */
 #define CONFIG_DOS_PARTITION
 
+/** Cache small block device reads used by partition and filesystem code */
+#define CONFIG_BLKCACHE
+
+/**
+ * Lock the network FPA pools and the MMC/NAND bounce buffers in L2.  At
+ * most CONFIG_OCTEON_L2_LOCK_SIZE bytes are locked, a quarter of the L2
+ * if it is not defined.
+ */
+#define CONFIG_OCTEON_L2_LOCK
+
 /** Allow command line auto complete */
 #define CONFIG_AUTO_COMPLETE
 
@@ -137,6 +147,9 @@
 # define CONFIG_BZIP2
 #endif
 
+/** Spread multi-stream (pbzip2) bzip2 images across idle cores */
+#define CONFIG_OCTEON_PARALLEL_BUNZIP
+
 /** Enable GZIP/ZIP compression */
 #ifndef CONFIG_GZIP
 # define CONFIG_GZIP
@@ -147,6 +160,11 @@
 # define CONFIG_LZMA
 #endif
 
+/** Enable LZ4 compression */
+#ifndef CONFIG_LZ4
+# define CONFIG_LZ4
+#endif
+
 /** Enable zlib support */
 #ifndef CONFIG_ZLIB
 # define CONFIG_ZLIB
@@ -240,6 +258,7 @@
 # define CONFIG_SYS_FLASH_USE_BUFFER_WRITE		/** Speeds up writes */
 /* # define CONFIG_SYS_CFI_FLASH_STATUS_POLL */		/** Polling support */
 # define CONFIG_SYS_FLASH_PROTECTION			/** Protects RO parts */
+# define CONFIG_FLASH_UPDATE_CRC	/** Compare sectors with the CRC unit */
 # define CONFIG_FLASH_CFI_MTD		/** Enable MTD support for CFI flash */
 # define CONFIG_MTD_DEVICE		/** Enable MTD support */
 # define CONFIG_MTD_PARTITIONS		/** Enable MTD partitions used by Linux */
@@ -409,7 +428,9 @@
  * This tells U-Boot to copy itself from flash into the L2 cache very early
  * on to speed up the boot process.  The resulting code in start.S will
  * first check that it is running on an OCTEON II processor and that the
- * L2 cache size is big enough.
+ * L2 cache size is big enough.  OCTEON and OCTEON Plus parts cannot hold
+ * lines for DRAM that is not initialized yet and always run from flash
+ * until DRAM is up.
  *
  * This can have a very dramatic improvement in bootup time, especially when
  * a lot of memory is installed (i.e. a CN68XX)
@@ -436,4 +457,12 @@
  */
 #define OCTEON_L2_MEMCPY_ADDR		0xffffffff81400000
 
+/**
+ * When U-Boot runs from the L2 cache it is kept in ways of its own until
+ * DRAM is initialized, so nothing else can evict it.  This many ways are
+ * left for everything else; if U-Boot is too big for that it shares all
+ * the ways.
+ */
+#define OCTEON_L2_UBOOT_FREE_WAYS	2
+
 #endif /* __OCTEON_COMMON_H__ */
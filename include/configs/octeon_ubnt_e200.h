@@ -67,8 +67,8 @@
 #define CONFIG_FACTORY_RESET_GPIO      0
 #define CONFIG_FACTORY_RESET_TIME      3
 #define CONFIG_FACTORY_RESET_BOOTCMD   \
-    "fatload mmc 0 $(loadaddr) vmlinux.64;" \
-    "bootoctlinux $(loadaddr) numcores=2 endbootargs " \
+    "fatload mmc 0 ${loadaddr} vmlinux.64;" \
+    "bootoctlinux ${loadaddr} numcores=2 endbootargs " \
     "mem=0 root=/dev/mmcblk0p2 rootdelay=10 rw " \
     "rootsqimg=squashfs.img rootsqwdir=w " \
     "mtdparts=" _FLASH_PARTS " resetsqimg"
@@ -96,10 +96,15 @@ extern void board_set_led_normal(void);
 /*
  * Miscellaneous configurable options
  */
+/* hush understands ${var} only, which is why the scripts here use it */
+#define CONFIG_SYS_HUSH_PARSER
+#define CONFIG_SYS_PROMPT_HUSH_PS2	"> "
+#define CONFIG_HUSH_SCRIPT_CACHE	/* parse bootcmd and "run" once */
+
 /* Environment variables that will be set by default */
 #define	CONFIG_EXTRA_ENV_SETTINGS \
-    "nuke_env=protect off $(env_addr) +$(env_size);" \
-        "erase $(env_addr) +$(env_size)\0" \
+    "nuke_env=protect off ${env_addr} +${env_size};" \
+        "erase ${env_addr} +${env_size}\0" \
     "mtdparts=" _FLASH_PARTS "\0" \
     "autoload=n\0" \
     ""
@@ -124,6 +129,7 @@ extern void board_set_led_normal(void);
 # define	CONFIG_ENV_IS_NOWHERE	1
 #else
 # define	CONFIG_ENV_IS_IN_FLASH	1
+# define	CONFIG_ENV_FLASH_LOG	/* saveenv appends changes */
 #endif
 
 /* Address and size of Primary Environment Sector	*/
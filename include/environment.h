@@ -148,6 +148,30 @@ typedef struct environment_s {
 	unsigned char	data[ENV_SIZE]; /* Environment data		*/
 } env_t;
 
+/*
+ * Log-structured flash environment (CONFIG_ENV_FLASH_LOG).  The data area
+ * starts with the usual NUL-separated "name=value" list.  After its
+ * terminating empty string, aligned to ENV_LOG_ALIGN, comes an
+ * env_log_head and then the records appended by later saves: an
+ * env_log_rec followed by a payload of "name=value\0" entries ("name\0"
+ * deletes the variable), padded to ENV_LOG_ALIGN.  The log ends at the
+ * first record whose CRC does not match and the rest of the area is left
+ * erased.  The crc in env_t only holds until the first append, so readers
+ * check head.base_crc instead.
+ */
+#define ENV_LOG_MAGIC	0x454c4f47	/* "ELOG" */
+#define ENV_LOG_ALIGN	8
+
+struct env_log_head {
+	uint32_t	magic;
+	uint32_t	base_crc;	/* CRC32 of the list before the head */
+};
+
+struct env_log_rec {
+	uint32_t	crc;		/* CRC32 of len and the payload */
+	uint32_t	len;		/* payload bytes */
+};
+
 #ifdef ENV_IS_EMBEDDED
 extern env_t environment;
 #endif /* ENV_IS_EMBEDDED */
@@ -190,6 +214,11 @@ void set_default_env(const char *s);
 /* Import from binary representation into hash table */
 int env_import(const char *buf, int check);
 
+#ifdef CONFIG_ENV_FLASH_LOG
+/* Look up a variable in the records appended to the flash environment */
+int env_log_getenv_f(const char *name, char *buf, unsigned len);
+#endif
+
 /* Architecture hook called whenever an environment variable is set */
 env_set_hook_rc_t setenv_arch(const char *var, const char *old_value,
 			      const char *new_value);
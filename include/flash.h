@@ -100,6 +100,7 @@ extern int flash_sect_protect (int flag, ulong addr_first, ulong addr_last);
 extern int flash_sect_roundb (ulong *addr);
 extern unsigned long flash_sector_size(flash_info_t *info, flash_sect_t sect);
 extern void flash_set_verbose(uint);
+extern int flash_update (char *src, ulong addr, ulong cnt);
 
 /* common/flash.c */
 extern void flash_protect (int flag, ulong from, ulong to, flash_info_t *info);
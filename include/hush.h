@@ -36,6 +36,10 @@ int set_local_var(const char *s, int flg_export);
 void unset_local_var(const char *name);
 char *get_local_var(const char *s);
 
+#ifdef CONFIG_HUSH_SCRIPT_CACHE
+void hush_script_cache_forget(const char *s);
+#endif
+
 #if defined(CONFIG_HUSH_INIT_VAR)
 extern int hush_init_var (void);
 #endif
@@ -1373,6 +1373,58 @@ int BZ_API(BZ2_bzBuffToBuffDecompress)
 }
 
 
+/*---------------------------------------------------*/
+/*--
+   Like BZ2_bzBuffToBuffDecompress, but carries on with the
+   next stream for as long as one follows, so that a
+   multi-stream image (pbzip2, or concatenated .bz2 files)
+   is decompressed whole instead of up to its first stream
+   end, as bunzip2 does.
+--*/
+int BZ_API(BZ2_bzBuffToBuffDecompressMulti)
+			   ( char*         dest,
+			     unsigned int* destLen,
+			     char*         source,
+			     unsigned int  sourceLen,
+			     int           small,
+			     int           verbosity )
+{
+   unsigned int out = 0;
+   bz_stream strm;
+   int ret;
+
+   if (destLen == NULL || source == NULL)
+	  return BZ_PARAM_ERROR;
+
+   do {
+      strm.bzalloc = NULL;
+      strm.bzfree = NULL;
+      strm.opaque = NULL;
+      ret = BZ2_bzDecompressInit ( &strm, verbosity, small );
+      if (ret != BZ_OK) return ret;
+
+      strm.next_in = source;
+      strm.avail_in = sourceLen;
+      strm.next_out = dest + out;
+      strm.avail_out = *destLen - out;
+
+      ret = BZ2_bzDecompress ( &strm );
+      BZ2_bzDecompressEnd ( &strm );
+      if (ret == BZ_OK)
+	 return strm.avail_out > 0 ? BZ_UNEXPECTED_EOF : BZ_OUTBUFF_FULL;
+      if (ret != BZ_STREAM_END) return ret;
+
+      out = *destLen - strm.avail_out;
+      source = strm.next_in;
+      sourceLen = strm.avail_in;
+   } while (sourceLen >= 4 && source[0] == 'B' && source[1] == 'Z' &&
+	    source[2] == 'h' && source[3] >= '1' && source[3] <= '9');
+
+   *destLen = out;
+   return BZ_OK;
+}
+
+
 /*---------------------------------------------------*/
 /*--
    Code contributed by Yoshioka Tsuneo
@@ -1591,10 +1643,12 @@ const char * BZ_API(BZ2_bzerror) (BZFILE *b, int *errnum)
 }
 #endif
 
-void bz_internal_error(int errcode)
+void __bz_internal_error(int errcode)
 {
 	printf ("BZIP2 internal error %d\n", errcode);
 }
+void bz_internal_error(int errcode)
+	__attribute__((weak, alias("__bz_internal_error")));
 
 /*-------------------------------------------------------------*/
 /*--- end                                           bzlib.c ---*/
@@ -36,6 +36,10 @@
 #define RESERVED		0xe0
 #define DEFLATED		8
 
+#ifndef CONFIG_SYS_GUNZIP_STREAM_WINDOW
+#define CONFIG_SYS_GUNZIP_STREAM_WINDOW	(64 << 10)
+#endif
+
 void *gzalloc(void *x, unsigned items, unsigned size)
 {
 	void *p;
@@ -53,7 +57,11 @@ void gzfree(void *x, void *addr, unsigned nb)
 	free (addr);
 }
 
-int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
+/*
+ * Return the length of the gzip header at @src, or -1 if it is not a
+ * deflated gzip stream.
+ */
+static int gunzip_hdr_len(unsigned char *src, unsigned long len)
 {
 	int i, flags;
 
@@ -74,14 +82,105 @@ int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 			;
 	if ((flags & HEAD_CRC) != 0)
 		i += 2;
-	if (i >= *lenp) {
+	if (i >= len) {
 		puts ("Error: gunzip out of data in header\n");
 		return (-1);
 	}
 
+	return i;
+}
+
+int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
+{
+	int i;
+
+	i = gunzip_hdr_len(src, *lenp);
+	if (i < 0)
+		return (-1);
+
 	return zunzip(dst, dstlen, src, lenp, 1, i);
 }
 
+/*
+ * Inflate a gzip image a window at a time.  The compressed data is pulled
+ * from @fill, which sets *buf and *len to the next chunk (*len = 0 at the
+ * end) and returns < 0 on error; the first chunk must hold the whole gzip
+ * header.  Each window of output is handed to @sink rather than written
+ * to one buffer.  @sink returns < 0 to abort, 0 to continue and > 0 to
+ * stop early without error.  On return *@lenp holds the number of bytes
+ * passed to @sink.
+ */
+int gunzip_stream(int (*fill)(void *priv, unsigned char **buf,
+			      unsigned long *len),
+		  void *fill_priv,
+		  int (*sink)(void *priv, const void *buf, unsigned long len),
+		  void *sink_priv, unsigned long *lenp)
+{
+	z_stream s;
+	unsigned char *win, *in;
+	unsigned long in_len, total = 0;
+	int i, r, ret = 0;
+
+	*lenp = 0;
+	if (fill(fill_priv, &in, &in_len) < 0)
+		return -1;
+	i = gunzip_hdr_len(in, in_len);
+	if (i < 0)
+		return -1;
+
+	win = malloc(CONFIG_SYS_GUNZIP_STREAM_WINDOW);
+	if (!win) {
+		puts("Error: gunzip out of memory\n");
+		return -1;
+	}
+
+	s.zalloc = gzalloc;
+	s.zfree = gzfree;
+	r = inflateInit2(&s, -MAX_WBITS);
+	if (r != Z_OK) {
+		printf ("Error: inflateInit2() returned %d\n", r);
+		free(win);
+		return -1;
+	}
+	s.next_in = in + i;
+	s.avail_in = in_len - i;
+	do {
+		if (!s.avail_in) {
+			if (fill(fill_priv, &in, &in_len) < 0) {
+				ret = -1;
+				break;
+			}
+			if (!in_len) {
+				puts("Error: gunzip out of data\n");
+				ret = -1;
+				break;
+			}
+			s.next_in = in;
+			s.avail_in = in_len;
+		}
+		s.next_out = win;
+		s.avail_out = CONFIG_SYS_GUNZIP_STREAM_WINDOW;
+		r = inflate(&s, Z_SYNC_FLUSH);
+		if (r != Z_OK && r != Z_STREAM_END) {
+			printf("Error: inflate() returned %d\n", r);
+			ret = -1;
+			break;
+		}
+		if (s.next_out != win) {
+			ret = sink(sink_priv, win, s.next_out - win);
+			total += s.next_out - win;
+			if (ret)
+				break;
+		}
+		WATCHDOG_RESET();
+	} while (r != Z_STREAM_END);
+	inflateEnd(&s);
+	free(win);
+	*lenp = total;
+
+	return ret < 0 ? -1 : 0;
+}
+
 /*
  * Uncompress blocks compressed with zlib without headers
  */
@@ -0,0 +1,286 @@
+/*
+ *  LZ4 Decompressor
+ *
+ *  Based on the LZ4 block and frame formats of the LZ4 reference
+ *  implementation.
+ *
+ *  LZ4 - Fast LZ compression algorithm
+ *  Copyright (C) 2011-2012, Yann Collet.
+ *  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *  notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above
+ *  copyright notice, this list of conditions and the following disclaimer
+ *  in the documentation and/or other materials provided with the
+ *  distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  You can contact the author at :
+ *  - LZ4 homepage : http://fastcompression.blogspot.com/p/lz4.html
+ *  - LZ4 source repository : http://code.google.com/p/lz4/
+ */
+
+#include <common.h>
+#include <watchdog.h>
+#include <linux/lz4.h>
+#include <asm/byteorder.h>
+#include <asm/unaligned.h>
+
+#define LZ4_MAGIC		0x184D2204	/* frame format */
+#define LZ4_LEGACY_MAGIC	0x184C2102	/* lz4 -l, used by Linux */
+
+/* Every legacy block but the last decompresses to exactly this size */
+#define LZ4_LEGACY_BLOCK_SIZE	(8 << 20)
+
+#define LZ4_MIN_MATCH		4
+
+/* Frame descriptor FLG bits */
+#define LZ4_FLG_VERSION_MASK	0xc0
+#define LZ4_FLG_VERSION		0x40
+#define LZ4_FLG_BLOCK_CSUM	0x10
+#define LZ4_FLG_CONTENT_SIZE	0x08
+#define LZ4_FLG_CONTENT_CSUM	0x04
+#define LZ4_FLG_DICT_ID		0x01
+
+/* Uncompressed block flag in the frame block size */
+#define LZ4_BLOCK_RAW		0x80000000
+
+/* Read an LZ4 length extension: bytes of 255 ending with one < 255 */
+static inline int get_len(const unsigned char **ip,
+			  const unsigned char *ip_end, size_t *len)
+{
+	unsigned s;
+
+	do {
+		if (*ip >= ip_end)
+			return -1;
+		s = *(*ip)++;
+		*len += s;
+	} while (s == 255);
+
+	return 0;
+}
+
+/*
+ * Decompress one block.  Matches may reach back to @base, so blocks of a
+ * linked frame can refer to the output of the blocks before them.
+ */
+static int lz4_block(const unsigned char *in, size_t in_len,
+		     unsigned char *base, unsigned char *out, size_t *out_len)
+{
+	const unsigned char * const ip_end = in + in_len;
+	unsigned char * const op_end = out + *out_len;
+	const unsigned char *ip = in;
+	unsigned char *op = out;
+	const unsigned char *m_pos;
+	size_t len, off;
+	unsigned token;
+
+	*out_len = 0;
+
+	while (ip < ip_end) {
+		token = *ip++;
+
+		/* literals */
+		len = token >> 4;
+		if (len == 15 && get_len(&ip, ip_end, &len))
+			return LZ4_E_INPUT_OVERRUN;
+		if ((size_t)(ip_end - ip) < len)
+			return LZ4_E_INPUT_OVERRUN;
+		if ((size_t)(op_end - op) < len)
+			return LZ4_E_OUTPUT_OVERRUN;
+		memcpy(op, ip, len);
+		op += len;
+		ip += len;
+
+		/* the last sequence has literals only */
+		if (ip == ip_end)
+			break;
+
+		/* match */
+		if (ip_end - ip < 2)
+			return LZ4_E_INPUT_OVERRUN;
+		off = get_unaligned_le16(ip);
+		ip += 2;
+		if (off == 0 || off > (size_t)(op - base))
+			return LZ4_E_LOOKBEHIND_OVERRUN;
+		m_pos = op - off;
+
+		len = token & 15;
+		if (len == 15 && get_len(&ip, ip_end, &len))
+			return LZ4_E_INPUT_OVERRUN;
+		len += LZ4_MIN_MATCH;
+		if ((size_t)(op_end - op) < len)
+			return LZ4_E_OUTPUT_OVERRUN;
+
+		if (off >= len) {
+			memcpy(op, m_pos, len);
+			op += len;
+		} else {
+			/* overlapping match repeats the last off bytes */
+			do {
+				*op++ = *m_pos++;
+			} while (--len > 0);
+		}
+	}
+
+	*out_len = op - out;
+	return LZ4_E_OK;
+}
+
+int lz4_decompress_safe(const unsigned char *src, size_t src_len,
+			unsigned char *dst, size_t *dst_len)
+{
+	return lz4_block(src, src_len, dst, dst, dst_len);
+}
+
+/* Legacy format: magic, then independent blocks each with a 32 bit size */
+static int lz4_legacy(const unsigned char *src, size_t src_len,
+		      unsigned char *dst, size_t *dst_len)
+{
+	const unsigned char *send = src + src_len;
+	unsigned char *start = dst;
+	unsigned char *dend = dst + *dst_len;
+	size_t tmp;
+	u32 slen;
+	int r;
+
+	src += 4;
+	while (send - src >= 4) {
+		slen = get_unaligned_le32(src);
+		/* a concatenated stream starts a new header */
+		if (slen == LZ4_LEGACY_MAGIC) {
+			src += 4;
+			continue;
+		}
+		src += 4;
+		if (slen > send - src) {
+			/*
+			 * Only the size the kernel build appends may end the
+			 * input here, after a full last block.
+			 */
+			if (src == send && dst != start)
+				break;
+			return LZ4_E_INPUT_OVERRUN;
+		}
+
+		tmp = dend - dst;
+		r = lz4_block(src, slen, dst, dst, &tmp);
+		if (r != LZ4_E_OK)
+			return r;
+		src += slen;
+		dst += tmp;
+		WATCHDOG_RESET();
+
+		/*
+		 * A short block is the last one.  This also keeps us from
+		 * reading the uncompressed size the kernel build appends, or
+		 * whatever follows when the length is not known.
+		 */
+		if (tmp < LZ4_LEGACY_BLOCK_SIZE)
+			break;
+	}
+
+	*dst_len = dst - start;
+	return LZ4_E_OK;
+}
+
+/*
+ * Frame format.  Content and block checksums (xxHash32) are skipped, the
+ * image container carries its own CRC.
+ */
+static int lz4_frame(const unsigned char *src, size_t src_len,
+		     unsigned char *dst, size_t *dst_len)
+{
+	const unsigned char *send = src + src_len;
+	unsigned char *start = dst;
+	unsigned char *dend = dst + *dst_len;
+	unsigned char *base;
+	unsigned char flg;
+	size_t tmp;
+	u32 blen;
+	int r;
+
+	src += 4;
+	if (send - src < 3)
+		return LZ4_E_INPUT_OVERRUN;
+	flg = src[0];
+	if ((flg & LZ4_FLG_VERSION_MASK) != LZ4_FLG_VERSION)
+		return LZ4_E_ERROR;
+	if (flg & LZ4_FLG_DICT_ID)
+		return LZ4_E_NOT_YET_IMPLEMENTED;
+	/* FLG, BD, optional content size, header checksum */
+	src += 2 + ((flg & LZ4_FLG_CONTENT_SIZE) ? 8 : 0) + 1;
+
+	/*
+	 * Blocks of a linked frame may refer to the output of earlier
+	 * blocks; valid independent blocks never reach that far back.
+	 */
+	base = dst;
+	for (;;) {
+		if (send - src < 4)
+			return LZ4_E_INPUT_OVERRUN;
+		blen = get_unaligned_le32(src);
+		src += 4;
+		if (blen == 0)
+			break;
+
+		tmp = blen & ~LZ4_BLOCK_RAW;
+		if (tmp > send - src)
+			return LZ4_E_INPUT_OVERRUN;
+		if (blen & LZ4_BLOCK_RAW) {
+			if (tmp > dend - dst)
+				return LZ4_E_OUTPUT_OVERRUN;
+			memcpy(dst, src, tmp);
+			src += tmp;
+			dst += tmp;
+		} else {
+			size_t out = dend - dst;
+
+			r = lz4_block(src, tmp, base, dst, &out);
+			if (r != LZ4_E_OK)
+				return r;
+			src += tmp;
+			dst += out;
+		}
+		if (flg & LZ4_FLG_BLOCK_CSUM)
+			src += 4;
+		WATCHDOG_RESET();
+	}
+
+	*dst_len = dst - start;
+	return LZ4_E_OK;
+}
+
+int lz4_decompress(const unsigned char *src, size_t src_len,
+		   unsigned char *dst, size_t *dst_len)
+{
+	u32 magic;
+
+	if (src_len < 4)
+		return LZ4_E_INPUT_OVERRUN;
+
+	magic = get_unaligned_le32(src);
+	if (magic == LZ4_MAGIC)
+		return lz4_frame(src, src_len, dst, dst_len);
+	if (magic == LZ4_LEGACY_MAGIC)
+		return lz4_legacy(src, src_len, dst, dst_len);
+
+	return LZ4_E_ERROR;
+}
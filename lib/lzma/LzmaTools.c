@@ -44,6 +44,10 @@
 #define LZMA_SIZE_OFFSET       LZMA_PROPS_SIZE
 #define LZMA_DATA_OFFSET       LZMA_SIZE_OFFSET+sizeof(uint64_t)
 
+#ifndef CONFIG_SYS_LZMA_STREAM_WINDOW
+#define CONFIG_SYS_LZMA_STREAM_WINDOW  (64 << 10)
+#endif
+
 #include "LzmaTools.h"
 #include "LzmaDec.h"
 
@@ -130,4 +134,131 @@ int lzmaBuffToBuffDecompress (unsigned char *outStream, SizeT *uncompressedSize,
     return res;
 }
 
+/*
+ * Decompress an LZMA image a window at a time.  The compressed data is
+ * pulled from fill(), which sets *buf and *len to the next chunk (*len = 0
+ * at the end) and returns < 0 on error; the first chunk must hold the
+ * whole header.  Each window of output is handed to sink() instead of
+ * being written to one buffer.  sink() returns < 0 to abort, 0 to continue
+ * and > 0 to stop early.  The dictionary goes to dic if it is at least
+ * dicSize bytes, and is allocated with malloc() otherwise.  On return
+ * *length holds the number of bytes passed to sink().
+ */
+int lzmaStreamDecompress (int (*fill)(void *priv, unsigned char **buf, unsigned long *len),
+                  void *fill_priv,
+                  int (*sink)(void *priv, const void *buf, unsigned long len),
+                  void *sink_priv, SizeT *length,
+                  unsigned char *dic, SizeT dicSize)
+{
+    CLzmaDec dec;
+    CLzmaProps props;
+    ISzAlloc g_Alloc;
+    ELzmaStatus status;
+    unsigned char *win;
+    unsigned char *in;
+    unsigned long inLeft;
+    SizeT inLen, outLen;
+    SizeT total = 0;
+    UInt32 outSize = 0, outSizeHigh = 0;
+    int known, i, ret = 0;
+    SRes res;
+
+    *length = 0;
+    if (fill(fill_priv, &in, &inLeft) < 0)
+        return SZ_ERROR_READ;
+    if (inLeft < LZMA_DATA_OFFSET)
+        return SZ_ERROR_INPUT_EOF;
+
+    for (i = 0; i < 8; i++) {
+        unsigned char b = in[LZMA_SIZE_OFFSET + i];
+        if (i < 4)
+            outSize     += (UInt32)(b) << (i * 8);
+        else
+            outSizeHigh += (UInt32)(b) << ((i - 4) * 8);
+    }
+    /* All 0xff means the size is unknown and the stream has an end mark */
+    known = !(outSize == 0xFFFFFFFF && outSizeHigh == 0xFFFFFFFF);
+    if (known && outSizeHigh != 0) {
+        debug ("LZMA: 64bit support not enabled.\n");
+        return SZ_ERROR_DATA;
+    }
+
+    res = LzmaProps_Decode(&props, in, LZMA_PROPS_SIZE);
+    if (res != SZ_OK)
+        return res;
+
+    g_Alloc.Alloc = SzAlloc;
+    g_Alloc.Free = SzFree;
+
+    win = malloc(CONFIG_SYS_LZMA_STREAM_WINDOW);
+    if (!win)
+        return SZ_ERROR_MEM;
+
+    LzmaDec_Construct(&dec);
+    if (dic && dicSize >= props.dicSize) {
+        /* LzmaDec_Allocate() keeps a dictionary of the right size */
+        dec.dic = dic;
+        dec.dicBufSize = props.dicSize;
+    } else {
+        dic = NULL;
+    }
+    res = LzmaDec_Allocate(&dec, in, LZMA_PROPS_SIZE, &g_Alloc);
+    if (res != SZ_OK) {
+        free(win);
+        return res;
+    }
+    LzmaDec_Init(&dec);
+    in += LZMA_DATA_OFFSET;
+    inLeft -= LZMA_DATA_OFFSET;
+
+    for (;;) {
+        if (!inLeft) {
+            if (fill(fill_priv, &in, &inLeft) < 0) {
+                res = SZ_ERROR_READ;
+                break;
+            }
+            if (!inLeft) {
+                res = SZ_ERROR_INPUT_EOF;
+                break;
+            }
+        }
+        inLen = inLeft;
+        outLen = CONFIG_SYS_LZMA_STREAM_WINDOW;
+        if (known && outLen > outSize - total)
+            outLen = outSize - total;
+        res = LzmaDec_DecodeToBuf(&dec, win, &outLen, in, &inLen,
+                                  LZMA_FINISH_ANY, &status);
+        if (res != SZ_OK)
+            break;
+        in += inLen;
+        inLeft -= inLen;
+        if (outLen) {
+            total += outLen;
+            ret = sink(sink_priv, win, outLen);
+            if (ret)
+                break;
+        }
+        if (status == LZMA_STATUS_FINISHED_WITH_MARK ||
+            (known && total == outSize))
+            break;
+        if (!inLen && !outLen) {
+            /* No progress on the data we have */
+            res = SZ_ERROR_DATA;
+            break;
+        }
+        WATCHDOG_RESET();
+    }
+
+    if (dic)
+        LzmaDec_FreeProbs(&dec, &g_Alloc);
+    else
+        LzmaDec_Free(&dec, &g_Alloc);
+    free(win);
+    *length = total;
+    if (res != SZ_OK)
+        return res;
+
+    return ret < 0 ? SZ_ERROR_DATA : SZ_OK;
+}
+
 #endif
@@ -32,4 +32,9 @@
 
 extern int lzmaBuffToBuffDecompress (unsigned char *outStream, SizeT *uncompressedSize,
 			      unsigned char *inStream,  SizeT  length);
+extern int lzmaStreamDecompress (int (*fill)(void *priv, unsigned char **buf, unsigned long *len),
+			      void *fill_priv,
+			      int (*sink)(void *priv, const void *buf, unsigned long len),
+			      void *sink_priv, SizeT *length,
+			      unsigned char *dic, SizeT dicSize);
 #endif
@@ -23,6 +23,12 @@
 
 #include <common.h>
 #include <watchdog.h>
+#ifdef CONFIG_CMD_OCTEON_PROF
+#include <asm/arch/cvmx.h>
+#include <asm/arch/octeon_prof.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+#endif
 
 #ifndef CONFIG_WD_PERIOD
 # define CONFIG_WD_PERIOD	(10 * 1000 * 1000)	/* 10 seconds default*/
@@ -34,12 +40,18 @@ void udelay(unsigned long usec)
 {
 	ulong kv;
 
+#ifdef CONFIG_CMD_OCTEON_PROF
+	octeon_prof_set_udelay_pc(__builtin_return_address(0));
+#endif
 	do {
 		WATCHDOG_RESET();
 		kv = usec > CONFIG_WD_PERIOD ? CONFIG_WD_PERIOD : usec;
 		__udelay (kv);
 		usec -= kv;
 	} while(usec);
+#ifdef CONFIG_CMD_OCTEON_PROF
+	octeon_prof_set_udelay_pc(NULL);
+#endif
 }
 
 void mdelay(unsigned long msec)
@@ -210,7 +210,6 @@ static char default_environment[] = {
 };
 
 static int flash_io (int mode);
-static char *envmatch (char * s1, char * s2);
 static int parse_config (void);
 
 #if defined(CONFIG_FILE)
@@ -218,7 +217,7 @@ static int get_config (char *);
 #endif
 static inline ulong getenvsize (void)
 {
-	ulong rc = CONFIG_ENV_SIZE - sizeof (long);
+	ulong rc = CONFIG_ENV_SIZE - sizeof (uint32_t);
 
 	if (HaveRedundEnv)
 		rc -= sizeof (char);
@@ -242,32 +241,306 @@ static char *fw_string_blank(char *s, int noblank)
 }
 
 /*
- * Search the environment for a variable.
- * Return the value, if found, or NULL, if not found.
+ * Variables are kept in an index built once by fw_env_open(): a hash on
+ * the name for lookups and a list in environment order for printing and
+ * writing back.  Deleted variables stay in the index with a NULL value
+ * and flash_value remembers what the flash holds, so fw_env_close() can
+ * tell what changed.
  */
-char *fw_getenv (char *name)
+struct env_var {
+	struct env_var	*next;		/* in environment order */
+	struct env_var	*hnext;		/* hash chain */
+	char		*value;		/* NULL if deleted */
+	char		*flash_value;	/* NULL if not in flash */
+	char		name[];
+};
+
+#define ENV_HASH_SIZE	256
+
+static struct env_var *env_hash[ENV_HASH_SIZE];
+static struct env_var *env_list;
+static struct env_var **env_list_end = &env_list;
+static ulong env_used = 1;	/* exported size, with the final NUL */
+static int env_opened;
+
+static unsigned int env_hash_name (const char *name, size_t len)
 {
-	char *env, *nxt;
+	unsigned int h = 5381;
 
-	if (fw_env_open())
+	while (len--)
+		h = h * 33 + (unsigned char)*name++;
+	return h % ENV_HASH_SIZE;
+}
+
+static struct env_var *env_find (const char *name, size_t len)
+{
+	struct env_var *v;
+
+	for (v = env_hash[env_hash_name (name, len)]; v; v = v->hnext)
+		if (strncmp (v->name, name, len) == 0 && v->name[len] == '\0')
+			return v;
+	return NULL;
+}
+
+/* Look up name, adding a deleted entry for it if it is not indexed yet */
+static struct env_var *env_add (const char *name, size_t len)
+{
+	struct env_var *v;
+	unsigned int h;
+
+	v = env_find (name, len);
+	if (v)
+		return v;
+
+	v = calloc (1, sizeof (*v) + len + 1);
+	if (!v) {
+		fprintf (stderr, "Cannot malloc %zu bytes: %s\n",
+			 sizeof (*v) + len + 1, strerror (errno));
 		return NULL;
+	}
+	memcpy (v->name, name, len);
+
+	h = env_hash_name (name, len);
+	v->hnext = env_hash[h];
+	env_hash[h] = v;
+	*env_list_end = v;
+	env_list_end = &v->next;
+	return v;
+}
 
-	for (env = environment.data; *env; env = nxt + 1) {
-		char *val;
+/* Set the value of v to len bytes at value, or delete it if value is NULL */
+static int env_set_var (struct env_var *v, const char *value, size_t len)
+{
+	char *s = NULL;
 
-		for (nxt = env; *nxt; ++nxt) {
-			if (nxt >= &environment.data[ENV_SIZE]) {
+	if (value) {
+		s = malloc (len + 1);
+		if (!s) {
+			fprintf (stderr, "Cannot malloc %zu bytes: %s\n",
+				 len + 1, strerror (errno));
+			return -1;
+		}
+		memcpy (s, value, len);
+		s[len] = '\0';
+		env_used += strlen (v->name) + len + 2;
+	}
+
+	if (v->value) {
+		env_used -= strlen (v->name) + strlen (v->value) + 2;
+		free (v->value);
+	}
+	v->value = s;
+	return 0;
+}
+
+static int env_changed (const struct env_var *v)
+{
+	if (!v->value || !v->flash_value)
+		return v->value != v->flash_value;
+	return strcmp (v->value, v->flash_value) != 0;
+}
+
+/*
+ * Add the "name=value" entries in size bytes at data to the index, up to
+ * the first empty string.  A bare "name" deletes the variable, as in the
+ * records of the environment log.
+ */
+static int env_import (const char *data, size_t size)
+{
+	const char *end = data + size;
+	const char *eq, *nxt;
+	struct env_var *v;
+
+	for (; data < end && *data; data = nxt + 1) {
+		for (nxt = data; *nxt; ++nxt) {
+			if (nxt + 1 >= end) {
 				fprintf (stderr, "## Error: "
 					"environment not terminated\n");
-				return NULL;
+				return -1;
 			}
 		}
-		val = envmatch (name, env);
-		if (!val)
+
+		eq = memchr (data, '=', nxt - data);
+		v = env_add (data, (eq ? eq : nxt) - data);
+		if (!v)
+			return -1;
+		if (env_set_var (v, eq ? eq + 1 : NULL, eq ? nxt - eq - 1 : 0))
+			return -1;
+	}
+	return 0;
+}
+
+/* Export the index as a double NUL terminated list, size >= env_used */
+static void env_export (char *data)
+{
+	struct env_var *v;
+
+	for (v = env_list; v; v = v->next) {
+		if (!v->value)
 			continue;
-		return val;
+		data += sprintf (data, "%s=%s", v->name, v->value) + 1;
 	}
-	return NULL;
+	*data = '\0';
+}
+
+/* Remember the indexed values as the contents of the flash */
+static int env_saved (void)
+{
+	struct env_var *v;
+
+	for (v = env_list; v; v = v->next) {
+		if (!env_changed (v))
+			continue;
+		free (v->flash_value);
+		v->flash_value = v->value ? strdup (v->value) : NULL;
+		if (v->value && !v->flash_value) {
+			fprintf (stderr, "Cannot malloc: %s\n",
+				 strerror (errno));
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * The environment log written by U-Boot with CONFIG_ENV_FLASH_LOG, see
+ * include/environment.h: behind the list an env_log_head, then records
+ * of changed "name=value" or deleted "name" entries.  The log is only
+ * used on a single NOR copy that already has one, so the tools never
+ * append to an environment of a U-Boot which cannot read it.
+ */
+#define ENV_LOG_MAGIC	0x454c4f47	/* "ELOG" */
+#define ENV_LOG_ALIGN	8
+#define ENV_LOG_PAD(x)	(((x) + ENV_LOG_ALIGN - 1) & ~(ENV_LOG_ALIGN - 1))
+
+struct env_log_head {
+	uint32_t	magic;
+	uint32_t	base_crc;	/* CRC32 of the list before the head */
+};
+
+struct env_log_rec {
+	uint32_t	crc;		/* CRC32 of len and the payload */
+	uint32_t	len;		/* payload bytes */
+};
+
+static ulong env_log_tail;	/* offset of the next record, 0 if no log */
+static int env_log_dirty;	/* programmed bytes past the tail */
+
+/* Length of the list in data including its terminating empty string */
+static ulong env_log_list_len (const char *data)
+{
+	ulong i = 0;
+
+	while (i < ENV_SIZE && data[i]) {
+		while (i < ENV_SIZE && data[i])
+			i++;
+		i++;
+	}
+	return i + 1;
+}
+
+/* Offset of the first record if data has a log head, 0 otherwise */
+static ulong env_log_base (const char *data)
+{
+	const struct env_log_head *head;
+	ulong len, off;
+
+	len = env_log_list_len (data);
+	off = ENV_LOG_PAD (len);
+	if (off + sizeof (*head) > ENV_SIZE)
+		return 0;
+
+	head = (const struct env_log_head *)(data + off);
+	if (head->magic != ENV_LOG_MAGIC ||
+	    head->base_crc != crc32 (0, (const uint8_t *)data, len))
+		return 0;
+
+	return off + sizeof (*head);
+}
+
+/*
+ * Add the records of the log starting at off to the index and set up
+ * env_log_tail behind the last one.
+ */
+static int env_log_replay (const char *data, ulong off)
+{
+	const struct env_log_rec *rec;
+	const unsigned char *p;
+
+	while (off + sizeof (*rec) <= ENV_SIZE) {
+		rec = (const struct env_log_rec *)(data + off);
+		if (rec->len > ENV_SIZE - off - sizeof (*rec) ||
+		    rec->crc != crc32 (0, (const uint8_t *)&rec->len,
+				       sizeof (rec->len) + rec->len))
+			break;
+
+		/* The payload ends in a NUL, add the list terminator */
+		if (rec->len) {
+			char *buf = malloc (rec->len + 1);
+			int rc;
+
+			if (!buf) {
+				fprintf (stderr, "Cannot malloc %u bytes: %s\n",
+					 rec->len + 1, strerror (errno));
+				return -1;
+			}
+			memcpy (buf, rec + 1, rec->len);
+			buf[rec->len] = '\0';
+			rc = env_import (buf, rec->len + 1);
+			free (buf);
+			if (rc)
+				return -1;
+		}
+		off += ENV_LOG_PAD (sizeof (*rec) + rec->len);
+	}
+
+	/* An interrupted append leaves bytes we cannot program over */
+	for (p = (const unsigned char *)data + off;
+	     p < (const unsigned char *)data + ENV_SIZE; p++)
+		if (*p != 0xff)
+			break;
+	env_log_dirty = p < (const unsigned char *)data + ENV_SIZE;
+	env_log_tail = off;
+	return 0;
+}
+
+/*
+ * Put an empty log behind the list in data before it is written out,
+ * as U-Boot does.  Returns the offset of the first record, or 0 if the
+ * list leaves no room for a log.
+ */
+static ulong env_log_prepare (char *data)
+{
+	struct env_log_head *head;
+	ulong len, off;
+
+	len = env_log_list_len (data);
+	off = ENV_LOG_PAD (len);
+	if (off + sizeof (*head) >= ENV_SIZE)
+		return 0;
+
+	head = (struct env_log_head *)(data + off);
+	head->magic = ENV_LOG_MAGIC;
+	head->base_crc = crc32 (0, (const uint8_t *)data, len);
+	off += sizeof (*head);
+	memset (data + off, 0xff, ENV_SIZE - off);
+
+	return off;
+}
+
+/*
+ * Search the environment for a variable.
+ * Return the value, if found, or NULL, if not found.
+ */
+char *fw_getenv (char *name)
+{
+	struct env_var *v;
+
+	if (fw_env_open())
+		return NULL;
+
+	v = env_find (name, strlen (name));
+	return v ? v->value : NULL;
 }
 
 /*
@@ -276,7 +549,7 @@ char *fw_getenv (char *name)
  */
 int fw_printenv (int argc, char *argv[])
 {
-	char *env, *nxt;
+	struct env_var *v;
 	int i, n_flag;
 	int rc = 0;
 
@@ -284,17 +557,9 @@ int fw_printenv (int argc, char *argv[])
 		return -1;
 
 	if (argc == 1) {		/* Print all env variables  */
-		for (env = environment.data; *env; env = nxt + 1) {
-			for (nxt = env; *nxt; ++nxt) {
-				if (nxt >= &environment.data[ENV_SIZE]) {
-					fprintf (stderr, "## Error: "
-						"environment not terminated\n");
-					return -1;
-				}
-			}
-
-			printf ("%s\n", env);
-		}
+		for (v = env_list; v; v = v->next)
+			if (v->value)
+				printf ("%s=%s\n", v->name, v->value);
 		return 0;
 	}
 
@@ -313,38 +578,49 @@ int fw_printenv (int argc, char *argv[])
 
 	for (i = 1; i < argc; ++i) {	/* print single env variables   */
 		char *name = argv[i];
-		char *val = NULL;
-
-		for (env = environment.data; *env; env = nxt + 1) {
+		char *val = fw_getenv (name);
 
-			for (nxt = env; *nxt; ++nxt) {
-				if (nxt >= &environment.data[ENV_SIZE]) {
-					fprintf (stderr, "## Error: "
-						"environment not terminated\n");
-					return -1;
-				}
-			}
-			val = envmatch (name, env);
-			if (val) {
-				if (!n_flag) {
-					fputs (name, stdout);
-					putc ('=', stdout);
-				}
-				puts (val);
-				break;
-			}
-		}
 		if (!val) {
 			fprintf (stderr, "## Error: \"%s\" not defined\n", name);
 			rc = -1;
+			continue;
 		}
+		if (!n_flag) {
+			fputs (name, stdout);
+			putc ('=', stdout);
+		}
+		puts (val);
 	}
 
 	return rc;
 }
 
+static int flash_log_append (void);
+
 int fw_env_close(void)
 {
+	struct env_var *v;
+	ulong off = 0;
+
+	for (v = env_list; v; v = v->next)
+		if (env_changed (v))
+			break;
+	if (!v)
+		return 0;		/* nothing to write */
+
+	if (env_used > ENV_SIZE) {
+		fprintf (stderr, "Error: environment overflow\n");
+		return -1;
+	}
+
+	if (!flash_log_append ())
+		return env_saved ();
+
+	memset (environment.data, 0, ENV_SIZE);
+	env_export (environment.data);
+	if (env_log_tail)
+		off = env_log_prepare (environment.data);
+
 	/*
 	 * Update CRC
 	 */
@@ -357,7 +633,9 @@ int fw_env_close(void)
 			return -1;
 	}
 
-	return 0;
+	env_log_tail = off;
+	env_log_dirty = 0;
+	return env_saved ();
 }
 
 
@@ -368,25 +646,13 @@ int fw_env_close(void)
  */
 int fw_env_write(char *name, char *value)
 {
-	int len;
-	char *env, *nxt;
-	char *oldval = NULL;
+	struct env_var *v;
+	char *oldval;
+	size_t len;
 
-	/*
-	 * search if variable with this name already exists
-	 */
-	for (nxt = env = environment.data; *env; env = nxt + 1) {
-		for (nxt = env; *nxt; ++nxt) {
-			if (nxt >= &environment.data[ENV_SIZE]) {
-				fprintf(stderr, "## Error: "
-					"environment not terminated\n");
-				errno = EINVAL;
-				return -1;
-			}
-		}
-		if ((oldval = envmatch (name, env)) != NULL)
-			break;
-	}
+	len = strlen (name);
+	v = env_find (name, len);
+	oldval = v ? v->value : NULL;
 
 	/*
 	 * Delete any existing definition
@@ -409,52 +675,28 @@ int fw_env_write(char *name, char *value)
 		}
 #endif /* CONFIG_ENV_OVERWRITE */
 
-		if (*++nxt == '\0') {
-			*env = '\0';
-		} else {
-			for (;;) {
-				*env = *nxt++;
-				if ((*env == '\0') && (*nxt == '\0'))
-					break;
-				++env;
-			}
-		}
-		*++env = '\0';
+		env_set_var (v, NULL, 0);
 	}
 
 	/* Delete only ? */
 	if (!value || !strlen(value))
 		return 0;
 
-	/*
-	 * Append new definition at the end
-	 */
-	for (env = environment.data; *env || *(env + 1); ++env);
-	if (env > environment.data)
-		++env;
 	/*
 	 * Overflow when:
-	 * "name" + "=" + "val" +"\0\0"  > CONFIG_ENV_SIZE - (env-environment)
+	 * "name" + "=" + "val" +"\0" > ENV_SIZE - env_used
 	 */
-	len = strlen (name) + 2;
-	/* add '=' for first arg, ' ' for all others */
-	len += strlen(value) + 1;
-
-	if (len > (&environment.data[ENV_SIZE] - env)) {
+	if (env_used + len + strlen (value) + 2 > ENV_SIZE) {
 		fprintf (stderr,
 			"Error: environment overflow, \"%s\" deleted\n",
 			name);
 		return -1;
 	}
 
-	while ((*env = *name++) != '\0')
-		env++;
-	*env = '=';
-	while ((*++env = *value++) != '\0')
-		;
-
-	/* end is marked with double '\0' */
-	*++env = '\0';
+	if (!v)
+		v = env_add (name, len);
+	if (!v || env_set_var (v, value, strlen (value)))
+		return -1;
 
 	return 0;
 }
@@ -518,6 +760,84 @@ int fw_setenv(int argc, char *argv[])
 	return fw_env_close();
 }
 
+/*
+ * Read the next line of a script into dump, without the line end and
+ * skipping comments and empty lines.  Returns 1 for a line, 0 at the end
+ * of the file and -1 on a line that is too long or not terminated.
+ */
+static int fw_script_line(FILE *fp, char *dump, int size, int *lineno)
+{
+	int len;
+
+	while (fgets(dump, size, fp)) {
+		(*lineno)++;
+		len = strlen(dump);
+
+		/*
+		 * Read a whole line from the file. If the line is too long
+		 * or is not terminated, reports an error and exit.
+		 */
+		if (dump[len - 1] != '\n') {
+			fprintf(stderr,
+			"Line %d not corrected terminated or too long\n",
+				*lineno);
+			return -1;
+		}
+
+		/* Drop ending line feed / carriage return */
+		while (len > 0 && (dump[len - 1] == '\n' ||
+				dump[len - 1] == '\r')) {
+			dump[len - 1] = '\0';
+			len--;
+		}
+
+		/* Skip comment or empty lines */
+		if ((len == 0) || dump[0] == '#')
+			continue;
+
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Terminate the word at s and return the rest of the line after the
+ * following white space, or NULL if there is nothing left.
+ */
+static char *fw_script_word(char *s)
+{
+	char *val;
+	int len;
+
+	/* The first white space is the end of the word */
+	val = fw_string_blank(s, 0);
+	len = strlen(s);
+	if (val) {
+		*val++ = '\0';
+		if ((val - s) < len)
+			val = fw_string_blank(val, 1);
+		else
+			val = NULL;
+	}
+
+	return val;
+}
+
+static FILE *fw_script_open(char *fname)
+{
+	FILE *fp;
+
+	if (strcmp(fname, "-") == 0)
+		return stdin;
+
+	fp = fopen(fname, "r");
+	if (fp == NULL)
+		fprintf(stderr, "I cannot open %s for reading\n",
+			 fname);
+	return fp;
+}
+
 /*
  * Parse  a file  and configure the u-boot variables.
  * The script file has a very simple format, as follows:
@@ -542,7 +862,6 @@ int fw_parse_script(char *fname)
 	char *name;
 	char *val;
 	int lineno = 0;
-	int len;
 	int ret = 0;
 
 	if (fw_env_open()) {
@@ -550,44 +869,11 @@ int fw_parse_script(char *fname)
 		return -1;
 	}
 
-	if (strcmp(fname, "-") == 0)
-		fp = stdin;
-	else {
-		fp = fopen(fname, "r");
-		if (fp == NULL) {
-			fprintf(stderr, "I cannot open %s for reading\n",
-				 fname);
-			return -1;
-		}
-	}
-
-	while (fgets(dump, sizeof(dump), fp)) {
-		lineno++;
-		len = strlen(dump);
-
-		/*
-		 * Read a whole line from the file. If the line is too long
-		 * or is not terminated, reports an error and exit.
-		 */
-		if (dump[len - 1] != '\n') {
-			fprintf(stderr,
-			"Line %d not corrected terminated or too long\n",
-				lineno);
-			ret = -1;
-			break;
-		}
-
-		/* Drop ending line feed / carriage return */
-		while (len > 0 && (dump[len - 1] == '\n' ||
-				dump[len - 1] == '\r')) {
-			dump[len - 1] = '\0';
-			len--;
-		}
-
-		/* Skip comment or empty lines */
-		if ((len == 0) || dump[0] == '#')
-			continue;
+	fp = fw_script_open(fname);
+	if (fp == NULL)
+		return -1;
 
+	while ((ret = fw_script_line(fp, dump, sizeof(dump), &lineno)) > 0) {
 		/*
 		 * Search for variable's name,
 		 * remove leading whitespaces
@@ -596,16 +882,7 @@ int fw_parse_script(char *fname)
 		if (!name)
 			continue;
 
-		/* The first white space is the end of variable name */
-		val = fw_string_blank(name, 0);
-		len = strlen(name);
-		if (val) {
-			*val++ = '\0';
-			if ((val - name) < len)
-				val = fw_string_blank(val, 1);
-			else
-				val = NULL;
-		}
+		val = fw_script_word(name);
 
 #ifdef DEBUG
 		fprintf(stderr, "Setting %s : %s\n",
@@ -627,7 +904,7 @@ int fw_parse_script(char *fname)
 	}
 
 	/* Close file if not stdin */
-	if (strcmp(fname, "-") != 0)
+	if (fp != stdin)
 		fclose(fp);
 
 	ret |= fw_env_close();
@@ -636,6 +913,91 @@ int fw_parse_script(char *fname)
 
 }
 
+/*
+ * Run a batch of commands against one read of the environment, writing
+ * it back once at the end:
+ *
+ *	get [variable_name ...]	- print "name=value", all without names
+ *	set variable_name [variable_value]
+ *				- set the variable, delete it if no value
+ *
+ * Lines are split like in fw_parse_script().  Nothing is written if a
+ * line cannot be parsed or a variable cannot be set.  A variable that is
+ * not defined is reported but does not stop the batch.
+ *
+ * Returns:
+ * 0	  - OK
+ * -1     - Error
+ */
+int fw_parse_batch(char *fname)
+{
+	FILE *fp;
+	char dump[1024];	/* Maximum line length in the file */
+	char *cmd, *name, *val;
+	int lineno = 0;
+	int ret = 0;
+	int rc;
+
+	if (fw_env_open()) {
+		fprintf(stderr, "Error: environment not initialized\n");
+		return -1;
+	}
+
+	fp = fw_script_open(fname);
+	if (fp == NULL)
+		return -1;
+
+	while ((rc = fw_script_line(fp, dump, sizeof(dump), &lineno)) > 0) {
+		cmd = fw_string_blank(dump, 1);
+		if (!cmd)
+			continue;
+
+		val = fw_script_word(cmd);
+
+		if (strcmp(cmd, "get") == 0) {
+			char *argv[2] = { cmd, NULL };
+
+			if (!val) {
+				if (fw_printenv(1, argv))
+					ret = -1;
+				continue;
+			}
+			while (val) {
+				name = val;
+				val = fw_script_word(name);
+				argv[1] = name;
+				if (fw_printenv(2, argv))
+					ret = -1;
+			}
+		} else if (strcmp(cmd, "set") == 0 && val) {
+			name = val;
+			val = fw_script_word(name);
+			if (fw_env_write(name, val)) {
+				fprintf(stderr, "Line %d: cannot set %s: %s\n",
+					lineno, name, strerror(errno));
+				rc = -1;
+				break;
+			}
+		} else {
+			fprintf(stderr, "Line %d: unknown command \"%s\"\n",
+				lineno, cmd);
+			rc = -1;
+			break;
+		}
+	}
+
+	/* Close file if not stdin */
+	if (fp != stdin)
+		fclose(fp);
+
+	if (rc < 0) {
+		fprintf(stderr, "Error: environment not written\n");
+		return -1;
+	}
+
+	return fw_env_close() | ret;
+}
+
 /*
  * Test for bad block on NAND, just returns 0 on NOR, on NAND:
  * 0	- block is good
@@ -926,6 +1288,111 @@ static int flash_flag_obsolete (int dev, int fd, off_t offset)
 	return rc;
 }
 
+/*
+ * Append the variables changed since the environment was read as a log
+ * record, programming erased NOR flash without an erase cycle.  Returns
+ * 0 if the record was written or nothing changed, -1 if the environment
+ * has to be rewritten instead.
+ */
+static int flash_log_append (void)
+{
+	struct erase_info_user erase;
+	struct env_log_rec *rec;
+	struct env_var *v;
+	char *p, *end;
+	off_t offset;
+	long avail;
+	int fd, rc;
+
+	if (!env_log_tail || env_log_dirty || HaveRedundEnv ||
+	    DEVTYPE (dev_current) != MTD_NORFLASH)
+		return -1;
+
+	avail = (long)ENV_SIZE - (long)env_log_tail - (long)sizeof (*rec);
+	if (avail <= 0)
+		return -1;
+
+	rec = malloc (sizeof (*rec) + avail);
+	if (!rec)
+		return -1;
+	p = (char *)(rec + 1);
+	end = p + avail;
+
+	for (v = env_list; v; v = v->next) {
+		size_t len = strlen (v->name) + 1;
+
+		if (!env_changed (v))
+			continue;
+		if (v->value)
+			len += strlen (v->value) + 1;
+		if (p + len > end) {
+			free (rec);
+			return -1;
+		}
+		if (v->value)
+			sprintf (p, "%s=%s", v->name, v->value);
+		else
+			strcpy (p, v->name);
+		p += len;
+	}
+
+	rec->len = p - (char *)(rec + 1);
+	if (!rec->len) {
+		free (rec);
+		return 0;
+	}
+	rec->crc = crc32 (0, (const uint8_t *)&rec->len,
+			  sizeof (rec->len) + rec->len);
+
+	fd = open (DEVNAME (dev_current), O_RDWR);
+	if (fd < 0) {
+		fprintf (stderr, "Can't open %s: %s\n",
+			 DEVNAME (dev_current), strerror (errno));
+		free (rec);
+		return -1;
+	}
+
+	erase.start = (DEVOFFSET (dev_current) / DEVESIZE (dev_current)) *
+		      DEVESIZE (dev_current);
+	erase.length = ((DEVOFFSET (dev_current) + CONFIG_ENV_SIZE -
+			 erase.start + DEVESIZE (dev_current) - 1) /
+			DEVESIZE (dev_current)) * DEVESIZE (dev_current);
+	ioctl (fd, MEMUNLOCK, &erase);
+
+	/* The header goes last so a torn append reads as the end of log */
+	offset = DEVOFFSET (dev_current) +
+		 offsetof (struct env_image_single, data) + env_log_tail;
+	rc = -1;
+	if (lseek (fd, offset + sizeof (*rec), SEEK_SET) != -1 &&
+	    write (fd, rec + 1, rec->len) == rec->len &&
+	    lseek (fd, offset, SEEK_SET) != -1 &&
+	    write (fd, rec, sizeof (*rec)) == sizeof (*rec))
+		rc = 0;
+	else
+		fprintf (stderr, "Append error on %s: %s\n",
+			 DEVNAME (dev_current), strerror (errno));
+
+	ioctl (fd, MEMLOCK, &erase);
+	if (close (fd)) {
+		fprintf (stderr, "I/O error on %s: %s\n",
+			 DEVNAME (dev_current), strerror (errno));
+		rc = -1;
+	}
+
+	if (rc) {
+		/* Fall back to rewriting the whole environment */
+		env_log_dirty = 1;
+	} else {
+#ifdef DEBUG
+		fprintf (stderr, "Appended 0x%x bytes at 0x%llx\n",
+			 rec->len, (unsigned long long)offset);
+#endif
+		env_log_tail += ENV_LOG_PAD (sizeof (*rec) + rec->len);
+	}
+	free (rec);
+	return rc;
+}
+
 static int flash_write (int fd_current, int fd_target, int dev_target)
 {
 	int rc;
@@ -1053,23 +1520,6 @@ exit:
 	return rc;
 }
 
-/*
- * s1 is either a simple 'name', or a 'name=value' pair.
- * s2 is a 'name=value' pair.
- * If the names match, return the value of s2, else NULL.
- */
-
-static char *envmatch (char * s1, char * s2)
-{
-
-	while (*s1 == *s2++)
-		if (*s1++ == '=')
-			return s2;
-	if (*s1 == '\0' && *(s2 - 1) == '=')
-		return s2;
-	return NULL;
-}
-
 /*
  * Prevent confusion if running from erased flash memory
  */
@@ -1085,6 +1535,11 @@ int fw_env_open(void)
 
 	struct env_image_single *single;
 	struct env_image_redundant *redundant;
+	int valid = 1;
+	ulong log_off = 0;
+
+	if (env_opened)
+		return 0;
 
 	if (parse_config ())		/* should fill envdevices */
 		return -1;
@@ -1119,10 +1574,13 @@ int fw_env_open(void)
 	crc0 = crc32 (0, (uint8_t *) environment.data, ENV_SIZE);
 	crc0_ok = (crc0 == *environment.crc);
 	if (!HaveRedundEnv) {
-		if (!crc0_ok) {
+		/* Appends to the log leave the CRC of the whole area stale */
+		log_off = env_log_base (environment.data);
+		if (!crc0_ok && !log_off) {
 			fprintf (stderr,
 				"Warning: Bad CRC, using default environment\n");
 			memcpy(environment.data, default_environment, sizeof default_environment);
+			valid = 0;
 		}
 	} else {
 		flag0 = *environment.flags;
@@ -1173,6 +1631,7 @@ int fw_env_open(void)
 				"Warning: Bad CRC, using default environment\n");
 			memcpy (environment.data, default_environment,
 				sizeof default_environment);
+			valid = 0;
 			dev_current = 0;
 		} else {
 			switch (environment.flag_scheme) {
@@ -1226,6 +1685,16 @@ int fw_env_open(void)
 			free (addr1);
 		}
 	}
+
+	if (env_import (environment.data, ENV_SIZE))
+		return -1;
+	if (log_off && env_log_replay (environment.data, log_off))
+		return -1;
+	/* The default environment is not in flash yet */
+	if (valid && env_saved ())
+		return -1;
+
+	env_opened = 1;
 	return 0;
 }
 
@@ -53,6 +53,7 @@ extern int   fw_printenv(int argc, char *argv[]);
 extern char *fw_getenv  (char *name);
 extern int fw_setenv  (int argc, char *argv[]);
 extern int fw_parse_script(char *fname);
+extern int fw_parse_batch(char *fname);
 extern int fw_env_open(void);
 extern int fw_env_write(char *name, char *value);
 extern int fw_env_close(void);
@@ -37,6 +37,9 @@
  *		  separated by single blank characters, and the
  *		  resulting string is assigned to the environment
  *		  variable "name"
+ *	fw_setenv -b file
+ *		- runs the "get" and "set" commands in file against a
+ *		  single read and write of the environment
  */
 
 #include <stdio.h>
@@ -50,6 +53,7 @@
 
 static struct option long_options[] = {
 	{"script", required_argument, NULL, 's'},
+	{"batch", required_argument, NULL, 'b'},
 	{"help", no_argument, NULL, 'h'},
 	{NULL, 0, NULL, 0}
 };
@@ -62,7 +66,8 @@ void usage(void)
 		"usage:\tfw_printenv [-n] [variable name]\n"
 		"\tfw_setenv [variable name] [variable value]\n"
 		"\tfw_setenv -s [ file ]\n"
-		"\tfw_setenv -s - < [ file ]\n\n"
+		"\tfw_setenv -s - < [ file ]\n"
+		"\tfw_setenv -b [ file ]\n\n"
 		"The file passed as argument contains only pairs "
 		"name / value\n"
 		"Example:\n"
@@ -78,6 +83,17 @@ void usage(void)
 		"to put any number of spaces between the fields, but any\n"
 		"space inside the value is treated as part of the value "
 		"itself.\n\n"
+		"With -b each line of the file is a command, run against a\n"
+		"single read of the environment which is written back once\n"
+		"at the end:\n"
+		"\n"
+		"\t      get     netdev kernel_addr\n"
+		"\t      set     netdev eth1\n"
+		"\t      set     var1\n"
+		"\n"
+		"\"get\" prints \"name=value\" (all variables without names),\n"
+		"\"set\" without a value deletes the variable.  Nothing is\n"
+		"written if a line fails.\n\n"
 	);
 }
 
@@ -87,13 +103,14 @@ main(int argc, char *argv[])
 	char *p;
 	char *cmdname = *argv;
 	char *script_file = NULL;
+	char *batch_file = NULL;
 	int c;
 
 	if ((p = strrchr (cmdname, '/')) != NULL) {
 		cmdname = p + 1;
 	}
 
-	while ((c = getopt_long (argc, argv, "ns:h",
+	while ((c = getopt_long (argc, argv, "ns:b:h",
 		long_options, NULL)) != EOF) {
 		switch (c) {
 		case 'n':
@@ -102,6 +119,9 @@ main(int argc, char *argv[])
 		case 's':
 			script_file = optarg;
 			break;
+		case 'b':
+			batch_file = optarg;
+			break;
 		case 'h':
 			usage();
 			return EXIT_SUCCESS;
@@ -115,13 +135,19 @@ main(int argc, char *argv[])
 
 	if (strcmp(cmdname, CMD_PRINTENV) == 0) {
 
-		if (fw_printenv (argc, argv) != 0)
+		if (batch_file) {
+			if (fw_parse_batch(batch_file) != 0)
+				return EXIT_FAILURE;
+		} else if (fw_printenv (argc, argv) != 0)
 			return EXIT_FAILURE;
 
 		return EXIT_SUCCESS;
 
 	} else if (strcmp(cmdname, CMD_SETENV) == 0) {
-		if (!script_file) {
+		if (batch_file) {
+			if (fw_parse_batch(batch_file) != 0)
+				return EXIT_FAILURE;
+		} else if (!script_file) {
 			if (fw_setenv(argc, argv) != 0)
 				return EXIT_FAILURE;
 		} else {
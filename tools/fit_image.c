@@ -30,6 +30,9 @@
 #include "mkimage.h"
 #include <image.h>
 #include <u-boot/crc.h>
+#ifndef __MINGW32__
+#include <pthread.h>
+#endif
 
 static image_header_t header;
 
@@ -47,6 +50,238 @@ static int fit_check_image_types (uint8_t type)
 		return EXIT_FAILURE;
 }
 
+/*
+ * Hashes are computed in two walks over the hash nodes of the component
+ * images: the first collects a job per node, which is hashed by a pool
+ * of threads, and the second stores the values.  Nothing is written to
+ * the blob until all hashes are done, as fdt_setprop() may move the
+ * image data they are taken over.
+ */
+struct fit_hash_job {
+	const void	*data;
+	size_t		size;
+	char		*algo;
+	int		image_noffset;
+	int		noffset;
+	uint8_t		value[FIT_MAX_HASH_LEN];
+	int		value_len;
+	int		ret;
+};
+
+struct fit_hash_jobs {
+	struct fit_hash_job	*job;
+	struct fit_hash_job	**order;	/* largest image first */
+	int			count;
+	int			next;
+#ifndef __MINGW32__
+	pthread_mutex_t		lock;
+#endif
+};
+
+typedef int (*fit_hash_fn) (void *fit, int image_noffset, int noffset,
+			    struct fit_hash_jobs *jobs);
+
+/* Call fn for each hash node of each component image, in blob order */
+static int fit_for_each_hash (void *fit, fit_hash_fn fn,
+			      struct fit_hash_jobs *jobs)
+{
+	int images_noffset, image_noffset, noffset;
+	int idepth, ndepth;
+	int ret;
+
+	images_noffset = fdt_path_offset (fit, FIT_IMAGES_PATH);
+	if (images_noffset < 0) {
+		printf ("Can't find images parent node '%s' (%s)\n",
+			FIT_IMAGES_PATH, fdt_strerror (images_noffset));
+		return images_noffset;
+	}
+
+	for (idepth = 0,
+	     image_noffset = fdt_next_node (fit, images_noffset, &idepth);
+	     (image_noffset >= 0) && (idepth > 0);
+	     image_noffset = fdt_next_node (fit, image_noffset, &idepth)) {
+		if (idepth != 1)
+			continue;
+
+		for (ndepth = 0,
+		     noffset = fdt_next_node (fit, image_noffset, &ndepth);
+		     (noffset >= 0) && (ndepth > 0);
+		     noffset = fdt_next_node (fit, noffset, &ndepth)) {
+			if (ndepth != 1 ||
+			    strncmp (fit_get_name (fit, noffset, NULL),
+				     FIT_HASH_NODENAME,
+				     strlen (FIT_HASH_NODENAME)) != 0)
+				continue;
+
+			ret = fn (fit, image_noffset, noffset, jobs);
+			if (ret)
+				return ret;
+		}
+	}
+
+	return 0;
+}
+
+static int fit_hash_collect (void *fit, int image_noffset, int noffset,
+			     struct fit_hash_jobs *jobs)
+{
+	struct fit_hash_job *job;
+
+	job = realloc (jobs->job, (jobs->count + 1) * sizeof (*job));
+	if (!job) {
+		printf ("Can't allocate hash job\n");
+		return -1;
+	}
+	jobs->job = job;
+	job += jobs->count;
+	memset (job, 0, sizeof (*job));
+	job->image_noffset = image_noffset;
+	job->noffset = noffset;
+
+	if (fit_image_get_data (fit, image_noffset, &job->data, &job->size)) {
+		printf ("Can't get image data/size\n");
+		return -1;
+	}
+
+	if (fit_image_hash_get_algo (fit, noffset, &job->algo)) {
+		printf ("Can't get hash algo property for "
+			"'%s' hash node in '%s' image node\n",
+			fit_get_name (fit, noffset, NULL),
+			fit_get_name (fit, image_noffset, NULL));
+		return -1;
+	}
+
+	jobs->count++;
+	return 0;
+}
+
+static int fit_hash_store (void *fit, int image_noffset, int noffset,
+			   struct fit_hash_jobs *jobs)
+{
+	struct fit_hash_job *job = &jobs->job[jobs->next++];
+
+	if (fit_image_hash_set_value (fit, noffset, job->value,
+				      job->value_len)) {
+		printf ("Can't set hash value for "
+			"'%s' hash node in '%s' image node\n",
+			fit_get_name (fit, noffset, NULL),
+			fit_get_name (fit, image_noffset, NULL));
+		return -1;
+	}
+
+	return 0;
+}
+
+static int fit_hash_cmp (const void *a, const void *b)
+{
+	const struct fit_hash_job *ja = *(struct fit_hash_job * const *)a;
+	const struct fit_hash_job *jb = *(struct fit_hash_job * const *)b;
+
+	return (ja->size < jb->size) - (ja->size > jb->size);
+}
+
+static void *fit_hash_worker (void *arg)
+{
+	struct fit_hash_jobs *jobs = arg;
+	struct fit_hash_job *job;
+
+	for (;;) {
+#ifndef __MINGW32__
+		pthread_mutex_lock (&jobs->lock);
+#endif
+		job = jobs->next < jobs->count ? jobs->order[jobs->next++] : NULL;
+#ifndef __MINGW32__
+		pthread_mutex_unlock (&jobs->lock);
+#endif
+		if (!job)
+			return NULL;
+
+		job->ret = calculate_hash (job->data, job->size, job->algo,
+					   job->value, &job->value_len);
+	}
+}
+
+/**
+ * fit_hash_images - calculate and set the hashes of all component images
+ * @fit: pointer to the FIT blob
+ * @nthreads: number of threads to hash with, 0 for one per online CPU
+ *
+ * Does the same as fit_set_hashes(), but hashes the images in parallel.
+ *
+ * returns:
+ *     0, on success
+ *    <0, on failure
+ */
+static int fit_hash_images (void *fit, int nthreads)
+{
+	struct fit_hash_jobs jobs;
+	struct fit_hash_job *job;
+	int ret, i;
+
+	memset (&jobs, 0, sizeof (jobs));
+	ret = fit_for_each_hash (fit, fit_hash_collect, &jobs);
+	if (ret || !jobs.count)
+		goto out;
+
+	ret = -1;
+	jobs.order = malloc (jobs.count * sizeof (*jobs.order));
+	if (!jobs.order) {
+		printf ("Can't allocate hash jobs\n");
+		goto out;
+	}
+	for (i = 0; i < jobs.count; i++)
+		jobs.order[i] = &jobs.job[i];
+	qsort (jobs.order, jobs.count, sizeof (*jobs.order), fit_hash_cmp);
+
+#ifdef __MINGW32__
+	fit_hash_worker (&jobs);
+#else
+	if (nthreads <= 0)
+		nthreads = sysconf (_SC_NPROCESSORS_ONLN);
+	if (nthreads > jobs.count)
+		nthreads = jobs.count;
+
+	pthread_mutex_init (&jobs.lock, NULL);
+	if (nthreads > 1) {
+		pthread_t *tid;
+		int started = 0;
+
+		tid = malloc ((nthreads - 1) * sizeof (*tid));
+		/* Run the jobs with whatever threads could be started */
+		while (tid && started < nthreads - 1 &&
+		       !pthread_create (&tid[started], NULL, fit_hash_worker,
+					&jobs))
+			started++;
+		fit_hash_worker (&jobs);
+		for (i = 0; i < started; i++)
+			pthread_join (tid[i], NULL);
+		free (tid);
+	} else {
+		fit_hash_worker (&jobs);
+	}
+	pthread_mutex_destroy (&jobs.lock);
+#endif
+	debug ("Hashed %d nodes with %d threads\n", jobs.count, nthreads);
+
+	for (i = 0, job = jobs.job; i < jobs.count; i++, job++) {
+		if (job->ret) {
+			printf ("Unsupported hash algorithm (%s) for "
+				"'%s' hash node in '%s' image node\n",
+				job->algo, fit_get_name (fit, job->noffset, NULL),
+				fit_get_name (fit, job->image_noffset, NULL));
+			goto out;
+		}
+	}
+
+	jobs.next = 0;
+	ret = fit_for_each_hash (fit, fit_hash_store, &jobs);
+
+out:
+	free (jobs.order);
+	free (jobs.job);
+	return ret;
+}
+
 /**
  * fit_handle_file - main FIT file processing function
  *
@@ -125,7 +360,7 @@ static int fit_handle_file (struct mkimage_params *params)
 	}
 
 	/* set hashes for images in the blob */
-	if (fit_set_hashes (ptr)) {
+	if (fit_hash_images (ptr, params->jobs)) {
 		fprintf (stderr, "%s Can't add hashes to FIT blob",
 				params->cmdname);
 		unlink (tmpfile);
@@ -0,0 +1,253 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Build the node offset index that is linked next to an Octeon board's
+ * device tree, see arch/mips/include/asm/arch-octeon/octeon_fdt_index.h.
+ *
+ * Usage: mkfdtidx <input.dtb> <output.idx>
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "fdt_host.h"
+#include "../arch/mips/include/asm/arch-octeon/octeon_fdt_index.h"
+
+struct key {
+	char *key;
+	int node;
+	const char *name;
+};
+
+static struct key *keys;
+static int num_keys, max_keys;
+
+static void add_key(const void *fdt, const char *key, int node)
+{
+	int i;
+
+	for (i = 0; i < num_keys; i++)
+		if (!strcmp(keys[i].key, key))
+			return;
+	if (num_keys == max_keys) {
+		max_keys = max_keys ? max_keys * 2 : 256;
+		keys = realloc(keys, max_keys * sizeof(*keys));
+		if (!keys) {
+			perror("realloc");
+			exit(1);
+		}
+	}
+	keys[num_keys].key = strdup(key);
+	keys[num_keys].node = node;
+	keys[num_keys].name = fdt_get_name(fdt, node, NULL);
+	num_keys++;
+}
+
+static void add_nodes(const void *fdt)
+{
+	char path[1024];
+	uint32_t phandle;
+	int node, depth = 0;
+
+	add_key(fdt, "/", 0);
+	for (node = fdt_next_node(fdt, 0, &depth); node >= 0 && depth > 0;
+	     node = fdt_next_node(fdt, node, &depth)) {
+		if (fdt_get_path(fdt, node, path, sizeof(path)) == 0)
+			add_key(fdt, path, node);
+		phandle = fdt_get_phandle(fdt, node);
+		if (phandle) {
+			snprintf(path, sizeof(path), "&%x", phandle);
+			add_key(fdt, path, node);
+		}
+	}
+}
+
+/* Add "alias" and "alias/sub/path" keys for everything below each alias */
+static void add_aliases(const void *fdt)
+{
+	char path[1024], key[1024];
+	const char *alias, *target;
+	int aliases, prop, node, start, depth, len;
+
+	aliases = fdt_path_offset(fdt, "/aliases");
+	if (aliases < 0)
+		return;
+
+	for (prop = fdt_first_property_offset(fdt, aliases); prop >= 0;
+	     prop = fdt_next_property_offset(fdt, prop)) {
+		target = fdt_getprop_by_offset(fdt, prop, &alias, &len);
+		if (!target || len < 2 || target[0] != '/')
+			continue;
+		start = fdt_path_offset(fdt, target);
+		if (start < 0)
+			continue;
+		add_key(fdt, alias, start);
+
+		len = strlen(target);
+		depth = 0;
+		for (node = fdt_next_node(fdt, start, &depth);
+		     node >= 0 && depth > 0;
+		     node = fdt_next_node(fdt, node, &depth)) {
+			if (fdt_get_path(fdt, node, path, sizeof(path)))
+				continue;
+			snprintf(key, sizeof(key), "%s%s", alias, path + len);
+			add_key(fdt, key, node);
+		}
+	}
+}
+
+/* Node names repeat a lot, so share them in the string table */
+static int find_name(const char *strings, int len, const char *name)
+{
+	int nlen = strlen(name) + 1;
+	int i;
+
+	for (i = 0; i + nlen <= len; i++)
+		if (!memcmp(strings + i, name, nlen) &&
+		    (i == 0 || strings[i - 1] == '\0'))
+			return i;
+	return -1;
+}
+
+static void *read_file(const char *name, int *size)
+{
+	struct stat st;
+	void *buf;
+	int fd;
+
+	fd = open(name, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st) < 0) {
+		fprintf(stderr, "mkfdtidx: can't open %s: %s\n", name,
+			strerror(errno));
+		exit(1);
+	}
+	buf = malloc(st.st_size);
+	if (!buf || read(fd, buf, st.st_size) != st.st_size) {
+		fprintf(stderr, "mkfdtidx: can't read %s\n", name);
+		exit(1);
+	}
+	close(fd);
+	*size = st.st_size;
+	return buf;
+}
+
+int main(int argc, char *argv[])
+{
+	struct octeon_fdt_index_hdr hdr;
+	struct octeon_fdt_index_entry *table;
+	uint32_t num_buckets, mask, hash, b;
+	char *strings;
+	int strings_len = 0;
+	void *fdt;
+	int size, i, ret;
+	FILE *out;
+
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s <input.dtb> <output.idx>\n",
+			argv[0]);
+		return 1;
+	}
+
+	fdt = read_file(argv[1], &size);
+	ret = fdt_check_header(fdt);
+	if (ret) {
+		fprintf(stderr, "mkfdtidx: %s: %s\n", argv[1],
+			fdt_strerror(ret));
+		return 1;
+	}
+
+	add_nodes(fdt);
+	add_aliases(fdt);
+
+	num_buckets = 1;
+	while (num_buckets < num_keys + num_keys / 2)
+		num_buckets <<= 1;
+	mask = num_buckets - 1;
+
+	table = malloc(num_buckets * sizeof(*table));
+	strings = malloc(1);
+	if (!table || !strings) {
+		perror("malloc");
+		return 1;
+	}
+	for (b = 0; b < num_buckets; b++)
+		table[b].node = cpu_to_fdt32(-1);
+
+	for (i = 0; i < num_keys; i++) {
+		int klen = strlen(keys[i].key) + 1;
+		int nlen = strlen(keys[i].name) + 1;
+		int name_off;
+
+		strings = realloc(strings, strings_len + klen + nlen);
+		if (!strings) {
+			perror("realloc");
+			return 1;
+		}
+		hash = octeon_fdt_index_hash(keys[i].key);
+		for (b = hash & mask; fdt32_to_cpu(table[b].node) != -1;
+		     b = (b + 1) & mask)
+			;
+		table[b].hash = cpu_to_fdt32(hash);
+		table[b].node = cpu_to_fdt32(keys[i].node);
+		table[b].key = cpu_to_fdt32(strings_len);
+		memcpy(strings + strings_len, keys[i].key, klen);
+		strings_len += klen;
+		/* Path keys end in the node name */
+		if (klen > nlen && keys[i].key[klen - nlen - 1] == '/' &&
+		    !strcmp(keys[i].key + klen - nlen, keys[i].name))
+			name_off = strings_len - nlen;
+		else
+			name_off = find_name(strings, strings_len,
+					     keys[i].name);
+		if (name_off < 0) {
+			name_off = strings_len;
+			memcpy(strings + strings_len, keys[i].name, nlen);
+			strings_len += nlen;
+		}
+		table[b].name = cpu_to_fdt32(name_off);
+	}
+
+	hdr.magic = cpu_to_fdt32(OCTEON_FDT_INDEX_MAGIC);
+	hdr.version = cpu_to_fdt32(OCTEON_FDT_INDEX_VERSION);
+	hdr.size_dt_struct = cpu_to_fdt32(fdt_size_dt_struct(fdt));
+	hdr.num_buckets = cpu_to_fdt32(num_buckets);
+	hdr.num_entries = cpu_to_fdt32(num_keys);
+	hdr.strings_off = cpu_to_fdt32(sizeof(hdr) +
+				       num_buckets * sizeof(*table));
+
+	out = fopen(argv[2], "wb");
+	if (!out ||
+	    fwrite(&hdr, sizeof(hdr), 1, out) != 1 ||
+	    fwrite(table, sizeof(*table), num_buckets, out) != num_buckets ||
+	    fwrite(strings, 1, strings_len, out) != strings_len ||
+	    fclose(out)) {
+		fprintf(stderr, "mkfdtidx: can't write %s: %s\n", argv[2],
+			strerror(errno));
+		unlink(argv[2]);
+		return 1;
+	}
+	return 0;
+}
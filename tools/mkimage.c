@@ -216,6 +216,17 @@ main (int argc, char **argv)
 					exit (EXIT_FAILURE);
 				}
 				goto NXTARG;
+			case 'j':
+				if (--argc <= 0)
+					usage ();
+				params.jobs = strtoul (*++argv, &ptr, 0);
+				if (*ptr || params.jobs < 1) {
+					fprintf (stderr,
+						"%s: invalid number of jobs %s\n",
+						params.cmdname, *argv);
+					exit (EXIT_FAILURE);
+				}
+				goto NXTARG;
 			case 'd':
 				if (--argc <= 0)
 					usage ();
@@ -608,7 +619,8 @@ usage ()
 			 "          -d ==> use image data from 'datafile'\n"
 			 "          -x ==> set XIP (execute in place)\n",
 		params.cmdname);
-	fprintf (stderr, "       %s [-D dtc_options] -f fit-image.its fit-image\n",
+	fprintf (stderr, "       %s [-D dtc_options] [-j jobs] -f fit-image.its fit-image\n"
+			 "          -j ==> hash images with 'jobs' threads (default: one per CPU)\n",
 		params.cmdname);
 	fprintf (stderr, "       %s -V ==> print version information and exit\n",
 		params.cmdname);
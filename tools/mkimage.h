@@ -65,6 +65,7 @@ struct mkimage_params {
 	int arch;
 	int type;
 	int comp;
+	int jobs;
 	char *dtc;
 	unsigned int addr;
 	unsigned int ep;
@@ -0,0 +1,529 @@
+/*
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Host side of the U-Boot "pcibulk" command.
+ *
+ * Pushes a file into the "__pci_bulk" PCI console ring of an Octeon that
+ * is running "pcibulk recv".  The ring is located through the bootmem
+ * descriptor, so nothing but PCI memory access is needed.  Building with
+ * OCTEON_REMOTE_LIB set links against the Octeon SDK remote access
+ * library; without it only the --simulate mode, which runs both ends of
+ * the protocol over shared memory on the host, is available.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <arpa/inet.h>
+
+#ifdef OCTEON_REMOTE_LIB
+#include <octeon-remote.h>
+#endif
+
+#include <u-boot/crc.h>
+
+#define BULK_BLOCK_NAME		"__pci_bulk"
+#define BULK_MAGIC		0x4f42554c
+#define BULK_VERSION		1
+#define BULK_HDR_SIZE		24
+
+/* Where the bootloader publishes the bootmem descriptor address */
+#define BOOTMEM_DESC_PTR	0x48100ull
+
+/* cvmx_bootmem_desc_t, big-endian layout */
+#define BOOTMEM_NUM_BLOCKS	40
+#define BOOTMEM_NAME_LEN	44
+#define BOOTMEM_ARRAY_ADDR	48
+/* cvmx_bootmem_named_block_desc_t */
+#define NAMED_BASE		0
+#define NAMED_SIZE		8
+#define NAMED_NAME		16
+/* octeon_pci_console_desc_t */
+#define CDESC_NUM_CONSOLES	16
+#define CDESC_ADDR_ARRAY	24
+/* octeon_pci_console_t */
+#define CON_INPUT_BASE		0
+#define CON_INPUT_RD		8
+#define CON_INPUT_WR		12
+#define CON_BUF_SIZE		36
+
+/* Octeon memory access; 32 and 64 bit accessors return host order */
+struct bulk_ops {
+	uint32_t (*read32)(uint64_t addr);
+	uint64_t (*read64)(uint64_t addr);
+	void (*write32)(uint64_t addr, uint32_t val);
+	void (*read_mem)(void *buf, uint64_t addr, int len);
+	void (*write_mem)(uint64_t addr, const void *buf, int len);
+};
+
+static const struct bulk_ops *ops;
+static int verbose;
+
+static uint64_t get_be64(const void *p)
+{
+	const uint32_t *w = p;
+
+	return ((uint64_t)ntohl(w[0]) << 32) | ntohl(w[1]);
+}
+
+static void put_be64(void *p, uint64_t v)
+{
+	uint32_t *w = p;
+
+	w[0] = htonl(v >> 32);
+	w[1] = htonl(v);
+}
+
+static double now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+#ifdef OCTEON_REMOTE_LIB
+static uint32_t remote_read32(uint64_t addr)
+{
+	return octeon_remote_read_mem32(addr);
+}
+
+static uint64_t remote_read64(uint64_t addr)
+{
+	return octeon_remote_read_mem64(addr);
+}
+
+static void remote_write32(uint64_t addr, uint32_t val)
+{
+	octeon_remote_write_mem32(addr, val);
+}
+
+static void remote_read_mem(void *buf, uint64_t addr, int len)
+{
+	octeon_remote_read_mem(buf, addr, len);
+}
+
+static void remote_write_mem(uint64_t addr, const void *buf, int len)
+{
+	octeon_remote_write_mem(addr, buf, len);
+}
+
+static const struct bulk_ops remote_ops = {
+	remote_read32, remote_read64, remote_write32,
+	remote_read_mem, remote_write_mem,
+};
+#endif
+
+/*
+ * Simulation: a shared mapping stands in for Octeon DRAM and a child
+ * process plays the part of U-Boot's "pcibulk recv".
+ */
+#define SIM_MEM_SIZE		0x100000
+#define SIM_BOOTMEM_DESC	0x1000
+#define SIM_NAMED_ARRAY		0x2000
+#define SIM_NAME_LEN		64
+#define SIM_CONSOLE_DESC	0x10000
+#define SIM_CONSOLE		0x10100
+#define SIM_RING		0x20000
+#define SIM_RING_SIZE		(64 * 1024 + 17)	/* odd size to test wrap */
+
+static volatile uint8_t *sim_mem;
+
+static uint32_t sim_read32(uint64_t addr)
+{
+	__sync_synchronize();
+	return ntohl(*(volatile uint32_t *)(sim_mem + addr));
+}
+
+static uint64_t sim_read64(uint64_t addr)
+{
+	__sync_synchronize();
+	return get_be64((const void *)(sim_mem + addr));
+}
+
+static void sim_write32(uint64_t addr, uint32_t val)
+{
+	__sync_synchronize();
+	*(volatile uint32_t *)(sim_mem + addr) = htonl(val);
+	__sync_synchronize();
+}
+
+static void sim_read_mem(void *buf, uint64_t addr, int len)
+{
+	__sync_synchronize();
+	memcpy(buf, (const void *)(sim_mem + addr), len);
+}
+
+static void sim_write_mem(uint64_t addr, const void *buf, int len)
+{
+	memcpy((void *)(sim_mem + addr), buf, len);
+	__sync_synchronize();
+}
+
+static const struct bulk_ops sim_ops = {
+	sim_read32, sim_read64, sim_write32, sim_read_mem, sim_write_mem,
+};
+
+/* Same arithmetic as octeon_pci_console_buffer_free_bytes() */
+static int ring_free(uint32_t size, uint32_t wr, uint32_t rd)
+{
+	if (rd >= size || wr >= size)
+		return -1;
+	return ((size - 1) - (wr - rd)) % size;
+}
+
+static void sim_setup(void)
+{
+	uint8_t *m = (uint8_t *)sim_mem;
+
+	put_be64(m + BOOTMEM_DESC_PTR, SIM_BOOTMEM_DESC);
+	*(uint32_t *)(m + SIM_BOOTMEM_DESC + BOOTMEM_NUM_BLOCKS) = htonl(4);
+	*(uint32_t *)(m + SIM_BOOTMEM_DESC + BOOTMEM_NAME_LEN) =
+		htonl(SIM_NAME_LEN);
+	put_be64(m + SIM_BOOTMEM_DESC + BOOTMEM_ARRAY_ADDR, SIM_NAMED_ARRAY);
+
+	/* A decoy block first so the lookup has to skip something */
+	put_be64(m + SIM_NAMED_ARRAY + NAMED_BASE, 0x80000);
+	put_be64(m + SIM_NAMED_ARRAY + NAMED_SIZE, 0x1000);
+	strcpy((char *)m + SIM_NAMED_ARRAY + NAMED_NAME, "__pci_console");
+
+	put_be64(m + SIM_NAMED_ARRAY + 16 + SIM_NAME_LEN + NAMED_BASE,
+		 SIM_CONSOLE_DESC);
+	put_be64(m + SIM_NAMED_ARRAY + 16 + SIM_NAME_LEN + NAMED_SIZE,
+		 SIM_RING + SIM_RING_SIZE - SIM_CONSOLE_DESC);
+	strcpy((char *)m + SIM_NAMED_ARRAY + 16 + SIM_NAME_LEN + NAMED_NAME,
+	       BULK_BLOCK_NAME);
+
+	*(uint32_t *)(m + SIM_CONSOLE_DESC + CDESC_NUM_CONSOLES) = htonl(1);
+	put_be64(m + SIM_CONSOLE_DESC + CDESC_ADDR_ARRAY, SIM_CONSOLE);
+	put_be64(m + SIM_CONSOLE + CON_INPUT_BASE, SIM_RING);
+	*(uint32_t *)(m + SIM_CONSOLE + CON_BUF_SIZE) = htonl(SIM_RING_SIZE);
+	__sync_synchronize();
+}
+
+/* Read like octeon_pci_console_read(): one contiguous piece at a time */
+static int sim_target_read(uint8_t *buf, uint64_t len)
+{
+	double last = now();
+	uint32_t rd, wr;
+	int n;
+
+	while (len) {
+		rd = sim_read32(SIM_CONSOLE + CON_INPUT_RD);
+		wr = sim_read32(SIM_CONSOLE + CON_INPUT_WR);
+		n = SIM_RING_SIZE - 1 - ring_free(SIM_RING_SIZE, wr, rd);
+		if (n <= 0) {
+			if (now() - last > 10.0)
+				return -1;
+			continue;
+		}
+		if (n > len)
+			n = len;
+		if (rd + n >= SIM_RING_SIZE)
+			n = SIM_RING_SIZE - rd;
+		sim_read_mem(buf, SIM_RING + rd, n);
+		sim_write32(SIM_CONSOLE + CON_INPUT_RD, (rd + n) % SIM_RING_SIZE);
+		buf += n;
+		len -= n;
+		last = now();
+	}
+	return 0;
+}
+
+static int sim_target(void)
+{
+	uint8_t hdr[BULK_HDR_SIZE];
+	uint64_t size;
+	uint8_t *data;
+	uint32_t crc;
+
+	if (sim_target_read(hdr, sizeof(hdr)))
+		return 1;
+	if (ntohl(*(uint32_t *)hdr) != BULK_MAGIC ||
+	    ntohl(*(uint32_t *)(hdr + 4)) != BULK_VERSION) {
+		fprintf(stderr, "target: bad header\n");
+		return 1;
+	}
+	size = get_be64(hdr + 8);
+	data = malloc(size);
+	if (!data || sim_target_read(data, size)) {
+		fprintf(stderr, "target: short read\n");
+		return 1;
+	}
+	crc = crc32(0, data, size);
+	if (crc != ntohl(*(uint32_t *)(hdr + 16))) {
+		fprintf(stderr, "target: CRC mismatch\n");
+		return 1;
+	}
+	printf("target: received %llu bytes, CRC 0x%08x OK\n",
+	       (unsigned long long)size, crc);
+	return 0;
+}
+
+/* Look up a bootmem named block, returns its base address or 0 */
+static uint64_t find_named_block(uint64_t desc, const char *name)
+{
+	uint32_t num, name_len, i;
+	uint64_t array, entry, base;
+	char buf[256];
+
+	num = ops->read32(desc + BOOTMEM_NUM_BLOCKS);
+	name_len = ops->read32(desc + BOOTMEM_NAME_LEN);
+	array = ops->read64(desc + BOOTMEM_ARRAY_ADDR);
+	if (!array || name_len == 0 || name_len >= sizeof(buf))
+		return 0;
+
+	for (i = 0; i < num; i++) {
+		entry = array + i * (16 + name_len);
+		base = ops->read64(entry + NAMED_BASE);
+		if (!base || !ops->read64(entry + NAMED_SIZE))
+			continue;
+		ops->read_mem(buf, entry + NAMED_NAME, name_len);
+		buf[name_len] = '\0';
+		if (!strcmp(buf, name))
+			return base;
+	}
+	return 0;
+}
+
+/* Copy len bytes into the input ring, waiting for the target to drain it */
+static int ring_write(uint64_t cons, uint64_t ring, uint32_t size,
+		      const uint8_t *buf, uint64_t len, double timeout)
+{
+	double last = now();
+	uint32_t rd, wr;
+	int n;
+
+	while (len) {
+		rd = ops->read32(cons + CON_INPUT_RD);
+		wr = ops->read32(cons + CON_INPUT_WR);
+		n = ring_free(size, wr, rd);
+		if (n < 0) {
+			fprintf(stderr, "Corrupt ring indexes %u/%u\n", rd, wr);
+			return -1;
+		}
+		if (n == 0) {
+			if (now() - last > timeout) {
+				fprintf(stderr, "Target stopped reading\n");
+				return -1;
+			}
+			continue;
+		}
+		if (n > len)
+			n = len;
+		/* Only write what is contiguous */
+		if (wr + n >= size)
+			n = size - wr;
+		ops->write_mem(ring + wr, buf, n);
+		ops->write32(cons + CON_INPUT_WR, (wr + n) % size);
+		buf += n;
+		len -= n;
+		last = now();
+	}
+	return 0;
+}
+
+static int send_file(const uint8_t *data, uint64_t len, uint64_t desc_ptr,
+		     double timeout)
+{
+	uint8_t hdr[BULK_HDR_SIZE];
+	uint64_t desc, block = 0, cons, ring;
+	uint32_t size;
+	double start;
+
+	/* Wait for "pcibulk recv" to create the channel */
+	start = now();
+	desc = ops->read64(desc_ptr);
+	while (desc && !(block = find_named_block(desc, BULK_BLOCK_NAME))) {
+		if (now() - start > timeout)
+			break;
+		usleep(100000);
+	}
+	if (!block) {
+		fprintf(stderr, "No %s block found, run \"pcibulk recv\" on "
+			"the target first\n", BULK_BLOCK_NAME);
+		return -1;
+	}
+	if (ops->read32(block + CDESC_NUM_CONSOLES) < 1)
+		return -1;
+	cons = ops->read64(block + CDESC_ADDR_ARRAY);
+	ring = ops->read64(cons + CON_INPUT_BASE);
+	size = ops->read32(cons + CON_BUF_SIZE);
+	if (verbose)
+		printf("Channel at 0x%llx, ring 0x%llx, %u bytes\n",
+		       (unsigned long long)block, (unsigned long long)ring,
+		       size);
+
+	memset(hdr, 0, sizeof(hdr));
+	*(uint32_t *)hdr = htonl(BULK_MAGIC);
+	*(uint32_t *)(hdr + 4) = htonl(BULK_VERSION);
+	put_be64(hdr + 8, len);
+	*(uint32_t *)(hdr + 16) = htonl(crc32(0, data, len));
+
+	start = now();
+	if (ring_write(cons, ring, size, hdr, sizeof(hdr), timeout) ||
+	    ring_write(cons, ring, size, data, len, timeout))
+		return -1;
+
+	/* Wait for the target to consume the tail */
+	while (ops->read32(cons + CON_INPUT_RD) !=
+	       ops->read32(cons + CON_INPUT_WR)) {
+		if (now() - start > timeout + len / 1000000.0) {
+			fprintf(stderr, "Target did not drain the ring\n");
+			return -1;
+		}
+	}
+	start = now() - start;
+	printf("Sent %llu bytes in %.3f s (%.1f MiB/s)\n",
+	       (unsigned long long)len, start,
+	       start > 0 ? len / start / (1024 * 1024) : 0.0);
+	return 0;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [options] <file>\n"
+		"  -b, --bootmem-ptr=ADDR  address holding the bootmem descriptor"
+		" address\n"
+		"                          (default 0x%llx)\n"
+		"  -t, --timeout=SEC       seconds to wait for the target (10)\n"
+		"  -s, --simulate          run against a simulated target\n"
+		"  -v, --verbose\n", prog, BOOTMEM_DESC_PTR);
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct option long_options[] = {
+		{"bootmem-ptr", required_argument, NULL, 'b'},
+		{"timeout", required_argument, NULL, 't'},
+		{"simulate", no_argument, NULL, 's'},
+		{"verbose", no_argument, NULL, 'v'},
+		{"help", no_argument, NULL, 'h'},
+		{NULL, 0, NULL, 0}
+	};
+	uint64_t desc_ptr = BOOTMEM_DESC_PTR;
+	double timeout = 10.0;
+	int simulate = 0;
+	struct stat st;
+	uint8_t *data;
+	pid_t child = 0;
+	int c, fd, ret, status;
+
+	while ((c = getopt_long(argc, argv, "b:t:svh", long_options,
+				NULL)) != -1) {
+		switch (c) {
+		case 'b':
+			desc_ptr = strtoull(optarg, NULL, 0);
+			break;
+		case 't':
+			timeout = strtod(optarg, NULL);
+			break;
+		case 's':
+			simulate = 1;
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (optind != argc - 1) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	fd = open(argv[optind], O_RDONLY);
+	if (fd < 0 || fstat(fd, &st) < 0) {
+		fprintf(stderr, "Can't open %s: %s\n", argv[optind],
+			strerror(errno));
+		return 1;
+	}
+	data = malloc(st.st_size ? st.st_size : 1);
+	if (!data || read(fd, data, st.st_size) != st.st_size) {
+		fprintf(stderr, "Can't read %s\n", argv[optind]);
+		return 1;
+	}
+	close(fd);
+	if (!st.st_size) {
+		fprintf(stderr, "%s is empty\n", argv[optind]);
+		return 1;
+	}
+
+	if (simulate) {
+		sim_mem = mmap(NULL, SIM_MEM_SIZE, PROT_READ | PROT_WRITE,
+			       MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if (sim_mem == MAP_FAILED) {
+			perror("mmap");
+			return 1;
+		}
+		sim_setup();
+		ops = &sim_ops;
+		desc_ptr = BOOTMEM_DESC_PTR;
+		child = fork();
+		if (child < 0) {
+			perror("fork");
+			return 1;
+		}
+		if (child == 0)
+			exit(sim_target());
+	} else {
+#ifdef OCTEON_REMOTE_LIB
+		if (octeon_remote_open(OCTEON_REMOTE_DEFAULT, 0)) {
+			fprintf(stderr, "Can't open remote Octeon\n");
+			return 1;
+		}
+		ops = &remote_ops;
+#else
+		fprintf(stderr, "Built without OCTEON_REMOTE_LIB, only "
+			"--simulate is available\n");
+		return 1;
+#endif
+	}
+
+	ret = send_file(data, st.st_size, desc_ptr, timeout);
+
+	if (simulate) {
+		if (ret)
+			kill(child, SIGTERM);
+		waitpid(child, &status, 0);
+		if (!WIFEXITED(status) || WEXITSTATUS(status))
+			ret = -1;
+	}
+#ifdef OCTEON_REMOTE_LIB
+	else
+		octeon_remote_close();
+#endif
+	free(data);
+	return ret ? 1 : 0;
+}